@@ -11,6 +11,7 @@
 // [Dependencies]
 #include "./base/arch.h"
 #include "./base/assembler.h"
+#include "./base/bitops.h"
 #include "./base/codebuilder.h"
 #include "./base/codecompiler.h"
 #include "./base/codeemitter.h"
@@ -0,0 +1,383 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Dependencies]
+#include "../base/bitops.h"
+#include "../base/cpuinfo.h"
+#include "../base/utils.h"
+
+#if (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64) && (ASMJIT_CC_GCC || ASMJIT_CC_CLANG || ASMJIT_CC_MSC)
+# define ASMJIT_BITOPS_X86
+# include <immintrin.h>
+#endif
+
+// GCC and Clang require a target attribute to use intrinsics of instruction
+// sets that are not enabled for the whole translation unit, MSC doesn't.
+#if defined(ASMJIT_BITOPS_X86) && (ASMJIT_CC_GCC || ASMJIT_CC_CLANG)
+# define ASMJIT_TARGET_SSE2 __attribute__((target("sse2")))
+# define ASMJIT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+# define ASMJIT_TARGET_SSE2
+# define ASMJIT_TARGET_AVX2
+#endif
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+namespace BitOps {
+
+// ============================================================================
+// [asmjit::BitOps - Scalar]
+// ============================================================================
+
+static bool BitOps_copyScalar(Word* dst, const Word* a, size_t n) {
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+static bool BitOps_orScalar(Word* dst, const Word* a, const Word* b, size_t n) {
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] | b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+static bool BitOps_andScalar(Word* dst, const Word* a, const Word* b, size_t n) {
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] & b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+static bool BitOps_andNotScalar(Word* dst, const Word* a, const Word* b, size_t n) {
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] & ~b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+static bool BitOps_orDelSourceScalar(Word* dst, const Word* a, Word* b, size_t n) {
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word x = a[i];
+    Word y = b[i];
+
+    dst[i] = x | y;
+    y &= ~x;
+
+    b[i] = y;
+    r |= y;
+  }
+  return r != 0;
+}
+
+static const Funcs BitOps_scalarFuncs = {
+  BitOps_copyScalar,
+  BitOps_orScalar,
+  BitOps_andScalar,
+  BitOps_andNotScalar,
+  BitOps_orDelSourceScalar,
+  kImplScalar,
+  "Scalar"
+};
+
+#if defined(ASMJIT_BITOPS_X86)
+
+// ============================================================================
+// [asmjit::BitOps - SSE2]
+// ============================================================================
+
+// Each function processes 16 bytes per iteration and the remaining words
+// by using the scalar implementation. All loads and stores are unaligned as
+// bit arrays are only aligned to `sizeof(Word)`.
+enum { kSSE2Words = 16 / static_cast<int>(sizeof(Word)) };
+
+#define BITOPS_SSE2_BINARY(NAME, OP) \
+  static ASMJIT_TARGET_SSE2 bool BitOps_##NAME##SSE2(Word* dst, const Word* a, const Word* b, size_t n) { \
+    __m128i acc = _mm_setzero_si128(); \
+    size_t i = 0; \
+    \
+    for (; i + kSSE2Words <= n; i += kSSE2Words) { \
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)); \
+      __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)); \
+      __m128i t = OP; \
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), t); \
+      acc = _mm_or_si128(acc, t); \
+    } \
+    \
+    bool r = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF; \
+    return BitOps_##NAME##Scalar(dst + i, a + i, b + i, n - i) | r; \
+  }
+
+BITOPS_SSE2_BINARY(or, _mm_or_si128(x, y))
+BITOPS_SSE2_BINARY(and, _mm_and_si128(x, y))
+BITOPS_SSE2_BINARY(andNot, _mm_andnot_si128(y, x))
+
+#undef BITOPS_SSE2_BINARY
+
+static ASMJIT_TARGET_SSE2 bool BitOps_copySSE2(Word* dst, const Word* a, size_t n) {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + kSSE2Words <= n; i += kSSE2Words) {
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), t);
+    acc = _mm_or_si128(acc, t);
+  }
+
+  bool r = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+  return BitOps_copyScalar(dst + i, a + i, n - i) | r;
+}
+
+static ASMJIT_TARGET_SSE2 bool BitOps_orDelSourceSSE2(Word* dst, const Word* a, Word* b, size_t n) {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + kSSE2Words <= n; i += kSSE2Words) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(x, y));
+    y = _mm_andnot_si128(x, y);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), y);
+    acc = _mm_or_si128(acc, y);
+  }
+
+  bool r = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+  return BitOps_orDelSourceScalar(dst + i, a + i, b + i, n - i) | r;
+}
+
+static const Funcs BitOps_sse2Funcs = {
+  BitOps_copySSE2,
+  BitOps_orSSE2,
+  BitOps_andSSE2,
+  BitOps_andNotSSE2,
+  BitOps_orDelSourceSSE2,
+  kImplSSE2,
+  "SSE2"
+};
+
+// ============================================================================
+// [asmjit::BitOps - AVX2]
+// ============================================================================
+
+enum { kAVX2Words = 32 / static_cast<int>(sizeof(Word)) };
+
+#define BITOPS_AVX2_BINARY(NAME, OP) \
+  static ASMJIT_TARGET_AVX2 bool BitOps_##NAME##AVX2(Word* dst, const Word* a, const Word* b, size_t n) { \
+    __m256i acc = _mm256_setzero_si256(); \
+    size_t i = 0; \
+    \
+    for (; i + kAVX2Words <= n; i += kAVX2Words) { \
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)); \
+      __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)); \
+      __m256i t = OP; \
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), t); \
+      acc = _mm256_or_si256(acc, t); \
+    } \
+    \
+    bool r = !_mm256_testz_si256(acc, acc); \
+    _mm256_zeroupper(); \
+    return BitOps_##NAME##Scalar(dst + i, a + i, b + i, n - i) | r; \
+  }
+
+BITOPS_AVX2_BINARY(or, _mm256_or_si256(x, y))
+BITOPS_AVX2_BINARY(and, _mm256_and_si256(x, y))
+BITOPS_AVX2_BINARY(andNot, _mm256_andnot_si256(y, x))
+
+#undef BITOPS_AVX2_BINARY
+
+static ASMJIT_TARGET_AVX2 bool BitOps_copyAVX2(Word* dst, const Word* a, size_t n) {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kAVX2Words <= n; i += kAVX2Words) {
+    __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), t);
+    acc = _mm256_or_si256(acc, t);
+  }
+
+  bool r = !_mm256_testz_si256(acc, acc);
+  _mm256_zeroupper();
+  return BitOps_copyScalar(dst + i, a + i, n - i) | r;
+}
+
+static ASMJIT_TARGET_AVX2 bool BitOps_orDelSourceAVX2(Word* dst, const Word* a, Word* b, size_t n) {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kAVX2Words <= n; i += kAVX2Words) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(x, y));
+    y = _mm256_andnot_si256(x, y);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + i), y);
+    acc = _mm256_or_si256(acc, y);
+  }
+
+  bool r = !_mm256_testz_si256(acc, acc);
+  _mm256_zeroupper();
+  return BitOps_orDelSourceScalar(dst + i, a + i, b + i, n - i) | r;
+}
+
+static const Funcs BitOps_avx2Funcs = {
+  BitOps_copyAVX2,
+  BitOps_orAVX2,
+  BitOps_andAVX2,
+  BitOps_andNotAVX2,
+  BitOps_orDelSourceAVX2,
+  kImplAVX2,
+  "AVX2"
+};
+
+#endif // ASMJIT_BITOPS_X86
+
+// ============================================================================
+// [asmjit::BitOps - Dispatch]
+// ============================================================================
+
+const Funcs* getFuncs(uint32_t impl) noexcept {
+  switch (impl) {
+    case kImplScalar:
+      return &BitOps_scalarFuncs;
+
+#if defined(ASMJIT_BITOPS_X86)
+    case kImplSSE2:
+      if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureSSE2))
+        return &BitOps_sse2Funcs;
+      break;
+
+    case kImplAVX2:
+      if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX2))
+        return &BitOps_avx2Funcs;
+      break;
+#endif // ASMJIT_BITOPS_X86
+  }
+
+  return nullptr;
+}
+
+static const Funcs* BitOps_detectHostFuncs() noexcept {
+  uint32_t impl = kImplCount;
+  while (impl != 0) {
+    const Funcs* funcs = getFuncs(--impl);
+    if (funcs) return funcs;
+  }
+  return &BitOps_scalarFuncs;
+}
+
+// Selected when first needed, as `CpuInfo::getHost()` is.
+static const Funcs* BitOps_hostFuncs;
+
+const Funcs& getHostFuncs() noexcept {
+  const Funcs* funcs = BitOps_hostFuncs;
+  if (ASMJIT_UNLIKELY(!funcs))
+    BitOps_hostFuncs = funcs = BitOps_detectHostFuncs();
+  return *funcs;
+}
+
+Error setHostImpl(uint32_t impl) noexcept {
+  const Funcs* funcs = getFuncs(impl);
+  if (ASMJIT_UNLIKELY(!funcs))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  BitOps_hostFuncs = funcs;
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::BitOps - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(base_bitops) {
+  enum { kMaxWords = 67 };
+
+  Word a[kMaxWords];
+  Word b[kMaxWords];
+  Word expDst[kMaxWords], expB[kMaxWords];
+  Word dst[kMaxWords], bCopy[kMaxWords];
+
+  for (uint32_t impl = 0; impl < kImplCount; impl++) {
+    const Funcs* funcs = getFuncs(impl);
+    if (!funcs) continue;
+
+    INFO("BitOps [%s]", funcs->name);
+
+    uint32_t seed = 0x12345678U;
+    for (size_t n = 0; n <= kMaxWords; n++) {
+      for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245U + 12345U;
+        a[i] = static_cast<Word>(seed) * static_cast<Word>(0x9E3779B1U);
+        seed = seed * 1103515245U + 12345U;
+        b[i] = (seed & 1) ? a[i] : static_cast<Word>(seed);
+      }
+
+      bool exp, res;
+
+      exp = BitOps_copyScalar(expDst, a, n);
+      res = funcs->copy(dst, a, n);
+      EXPECT(exp == res && ::memcmp(dst, expDst, n * sizeof(Word)) == 0);
+
+      exp = BitOps_orScalar(expDst, a, b, n);
+      res = funcs->or_(dst, a, b, n);
+      EXPECT(exp == res && ::memcmp(dst, expDst, n * sizeof(Word)) == 0);
+
+      exp = BitOps_andScalar(expDst, a, b, n);
+      res = funcs->and_(dst, a, b, n);
+      EXPECT(exp == res && ::memcmp(dst, expDst, n * sizeof(Word)) == 0);
+
+      exp = BitOps_andNotScalar(expDst, a, b, n);
+      res = funcs->andNot(dst, a, b, n);
+      EXPECT(exp == res && ::memcmp(dst, expDst, n * sizeof(Word)) == 0,
+        "andNot() failed, n=%u", static_cast<unsigned int>(n));
+
+      // `b` is modified, `b & ~a` is zero if `b` was a copy of `a`.
+      ::memcpy(expB, b, n * sizeof(Word));
+      ::memcpy(bCopy, b, n * sizeof(Word));
+      exp = BitOps_orDelSourceScalar(expDst, a, expB, n);
+      res = funcs->orDelSource(dst, a, bCopy, n);
+      EXPECT(exp == res &&
+             ::memcmp(dst, expDst, n * sizeof(Word)) == 0 &&
+             ::memcmp(bCopy, expB, n * sizeof(Word)) == 0);
+
+      // Aliased `dst` and `b`, like in the liveness analysis.
+      ::memcpy(expB, b, n * sizeof(Word));
+      ::memcpy(bCopy, b, n * sizeof(Word));
+      exp = BitOps_orDelSourceScalar(expB, a, expB, n);
+      res = funcs->orDelSource(bCopy, a, bCopy, n);
+      EXPECT(exp == res && ::memcmp(bCopy, expB, n * sizeof(Word)) == 0);
+    }
+  }
+}
+#endif
+
+} // BitOps namespace
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
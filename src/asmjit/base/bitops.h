@@ -0,0 +1,172 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_BASE_BITOPS_H
+#define _ASMJIT_BASE_BITOPS_H
+
+// [Dependencies]
+#include "../base/globals.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_base
+//! \{
+
+// ============================================================================
+// [asmjit::BitOps]
+// ============================================================================
+
+//! Operations on arrays of bit words, used by \ref ZoneBitVector and by the
+//! liveness analysis of the register allocator.
+//!
+//! Arrays of at least `kDispatchThreshold` words are processed by the best
+//! implementation the host CPU supports (SSE2 or AVX2 on X86), which is
+//! selected by using `CpuInfo::getHost()` when it's first needed. Shorter
+//! arrays are processed inline as the call would cost more than the work.
+//!
+//! All operations return `true` if at least one bit of the result is set.
+//! The destination can alias any of the sources.
+namespace BitOps {
+
+//! Bit word.
+typedef uintptr_t Word;
+
+//! Implementation of bit operations.
+ASMJIT_ENUM(Impl) {
+  kImplScalar           = 0,             //!< Portable scalar implementation.
+  kImplSSE2             = 1,             //!< X86 SSE2 implementation.
+  kImplAVX2             = 2,             //!< X86 AVX2 implementation.
+  kImplCount            = 3              //!< Count of implementations.
+};
+
+enum {
+  //! Minimum number of words processed by the dispatched implementation.
+  kDispatchThreshold = 8
+};
+
+//! Table of functions implementing bit operations.
+struct Funcs {
+  //! `dst = a`.
+  bool (*copy)(Word* dst, const Word* a, size_t n);
+  //! `dst = a | b`.
+  bool (*or_)(Word* dst, const Word* a, const Word* b, size_t n);
+  //! `dst = a & b`.
+  bool (*and_)(Word* dst, const Word* a, const Word* b, size_t n);
+  //! `dst = a & ~b`.
+  bool (*andNot)(Word* dst, const Word* a, const Word* b, size_t n);
+  //! `dst = a | b` and `b = b & ~a`, returns `true` if a bit of `b` is set.
+  bool (*orDelSource)(Word* dst, const Word* a, Word* b, size_t n);
+
+  uint32_t impl;                         //!< Implementation, see \ref Impl.
+  const char* name;                      //!< Name of the implementation.
+};
+
+//! Get functions of the implementation `impl`, or null if `impl` is not
+//! supported by the host CPU or by the compiler used to build AsmJit.
+ASMJIT_API const Funcs* getFuncs(uint32_t impl) noexcept;
+
+//! Get functions used by operations that are dispatched.
+ASMJIT_API const Funcs& getHostFuncs() noexcept;
+
+//! Use the implementation `impl` instead of the best one. Returns
+//! `kErrorInvalidArgument` if it's not supported.
+//!
+//! NOTE: This is mainly for testing and benchmarking, it must not be called
+//! while other threads use AsmJit.
+ASMJIT_API Error setHostImpl(uint32_t impl) noexcept;
+
+//! `dst = a`.
+static ASMJIT_INLINE bool copy(Word* dst, const Word* a, size_t n) noexcept {
+  if (n >= kDispatchThreshold)
+    return getHostFuncs().copy(dst, a, n);
+
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+//! `dst = a | b`.
+static ASMJIT_INLINE bool or_(Word* dst, const Word* a, const Word* b, size_t n) noexcept {
+  if (n >= kDispatchThreshold)
+    return getHostFuncs().or_(dst, a, b, n);
+
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] | b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+//! `dst = a & b`.
+static ASMJIT_INLINE bool and_(Word* dst, const Word* a, const Word* b, size_t n) noexcept {
+  if (n >= kDispatchThreshold)
+    return getHostFuncs().and_(dst, a, b, n);
+
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] & b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+//! `dst = a & ~b`.
+static ASMJIT_INLINE bool andNot(Word* dst, const Word* a, const Word* b, size_t n) noexcept {
+  if (n >= kDispatchThreshold)
+    return getHostFuncs().andNot(dst, a, b, n);
+
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word t = a[i] & ~b[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r != 0;
+}
+
+//! `dst = a | b` and `b = b & ~a`, returns `true` if a bit of `b` is set.
+//!
+//! If `dst` aliases `b` the result of the second operation is stored.
+static ASMJIT_INLINE bool orDelSource(Word* dst, const Word* a, Word* b, size_t n) noexcept {
+  if (n >= kDispatchThreshold)
+    return getHostFuncs().orDelSource(dst, a, b, n);
+
+  Word r = 0;
+  for (size_t i = 0; i < n; i++) {
+    Word x = a[i];
+    Word y = b[i];
+
+    dst[i] = x | y;
+    y &= ~x;
+
+    b[i] = y;
+    r |= y;
+  }
+  return r != 0;
+}
+
+} // BitOps namespace
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // _ASMJIT_BASE_BITOPS_H
@@ -13,6 +13,7 @@
 
 // [Dependencies]
 #include "../base/codebuilder.h"
+#include "../base/osutils.h"
 
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
@@ -31,11 +32,13 @@ CodeBuilder::CodeBuilder() noexcept
     _cbHeap(&_cbBaseZone),
     _cbPasses(),
     _cbLabels(),
+    _cbPassStats(),
     _firstNode(nullptr),
     _lastNode(nullptr),
     _cursor(nullptr),
     _position(0),
-    _nodeFlags(0) {}
+    _nodeFlags(0),
+    _cbPassStatsEnabled(0) {}
 CodeBuilder::~CodeBuilder() noexcept {}
 
 // ============================================================================
@@ -43,17 +46,35 @@ CodeBuilder::~CodeBuilder() noexcept {}
 // ============================================================================
 
 Error CodeBuilder::onAttach(CodeHolder* code) noexcept {
+  // Use the block cache of `code`, the zones are empty at this point.
+  ZoneBlockCache* cache = code->getBlockCache();
+  if (cache) {
+    _cbBaseZone.setBlockCache(cache);
+    _cbDataZone.setBlockCache(cache);
+    _cbPassZone.setBlockCache(cache);
+  }
+
   return Base::onAttach(code);
 }
 
 Error CodeBuilder::onDetach(CodeHolder* code) noexcept {
   _cbPasses.reset();
   _cbLabels.reset();
+  _cbPassStats.reset();
   _cbHeap.reset(&_cbBaseZone);
 
-  _cbBaseZone.reset(false);
-  _cbDataZone.reset(false);
-  _cbPassZone.reset(false);
+  // Return all blocks to the block cache (if used), it's not referenced after
+  // `CodeBuilder` is detached.
+  if (_cbBaseZone.getBlockCache()) {
+    _cbBaseZone.setBlockCache(nullptr);
+    _cbDataZone.setBlockCache(nullptr);
+    _cbPassZone.setBlockCache(nullptr);
+  }
+  else {
+    _cbBaseZone.reset(false);
+    _cbDataZone.reset(false);
+    _cbPassZone.reset(false);
+  }
 
   _position = 0;
   _nodeFlags = 0;
@@ -446,6 +467,56 @@ CBNode* CodeBuilder::setCursor(CBNode* node) noexcept {
   return old;
 }
 
+// ============================================================================
+// [asmjit::CodeBuilder - Checkpoint / Rollback]
+// ============================================================================
+
+void CodeBuilder::checkpoint(Checkpoint& cp) noexcept {
+  _cbHeap.checkpoint(cp.heap);
+  _cbLabels._saveStorage(cp.labels);
+
+  cp.cursor = _cursor;
+  cp.next = _cursor ? _cursor->_next : _firstNode;
+  cp.position = _position;
+  cp.nodeFlags = _nodeFlags;
+  cp.lastError = _lastError;
+}
+
+void CodeBuilder::rollback(const Checkpoint& cp) noexcept {
+  // Unlink all nodes inserted after the checkpoint, they are between the
+  // cursor and the node that followed it.
+  CBNode* prev = cp.cursor;
+  CBNode* next = cp.next;
+
+  if (prev)
+    prev->_next = next;
+  else
+    _firstNode = next;
+
+  if (next)
+    next->_prev = prev;
+  else
+    _lastNode = prev;
+
+  _cursor = prev;
+  _position = cp.position;
+  _nodeFlags = cp.nodeFlags;
+
+  // The storage of `_cbLabels` might have been reallocated, the old one is
+  // intact as `_cbHeap` doesn't reuse released memory during a checkpoint.
+  _cbLabels._restoreStorage(cp.labels);
+  _cbHeap.rollback(cp.heap);
+
+  _lastError = cp.lastError;
+  resetOptions();
+  resetExtraReg();
+  resetInlineComment();
+}
+
+void CodeBuilder::commit(const Checkpoint& cp) noexcept {
+  _cbHeap.commit(cp.heap);
+}
+
 // ============================================================================
 // [asmjit::CodeBuilder - Passes]
 // ============================================================================
@@ -460,7 +531,7 @@ ASMJIT_FAVOR_SIZE CBPass* CodeBuilder::getPassByName(const char* name) const noe
   return nullptr;
 }
 
-ASMJIT_FAVOR_SIZE Error CodeBuilder::addPass(CBPass* pass) noexcept {
+ASMJIT_FAVOR_SIZE Error CodeBuilder::insertPass(size_t index, CBPass* pass) noexcept {
   if (ASMJIT_UNLIKELY(pass == nullptr)) {
     // Since this is directly called by `addPassT()` we treat `null` argument
     // as out-of-memory condition. Otherwise it would be API misuse.
@@ -473,7 +544,10 @@ ASMJIT_FAVOR_SIZE Error CodeBuilder::addPass(CBPass* pass) noexcept {
     return DebugUtils::errored(kErrorInvalidState);
   }
 
-  ASMJIT_PROPAGATE(_cbPasses.append(&_cbHeap, pass));
+  if (ASMJIT_UNLIKELY(index > _cbPasses.getLength()))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  ASMJIT_PROPAGATE(_cbPasses.insert(&_cbHeap, index, pass));
   pass->_cb = this;
   return kErrorOk;
 }
@@ -497,6 +571,110 @@ ASMJIT_FAVOR_SIZE Error CodeBuilder::deletePass(CBPass* pass) noexcept {
   return kErrorOk;
 }
 
+static ASMJIT_INLINE uint64_t CodeBuilder_countNodes(const CodeBuilder* self) noexcept {
+  uint64_t count = 0;
+  for (CBNode* node = self->getFirstNode(); node; node = node->getNext())
+    count++;
+  return count;
+}
+
+Error CodeBuilder::runPasses() noexcept {
+  ZoneVector<CBPass*>& passes = _cbPasses;
+  bool stats = isPassStatsEnabled();
+
+  Error err = kErrorOk;
+  _cbPassStats.reset();
+
+  for (size_t i = 0, len = passes.getLength(); i < len; i++) {
+    CBPass* pass = passes[i];
+
+    if (ASMJIT_UNLIKELY(stats)) {
+      // Make sure the pass is always listed before its phases.
+      err = addPassStats(pass->getName(), 0, 0, 0, 0, 0);
+      if (err) break;
+
+      uint64_t startTime = OSUtils::getTickCountUs();
+      err = pass->process(&_cbPassZone);
+      uint64_t time = OSUtils::getTickCountUs() - startTime;
+
+      if (!err)
+        err = addPassStats(pass->getName(), 0, 1, time, CodeBuilder_countNodes(this), _cbPassZone.getUsedSize());
+    }
+    else {
+      err = pass->process(&_cbPassZone);
+    }
+
+    _cbPassZone.reset();
+    if (err) break;
+  }
+
+  _cbPassZone.reset();
+  if (ASMJIT_UNLIKELY(err)) return err;
+
+#if !defined(ASMJIT_DISABLE_LOGGING)
+  if (ASMJIT_UNLIKELY(stats) && (getGlobalOptions() & kOptionLoggingEnabled)) {
+    StringBuilderTmp<512> sb;
+    ASMJIT_PROPAGATE(dumpPassStats(sb));
+    _code->getLogger()->log(sb);
+  }
+#endif // !ASMJIT_DISABLE_LOGGING
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::CodeBuilder - Pass Statistics]
+// ============================================================================
+
+Error CodeBuilder::addPassStats(const char* name, uint32_t level, uint32_t runCount, uint64_t time, uint64_t nodeCount, uint64_t zoneSize) noexcept {
+  CBPassStats* entry = nullptr;
+
+  for (size_t i = 0, len = _cbPassStats.getLength(); i < len; i++) {
+    CBPassStats& stats = _cbPassStats[i];
+    if (stats.level == level && ::strcmp(stats.name, name) == 0) {
+      entry = &stats;
+      break;
+    }
+  }
+
+  if (!entry) {
+    CBPassStats stats;
+    stats.name = name;
+    stats.level = level;
+    stats.runCount = 0;
+    stats.time = 0;
+    stats.nodeCount = 0;
+    stats.zoneSize = 0;
+
+    ASMJIT_PROPAGATE(_cbPassStats.append(&_cbHeap, stats));
+    entry = &_cbPassStats[_cbPassStats.getLength() - 1];
+  }
+
+  entry->runCount += runCount;
+  entry->time += time;
+  entry->nodeCount += nodeCount;
+  entry->zoneSize += zoneSize;
+  return kErrorOk;
+}
+
+ASMJIT_FAVOR_SIZE Error CodeBuilder::dumpPassStats(StringBuilder& sb) const noexcept {
+  ASMJIT_PROPAGATE(sb.appendFormat("; %-20s %6s %10s %10s %10s\n", "Pass", "Runs", "Time [us]", "Nodes", "Zone [B]"));
+
+  for (size_t i = 0, len = _cbPassStats.getLength(); i < len; i++) {
+    const CBPassStats& stats = _cbPassStats[i];
+    uint32_t indent = stats.level * 2;
+
+    ASMJIT_PROPAGATE(sb.appendFormat("; %*s%-*s %6u %10llu %10llu %10llu\n",
+      int(indent), "", int(20 - indent), stats.name,
+      stats.runCount,
+      static_cast<unsigned long long>(stats.time),
+      static_cast<unsigned long long>(stats.nodeCount),
+      static_cast<unsigned long long>(stats.zoneSize)));
+  }
+
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeBuilder - Serialization]
 // ============================================================================
@@ -566,6 +744,95 @@ Error CodeBuilder::serialize(CodeEmitter* dst) {
   return err;
 }
 
+// ============================================================================
+// [asmjit::CBNodeStore]
+// ============================================================================
+
+Error CBNodeStore::init(Zone* zone, CBNode* first, CBNode* stop) noexcept {
+  reset();
+
+  CBNode* node;
+  size_t count = 0;
+  size_t opCount = 0;
+
+  for (node = first; node != stop; node = node->getNext()) {
+    if (node->getType() == CBNode::kNodeInst)
+      opCount += static_cast<CBInst*>(node)->getOpCount();
+    count++;
+  }
+
+  if (!count)
+    return kErrorOk;
+
+  if (ASMJIT_UNLIKELY(count >= 0xFFFFFFFFU))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  CBNode** nodes = zone->allocT<CBNode*>(count * sizeof(CBNode*));
+  uint8_t* types = zone->allocT<uint8_t>(count * sizeof(uint8_t));
+  uint16_t* flags = zone->allocT<uint16_t>(count * sizeof(uint16_t));
+  uint16_t* instIds = zone->allocT<uint16_t>(count * sizeof(uint16_t));
+  uint32_t* labelIds = zone->allocT<uint32_t>(count * sizeof(uint32_t));
+  uint32_t* opIndexes = zone->allocT<uint32_t>((count + 1) * sizeof(uint32_t));
+  Operand* ops = zone->allocT<Operand>(opCount * sizeof(Operand));
+
+  if (ASMJIT_UNLIKELY(!nodes || !types || !flags || !instIds || !labelIds || !opIndexes || (opCount && !ops)))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  uint32_t i = 0;
+  uint32_t opIndex = 0;
+
+  for (node = first; node != stop; node = node->getNext(), i++) {
+    uint32_t type = node->getType();
+    uint32_t instId = Inst::kIdNone;
+    uint32_t labelId = 0;
+
+    opIndexes[i] = opIndex;
+
+    switch (type) {
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        uint32_t n = inst->getOpCount();
+
+        instId = inst->getInstId();
+        const Operand* opArray = inst->getOpArray();
+        for (uint32_t j = 0; j < n; j++)
+          ops[opIndex + j].copyFrom(opArray[j]);
+        opIndex += n;
+
+        if (inst->isJmpOrJcc()) {
+          CBLabel* target = static_cast<CBJump*>(inst)->getTarget();
+          if (target) labelId = target->getId();
+        }
+        break;
+      }
+
+      case CBNode::kNodeLabel:
+      case CBNode::kNodeConstPool:
+      case CBNode::kNodeFunc:
+        labelId = static_cast<CBLabel*>(node)->getId();
+        break;
+    }
+
+    nodes[i] = node;
+    types[i] = static_cast<uint8_t>(type);
+    flags[i] = static_cast<uint16_t>(node->getFlags());
+    instIds[i] = static_cast<uint16_t>(instId);
+    labelIds[i] = labelId;
+  }
+  opIndexes[i] = opIndex;
+
+  _count = static_cast<uint32_t>(count);
+  _nodes = nodes;
+  _types = types;
+  _flags = flags;
+  _instIds = instIds;
+  _labelIds = labelIds;
+  _opIndexes = opIndexes;
+  _ops = ops;
+
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CBPass]
 // ============================================================================
@@ -17,6 +17,7 @@
 #include "../base/constpool.h"
 #include "../base/inst.h"
 #include "../base/operand.h"
+#include "../base/string.h"
 #include "../base/utils.h"
 #include "../base/zone.h"
 
@@ -40,11 +41,27 @@ class CBInst;
 class CBJump;
 class CBLabel;
 class CBLabelData;
+class CBNodeStore;
 class CBSentinel;
 
 //! \addtogroup asmjit_base
 //! \{
 
+// ============================================================================
+// [asmjit::CBPassStats]
+// ============================================================================
+
+//! Statistics of a single `CBPass`, or of a phase of a pass, collected by
+//! `CodeBuilder::runPasses()` if `CodeBuilder::setPassStatsEnabled()` is set.
+struct CBPassStats {
+  const char* name;                      //!< Name of the pass or phase.
+  uint32_t level;                        //!< Nesting level, 0 for a pass, 1 for its phase.
+  uint32_t runCount;                     //!< Number of times the pass or phase ran.
+  uint64_t time;                         //!< Wall time in microseconds.
+  uint64_t nodeCount;                    //!< Number of nodes visited.
+  uint64_t zoneSize;                     //!< Bytes of `Zone` memory consumed.
+};
+
 // ============================================================================
 // [asmjit::CodeBuilder]
 // ============================================================================
@@ -54,6 +71,17 @@ public:
   ASMJIT_NONCOPYABLE(CodeBuilder)
   typedef CodeEmitter Base;
 
+  //! State of the `CodeBuilder` saved by `checkpoint()`.
+  struct Checkpoint {
+    ZoneHeap::Checkpoint heap;           //!< State of `_cbHeap` and `_cbBaseZone`.
+    ZoneVectorBase::Storage labels;      //!< Storage of `_cbLabels`.
+    CBNode* cursor;                      //!< Cursor.
+    CBNode* next;                        //!< Node that followed the cursor.
+    uint32_t position;                   //!< Flow-id assigned to each new node.
+    uint32_t nodeFlags;                  //!< Flags assigned to each new node.
+    Error lastError;                     //!< Last error.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -163,6 +191,32 @@ public:
   //! Set the current node to `node` and return the previous one.
   ASMJIT_API CBNode* setCursor(CBNode* node) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Checkpoint / Rollback]
+  // --------------------------------------------------------------------------
+
+  //! Save the state of the `CodeBuilder` to `cp`, so code emitted after it
+  //! can be abandoned by `rollback()`, for example to try several variants
+  //! of the same code and to keep the best one.
+  //!
+  //! Code emitted after the checkpoint must be inserted at the cursor, nodes
+  //! that existed at the checkpoint must not be removed or moved, and no passes
+  //! can be added. Checkpoints can be nested, but they have to be ended by
+  //! `rollback()` or `commit()` in the reverse order.
+  //!
+  //! Label ids created after the checkpoint stay valid in \ref CodeHolder, but
+  //! their nodes are abandoned by `rollback()`. Data allocated by `_cbDataZone`
+  //! (names, comments, embedded data, and constants) is kept.
+  ASMJIT_API void checkpoint(Checkpoint& cp) noexcept;
+
+  //! Abandon all nodes added since `checkpoint()` and roll back the memory
+  //! they use. The last error is restored, so an error that happened after
+  //! the checkpoint is discarded.
+  ASMJIT_API void rollback(const Checkpoint& cp) noexcept;
+
+  //! Keep all nodes added since `checkpoint()` and end the checkpoint.
+  ASMJIT_API void commit(const Checkpoint& cp) noexcept;
+
   // --------------------------------------------------------------------------
   // [Passes]
   // --------------------------------------------------------------------------
@@ -173,21 +227,57 @@ public:
   ASMJIT_INLINE T* newPassT(P0 p0) noexcept { return new(_cbBaseZone.alloc(sizeof(T))) T(p0); }
   template<typename T, typename P0, typename P1>
   ASMJIT_INLINE T* newPassT(P0 p0, P1 p1) noexcept { return new(_cbBaseZone.alloc(sizeof(T))) T(p0, p1); }
+  template<typename T, typename P0, typename P1, typename P2>
+  ASMJIT_INLINE T* newPassT(P0 p0, P1 p1, P2 p2) noexcept { return new(_cbBaseZone.alloc(sizeof(T))) T(p0, p1, p2); }
 
   template<typename T>
   ASMJIT_INLINE Error addPassT() noexcept { return addPass(newPassT<T>()); }
   template<typename T, typename P0>
-  ASMJIT_INLINE Error addPassT(P0 p0) noexcept { return addPass(newPassT<P0>(p0)); }
+  ASMJIT_INLINE Error addPassT(P0 p0) noexcept { return addPass(newPassT<T, P0>(p0)); }
   template<typename T, typename P0, typename P1>
-  ASMJIT_INLINE Error addPassT(P0 p0, P1 p1) noexcept { return addPass(newPassT<P0, P1>(p0, p1)); }
+  ASMJIT_INLINE Error addPassT(P0 p0, P1 p1) noexcept { return addPass(newPassT<T, P0, P1>(p0, p1)); }
+  template<typename T, typename P0, typename P1, typename P2>
+  ASMJIT_INLINE Error addPassT(P0 p0, P1 p1, P2 p2) noexcept { return addPass(newPassT<T, P0, P1, P2>(p0, p1, p2)); }
 
   //! Get a `CBPass` by name.
   ASMJIT_API CBPass* getPassByName(const char* name) const noexcept;
   //! Add `pass` to the list of passes.
-  ASMJIT_API Error addPass(CBPass* pass) noexcept;
+  ASMJIT_INLINE Error addPass(CBPass* pass) noexcept { return insertPass(_cbPasses.getLength(), pass); }
+  //! Insert `pass` to the list of passes at `index`.
+  //!
+  //! Can be used to run a pass before passes added by the emitter itself, for
+  //! example before register allocation, which is added by `CodeCompiler`.
+  ASMJIT_API Error insertPass(size_t index, CBPass* pass) noexcept;
   //! Remove `pass` from the list of passes and delete it.
   ASMJIT_API Error deletePass(CBPass* pass) noexcept;
 
+  //! Run all passes, in order they were added, see `CBPass::process()`.
+  ASMJIT_API Error runPasses() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Pass Statistics]
+  // --------------------------------------------------------------------------
+
+  //! Get whether `runPasses()` collects statistics of passes and their phases.
+  ASMJIT_INLINE bool isPassStatsEnabled() const noexcept { return _cbPassStatsEnabled != 0; }
+  //! Set whether `runPasses()` collects statistics of passes and their phases.
+  //!
+  //! Statistics are reset by each `runPasses()` and are also sent to the
+  //! \ref Logger if logging is enabled.
+  ASMJIT_INLINE void setPassStatsEnabled(bool value) noexcept { _cbPassStatsEnabled = static_cast<uint8_t>(value); }
+
+  //! Get statistics collected by the last `runPasses()`.
+  //!
+  //! Each pass is followed by its phases (if the pass reports any).
+  ASMJIT_INLINE const ZoneVector<CBPassStats>& getPassStats() const noexcept { return _cbPassStats; }
+
+  //! Add `runCount`, `time`, `nodeCount`, and `zoneSize` to statistics of the
+  //! pass or phase `name` (called by passes, which have to check whether
+  //! `isPassStatsEnabled()` is true before calling it).
+  ASMJIT_API Error addPassStats(const char* name, uint32_t level, uint32_t runCount, uint64_t time, uint64_t nodeCount, uint64_t zoneSize) noexcept;
+  //! Format statistics returned by `getPassStats()` into `sb`.
+  ASMJIT_API Error dumpPassStats(StringBuilder& sb) const noexcept;
+
   // --------------------------------------------------------------------------
   // [Serialization]
   // --------------------------------------------------------------------------
@@ -203,8 +293,9 @@ public:
   Zone _cbPassZone;                      //!< Zone passed to `CBPass::process()`.
   ZoneHeap _cbHeap;                      //!< ZoneHeap that uses `_cbBaseZone`.
 
-  ZoneVector<CBPass*> _cbPasses;         //!< Array of `CBPass` objects.
-  ZoneVector<CBLabel*> _cbLabels;        //!< Maps label indexes to `CBLabel` nodes.
+  ZoneSmallVector<CBPass*, 4> _cbPasses; //!< Array of `CBPass` objects.
+  ZoneSmallVector<CBLabel*, 16> _cbLabels; //!< Maps label indexes to `CBLabel` nodes.
+  ZoneVector<CBPassStats> _cbPassStats;  //!< Statistics collected by `runPasses()`.
 
   CBNode* _firstNode;                    //!< First node of the current section.
   CBNode* _lastNode;                     //!< Last node of the current section.
@@ -212,6 +303,7 @@ public:
 
   uint32_t _position;                    //!< Flow-id assigned to each new node.
   uint32_t _nodeFlags;                   //!< Flags assigned to each new node.
+  uint8_t _cbPassStatsEnabled;           //!< Collect `CBPassStats` in `runPasses()`.
 };
 
 // ============================================================================
@@ -827,7 +919,7 @@ public:
   //! Create a new `CBConstPool` instance.
   ASMJIT_INLINE CBConstPool(CodeBuilder* cb, uint32_t id = kInvalidValue) noexcept
     : CBLabel(cb, id),
-      _constPool(&cb->_cbBaseZone) { _type = kNodeConstPool; }
+      _constPool(&cb->_cbDataZone) { _type = kNodeConstPool; }
 
   //! Destroy the `CBConstPool` instance (NEVER CALLED).
   ASMJIT_INLINE ~CBConstPool() noexcept {}
@@ -903,6 +995,130 @@ public:
   ASMJIT_INLINE ~CBSentinel() noexcept {}
 };
 
+// ============================================================================
+// [asmjit::CBNodeStore]
+// ============================================================================
+
+//! Compact node store (CodeBuilder).
+//!
+//! Copies the type, flags, instruction id, label id, and operands of a range
+//! of nodes into dense arrays indexed by the position of the node within the
+//! range. A pass that iterates over the code many times can then stream these
+//! arrays instead of following `CBNode::getNext()` across zone blocks. Nodes
+//! stay the primary representation, and `getNode()` is the linked view used
+//! to inspect a node further or to insert code around it.
+//!
+//! The store is a snapshot. It doesn't see nodes that were added or changed
+//! after `init()`, and must not be used to access nodes that were removed.
+//! Arrays are allocated by the zone passed to `init()`, which is usually the
+//! zone passed to `CBPass::process()`.
+class CBNodeStore {
+public:
+  ASMJIT_NONCOPYABLE(CBNodeStore)
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE CBNodeStore() noexcept { reset(); }
+  ASMJIT_INLINE ~CBNodeStore() noexcept {}
+
+  // --------------------------------------------------------------------------
+  // [Init / Reset]
+  // --------------------------------------------------------------------------
+
+  //! Store nodes from `first` up to `stop` (exclusive) or to the end of the
+  //! list if `stop` is null.
+  ASMJIT_API Error init(Zone* zone, CBNode* first, CBNode* stop = nullptr) noexcept;
+
+  //! Reset the store to contain no nodes (the memory is owned by the zone).
+  ASMJIT_INLINE void reset() noexcept {
+    _count = 0;
+    _nodes = nullptr;
+    _types = nullptr;
+    _flags = nullptr;
+    _instIds = nullptr;
+    _labelIds = nullptr;
+    _opIndexes = nullptr;
+    _ops = nullptr;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the number of stored nodes.
+  ASMJIT_INLINE uint32_t getCount() const noexcept { return _count; }
+
+  //! Get the node at `index`.
+  ASMJIT_INLINE CBNode* getNode(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _nodes[index];
+  }
+
+  //! Get the type of the node at `index`, see \ref CBNode::NodeType.
+  ASMJIT_INLINE uint32_t getType(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _types[index];
+  }
+
+  //! Get the flags of the node at `index`, see \ref CBNode::Flags.
+  ASMJIT_INLINE uint32_t getFlags(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _flags[index];
+  }
+  //! Get whether the node at `index` has flag `flag`.
+  ASMJIT_INLINE bool hasFlag(uint32_t index, uint32_t flag) const noexcept { return (getFlags(index) & flag) != 0; }
+
+  //! Get the instruction id of the node at `index`, `Inst::kIdNone` if the
+  //! node is not `CBNode::kNodeInst`.
+  ASMJIT_INLINE uint32_t getInstId(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _instIds[index];
+  }
+
+  //! Get the label id of the node at `index`, which is the id of the label
+  //! of \ref CBLabel nodes (including functions and constant pools), the id of
+  //! the target of jumps (see \ref CBJump), and zero otherwise.
+  ASMJIT_INLINE uint32_t getLabelId(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _labelIds[index];
+  }
+
+  //! Get the number of operands of the node at `index` (only `CBNode::kNodeInst`
+  //! nodes have operands).
+  ASMJIT_INLINE uint32_t getOpCount(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _opIndexes[index + 1] - _opIndexes[index];
+  }
+  //! Get the operands of the node at `index`.
+  ASMJIT_INLINE const Operand* getOpArray(uint32_t index) const noexcept {
+    ASMJIT_ASSERT(index < _count);
+    return _ops + _opIndexes[index];
+  }
+
+  //! Get the index of the first node at or after `index` of type `type`, or
+  //! `getCount()` if there is no such node.
+  ASMJIT_INLINE uint32_t findType(uint32_t index, uint32_t type) const noexcept {
+    while (index < _count && _types[index] != type)
+      index++;
+    return index;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _count;                       //!< Number of stored nodes.
+  CBNode** _nodes;                       //!< Nodes (linked view).
+  uint8_t* _types;                       //!< Node types.
+  uint16_t* _flags;                      //!< Node flags.
+  uint16_t* _instIds;                    //!< Instruction ids.
+  uint32_t* _labelIds;                   //!< Label ids or jump target ids.
+  uint32_t* _opIndexes;                  //!< Index of the first operand of each node (`_count + 1` items).
+  Operand* _ops;                         //!< Operands of all nodes.
+};
+
 //! \}
 
 } // asmjit namespace
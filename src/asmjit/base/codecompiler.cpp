@@ -58,6 +58,7 @@ bool CCFuncCall::_setRet(uint32_t i, const Operand_& op) noexcept {
 CodeCompiler::CodeCompiler() noexcept
   : CodeBuilder(),
     _func(nullptr),
+    _funcAttributes(0),
     _vRegZone(4096 - Zone::kZoneOverhead),
     _vRegArray(),
     _localConstPool(nullptr),
@@ -72,6 +73,10 @@ CodeCompiler::~CodeCompiler() noexcept {}
 // ============================================================================
 
 Error CodeCompiler::onAttach(CodeHolder* code) noexcept {
+  ZoneBlockCache* cache = code->getBlockCache();
+  if (cache)
+    _vRegZone.setBlockCache(cache);
+
   return Base::onAttach(code);
 }
 
@@ -82,11 +87,67 @@ Error CodeCompiler::onDetach(CodeHolder* code) noexcept {
   _globalConstPool = nullptr;
 
   _vRegArray.reset();
-  _vRegZone.reset(false);
+  if (_vRegZone.getBlockCache())
+    _vRegZone.setBlockCache(nullptr);
+  else
+    _vRegZone.reset(false);
 
   return Base::onDetach(code);
 }
 
+// ============================================================================
+// [asmjit::CodeCompiler - Checkpoint / Rollback]
+// ============================================================================
+
+void CodeCompiler::checkpoint(Checkpoint& cp) noexcept {
+  Base::checkpoint(cp);
+
+  _vRegZone.checkpoint(cp.vRegZone);
+  _vRegArray._saveStorage(cp.vRegs);
+
+  cp.func = _func;
+  cp.localConstPool = _localConstPool;
+  cp.globalConstPool = _globalConstPool;
+}
+
+void CodeCompiler::rollback(const Checkpoint& cp) noexcept {
+  // Jumps are linked to their targets, which may be labels that existed at
+  // the checkpoint. Jumps added after the checkpoint are always at the front
+  // of the target's list, but not necessarily in the order of nodes.
+  CBNode* node = cp.cursor ? cp.cursor->getNext() : _firstNode;
+  while (node != cp.next) {
+    if (node->isJmpOrJcc()) {
+      CBJump* jump = static_cast<CBJump*>(node);
+      CBLabel* target = jump->getTarget();
+
+      if (target) {
+        CBJump** pPrev = &target->_from;
+        while (*pPrev && *pPrev != jump)
+          pPrev = &(*pPrev)->_jumpNext;
+
+        if (*pPrev) {
+          *pPrev = jump->_jumpNext;
+          target->subNumRefs();
+        }
+      }
+    }
+    node = node->getNext();
+  }
+
+  _vRegArray._restoreStorage(cp.vRegs);
+  _vRegZone.rollback(cp.vRegZone);
+
+  _func = cp.func;
+  _localConstPool = cp.localConstPool;
+  _globalConstPool = cp.globalConstPool;
+
+  Base::rollback(cp);
+}
+
+void CodeCompiler::commit(const Checkpoint& cp) noexcept {
+  Base::commit(cp);
+}
+
 // ============================================================================
 // [asmjit::CodeCompiler - Node-Factory]
 // ============================================================================
@@ -118,6 +179,7 @@ CCFunc* CodeCompiler::newFunc(const FuncSignature& sign) noexcept {
   // Create helper nodes.
   func->_exitNode = newLabelNode();
   func->_end = newNodeT<CBSentinel>();
+  func->getFrameInfo().addAttributes(_funcAttributes);
 
   if (!func->_exitNode || !func->_end)
     goto _NoMemory;
@@ -404,6 +404,25 @@ class CCFuncCall : public CBInst {
 public:
   ASMJIT_NONCOPYABLE(CCFuncCall)
 
+  // --------------------------------------------------------------------------
+  // [Attributes]
+  // --------------------------------------------------------------------------
+
+  //! Call attributes, describe the callee beyond its signature.
+  ASMJIT_ENUM(Attributes) {
+    //! Call is in a tail position and should be translated to a frame
+    //! teardown followed by a jump to the callee, if possible. The call is
+    //! kept as is if the callee passes arguments by stack, the caller's
+    //! return doesn't directly follow it, or the target can't be reached
+    //! after the teardown.
+    kAttrTailCall         = 0x00000001U,
+
+    //! The callee doesn't suffer from AVX/SSE transitions (it doesn't use
+    //! legacy SSE instructions), so no 'vzeroupper' is needed before the call
+    //! (X86).
+    kX86AttrAvxClean      = 0x00040000U
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -412,7 +431,8 @@ public:
   ASMJIT_INLINE CCFuncCall(CodeBuilder* cb, uint32_t instId, uint32_t options, Operand* opArray, uint32_t opCount) noexcept
     : CBInst(cb, instId, options, opArray, opCount),
       _funcDetail(),
-      _args(nullptr) {
+      _args(nullptr),
+      _attributes(0) {
 
     _type = kNodeFuncCall;
     _ret[0].reset();
@@ -481,6 +501,15 @@ public:
   //! Set return at `i` to `var`.
   ASMJIT_INLINE bool setRet(uint32_t i, const Reg& reg) noexcept { return _setRet(i, reg); }
 
+  //! Get call attributes, see \ref Attributes.
+  ASMJIT_INLINE uint32_t getAttributes() const noexcept { return _attributes; }
+  //! Check if a call attribute `attr` is set, see \ref Attributes.
+  ASMJIT_INLINE bool hasAttribute(uint32_t attr) const noexcept { return (_attributes & attr) != 0; }
+  //! Add call attributes `attrs`, see \ref Attributes.
+  ASMJIT_INLINE void addAttributes(uint32_t attrs) noexcept { _attributes |= attrs; }
+  //! Clear call attributes `attrs`, see \ref Attributes.
+  ASMJIT_INLINE void clearAttributes(uint32_t attrs) noexcept { _attributes &= ~attrs; }
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
@@ -488,6 +517,7 @@ public:
   FuncDetail _funcDetail;                //!< Function detail.
   Operand_ _ret[2];                      //!< Return.
   Operand_* _args;                       //!< Arguments.
+  uint32_t _attributes;                  //!< Call attributes.
 };
 
 // ============================================================================
@@ -561,6 +591,15 @@ public:
   ASMJIT_NONCOPYABLE(CodeCompiler)
   typedef CodeBuilder Base;
 
+  //! State of the `CodeCompiler` saved by `checkpoint()`.
+  struct Checkpoint : public CodeBuilder::Checkpoint {
+    Zone::Checkpoint vRegZone;           //!< State of `_vRegZone`.
+    ZoneVectorBase::Storage vRegs;       //!< Storage of `_vRegArray`.
+    CCFunc* func;                        //!< Current function.
+    CBConstPool* localConstPool;         //!< Local constant pool.
+    CBConstPool* globalConstPool;        //!< Global constant pool.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -577,6 +616,28 @@ public:
   ASMJIT_API virtual Error onAttach(CodeHolder* code) noexcept override;
   ASMJIT_API virtual Error onDetach(CodeHolder* code) noexcept override;
 
+  // --------------------------------------------------------------------------
+  // [Checkpoint / Rollback]
+  // --------------------------------------------------------------------------
+
+  //! Save the state of the `CodeCompiler` to `cp`, see \ref CodeBuilder::checkpoint().
+  //!
+  //! In addition to `CodeBuilder` the checkpoint covers virtual registers,
+  //! the current function, and constant pools. Constants added to a constant
+  //! pool that existed at the checkpoint are kept by `rollback()`. Virtual
+  //! registers created after the checkpoint must not be assigned to nodes that
+  //! existed at the checkpoint (like arguments of the current function).
+  ASMJIT_API void checkpoint(Checkpoint& cp) noexcept;
+
+  //! Abandon all nodes and virtual registers created since `checkpoint()`.
+  //!
+  //! Unlike `CodeBuilder::rollback()` this visits abandoned jumps to unlink
+  //! them from their targets.
+  ASMJIT_API void rollback(const Checkpoint& cp) noexcept;
+
+  //! Keep all nodes added since `checkpoint()` and end the checkpoint.
+  ASMJIT_API void commit(const Checkpoint& cp) noexcept;
+
   // --------------------------------------------------------------------------
   // [Node-Factory]
   // --------------------------------------------------------------------------
@@ -593,6 +654,23 @@ public:
   //! Get the current function.
   ASMJIT_INLINE CCFunc* getFunc() const noexcept { return _func; }
 
+  //! Get frame attributes of new functions, see \ref FuncFrameInfo::Attributes.
+  ASMJIT_INLINE uint32_t getFuncAttributes() const noexcept { return _funcAttributes; }
+  //! Set frame attributes of new functions, see \ref FuncFrameInfo::Attributes.
+  //!
+  //! For example, to use VEX encoding of SSE instructions when the host CPU
+  //! supports AVX:
+  //!
+  //! ~~~
+  //! if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX))
+  //!   cc.addFuncAttributes(FuncFrameInfo::kX86AttrVexPromotion);
+  //! ~~~
+  ASMJIT_INLINE void setFuncAttributes(uint32_t attrs) noexcept { _funcAttributes = attrs; }
+  //! Add frame attributes of new functions, see \ref FuncFrameInfo::Attributes.
+  ASMJIT_INLINE void addFuncAttributes(uint32_t attrs) noexcept { _funcAttributes |= attrs; }
+  //! Clear frame attributes of new functions, see \ref FuncFrameInfo::Attributes.
+  ASMJIT_INLINE void clearFuncAttributes(uint32_t attrs) noexcept { _funcAttributes &= ~attrs; }
+
   //! Create a new `CCFunc`.
   ASMJIT_API CCFunc* newFunc(const FuncSignature& sign) noexcept;
   //! Add a function `node` to the stream.
@@ -718,9 +796,10 @@ public:
   // --------------------------------------------------------------------------
 
   CCFunc* _func;                         //!< Current function.
+  uint32_t _funcAttributes;              //!< Frame attributes of new functions.
 
   Zone _vRegZone;                        //!< Allocates \ref VirtReg objects.
-  ZoneVector<VirtReg*> _vRegArray;       //!< Stores array of \ref VirtReg pointers.
+  ZoneSmallVector<VirtReg*, 16> _vRegArray; //!< Stores array of \ref VirtReg pointers.
 
   CBConstPool* _localConstPool;          //!< Local constant pool, flushed at the end of each function.
   CBConstPool* _globalConstPool;         //!< Global constant pool, flushed at the end of the compilation.
@@ -56,11 +56,12 @@ static void CodeHolder_resetInternal(CodeHolder* self, bool releaseMemory) noexc
   self->_trampolinesSize = 0;
 
   // Reset all sections.
+  ZoneBlockCache* cache = self->getBlockCache();
   size_t numSections = self->_sections.getLength();
   for (size_t i = 0; i < numSections; i++) {
     SectionEntry* section = self->_sections[i];
     if (section->_buffer.hasData() && !section->_buffer.isExternal())
-      Internal::releaseMemory(section->_buffer._data);
+      ZoneBlockCache::releaseBlock(cache, section->_buffer._data, section->_buffer._capacity);
     section->_buffer._data = nullptr;
     section->_buffer._capacity = 0;
   }
@@ -75,6 +76,7 @@ static void CodeHolder_resetInternal(CodeHolder* self, bool releaseMemory) noexc
 
   heap->reset(&self->_baseZone);
   self->_baseZone.reset(releaseMemory);
+  self->_dataZone.reset(releaseMemory);
 }
 
 // ============================================================================
@@ -141,6 +143,20 @@ void CodeHolder::reset(bool releaseMemory) noexcept {
   CodeHolder_resetInternal(this, releaseMemory);
 }
 
+// ============================================================================
+// [asmjit::CodeHolder - Memory Management]
+// ============================================================================
+
+Error CodeHolder::setBlockCache(ZoneBlockCache* cache) noexcept {
+  if (isInitialized())
+    return DebugUtils::errored(kErrorAlreadyInitialized);
+
+  _baseHeap.reset(&_baseZone);
+  _baseZone.setBlockCache(cache);
+  _dataZone.setBlockCache(cache);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeHolder - Attach / Detach]
 // ============================================================================
@@ -270,14 +286,30 @@ Error CodeHolder::setErrorHandler(ErrorHandler* handler) noexcept {
 static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
   uint8_t* oldData = cb->_data;
   uint8_t* newData;
+  ZoneBlockCache* cache = self->getBlockCache();
 
-  if (oldData && !cb->isExternal())
-    newData = static_cast<uint8_t*>(Internal::reallocMemory(oldData, n));
-  else
-    newData = static_cast<uint8_t*>(Internal::allocMemory(n));
+  if (cache) {
+    // Buffers are taken from the cache and returned to it, so they can't be
+    // reallocated.
+    newData = static_cast<uint8_t*>(cache->alloc(n, n));
+    if (ASMJIT_UNLIKELY(!newData))
+      return DebugUtils::errored(kErrorNoHeapMemory);
 
-  if (ASMJIT_UNLIKELY(!newData))
-    return DebugUtils::errored(kErrorNoHeapMemory);
+    if (oldData) {
+      ::memcpy(newData, oldData, cb->_length);
+      if (!cb->isExternal())
+        cache->release(oldData, cb->_capacity);
+    }
+  }
+  else {
+    if (oldData && !cb->isExternal())
+      newData = static_cast<uint8_t*>(Internal::reallocMemory(oldData, n));
+    else
+      newData = static_cast<uint8_t*>(Internal::allocMemory(n));
+
+    if (ASMJIT_UNLIKELY(!newData))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+  }
 
   cb->_data = newData;
   cb->_capacity = n;
@@ -369,10 +401,12 @@ class LabelByName {
 public:
   ASMJIT_INLINE LabelByName(const char* name, size_t nameLength, uint32_t hVal) noexcept
     : name(name),
-      nameLength(static_cast<uint32_t>(nameLength)) {}
+      nameLength(static_cast<uint32_t>(nameLength)),
+      hVal(hVal) {}
 
   ASMJIT_INLINE bool matches(const LabelEntry* entry) const noexcept {
-    return static_cast<uint32_t>(entry->getNameLength()) == nameLength &&
+    return entry->getHVal() == hVal &&
+           static_cast<uint32_t>(entry->getNameLength()) == nameLength &&
            ::memcmp(entry->getName(), name, nameLength) == 0;
   }
 
@@ -497,7 +531,7 @@ Error CodeHolder::newNamedLabelId(uint32_t& idOut, const char* name, size_t name
   le->_hVal = hVal;
   le->_setId(id);
   le->_type = static_cast<uint8_t>(type);
-  le->_parentId = 0;
+  le->_parentId = parentId;
   le->_sectionId = SectionEntry::kInvalidId;
   le->_offset = 0;
 
@@ -511,8 +545,9 @@ Error CodeHolder::newNamedLabelId(uint32_t& idOut, const char* name, size_t name
     le->_name.setExternal(nameExternal, nameLength);
   }
 
+  if (ASMJIT_UNLIKELY(!_namedLabels.put(le)))
+    return DebugUtils::errored(kErrorNoHeapMemory);
   _labels.appendUnsafe(le);
-  _namedLabels.put(le);
 
   idOut = id;
   return err;
@@ -522,6 +557,9 @@ uint32_t CodeHolder::getLabelIdByName(const char* name, size_t nameLength, uint3
   uint32_t hVal = CodeHolder_hashNameAndFixLen(name, nameLength);
   if (ASMJIT_UNLIKELY(!nameLength)) return 0;
 
+  // Local labels are hashed together with their parent, see `newNamedLabelId()`.
+  hVal ^= parentId;
+
   LabelEntry* le = _namedLabels.get(LabelByName(name, nameLength, hVal));
   return le ? le->getId() : static_cast<uint32_t>(0);
 }
@@ -599,7 +637,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
     // Make sure that the `RelocEntry` is correct, we don't want to write
     // out of bounds in `dst`.
     if (ASMJIT_UNLIKELY(codeOffset + re->getSize() > maxCodeSize))
-      return DebugUtils::errored(kErrorInvalidRelocEntry);
+      return 0;
 
     // Whether to use trampoline, can be only used if relocation type is `kRelocTrampoline`.
     bool useTrampoline = false;
@@ -616,12 +654,14 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
 
       case RelocEntry::kTypeAbsToRel: {
         ptr -= baseAddress + re->getSourceOffset() + re->getSize();
+        if (re->getSize() == 4 && !Utils::isInt32(static_cast<int64_t>(ptr)))
+          return 0;
         break;
       }
 
       case RelocEntry::kTypeTrampoline: {
         if (re->getSize() != 4)
-          return DebugUtils::errored(kErrorInvalidRelocEntry);
+          return 0;
 
         ptr -= baseAddress + re->getSourceOffset() + re->getSize();
         if (!Utils::isInt32(static_cast<int64_t>(ptr))) {
@@ -632,7 +672,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
       }
 
       default:
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
     }
 
     switch (re->getSize()) {
@@ -649,7 +689,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
         break;
 
       default:
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
     }
 
     // Handle the trampoline case.
@@ -667,7 +707,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
         byte1 = x86EncodeMod(0, 4, 5);
       }
       else {
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
       }
 
       // Patch `jmp/call` instruction.
@@ -502,6 +502,22 @@ public:
   //! Detach all code-generators attached and reset the \ref CodeHolder.
   ASMJIT_API void reset(bool releaseMemory = false) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Memory Management]
+  // --------------------------------------------------------------------------
+
+  //! Get the block cache used by the `CodeHolder`, or null if it has none.
+  ASMJIT_INLINE ZoneBlockCache* getBlockCache() const noexcept { return _baseZone.getBlockCache(); }
+
+  //! Set the block cache used by the `CodeHolder` and by `CodeEmitter`s that
+  //! are attached to it (can be null).
+  //!
+  //! Zones and section buffers take their memory from `cache` and return it
+  //! back when they are reset or destroyed. The cache must outlive the
+  //! `CodeHolder`, it's kept by `reset()`. The cache can only be changed if
+  //! the `CodeHolder` is not initialized.
+  ASMJIT_API Error setBlockCache(ZoneBlockCache* cache) noexcept;
+
   // --------------------------------------------------------------------------
   // [Attach / Detach]
   // --------------------------------------------------------------------------
@@ -703,7 +719,8 @@ public:
   //! \return The number bytes actually used. If the code emitter reserved
   //! space for possible trampolines, but didn't use it, the number of bytes
   //! used can actually be less than the expected worst case. Virtual memory
-  //! allocator can shrink the memory it allocated initially.
+  //! allocator can shrink the memory it allocated initially. Zero is returned
+  //! if a relocation entry is invalid or its target is out of its range.
   //!
   //! A given buffer will be overwritten, to get the number of bytes required,
   //! use `getCodeSize()`.
@@ -731,10 +748,10 @@ public:
   Zone _dataZone;                        //!< Data zone (used to allocate extra data like label names).
   ZoneHeap _baseHeap;                    //!< Zone allocator, used to manage internal containers.
 
-  ZoneVector<SectionEntry*> _sections;   //!< Section entries.
-  ZoneVector<LabelEntry*> _labels;       //!< Label entries (each label is stored here).
+  ZoneSmallVector<SectionEntry*, 4> _sections; //!< Section entries.
+  ZoneSmallVector<LabelEntry*, 16> _labels; //!< Label entries (each label is stored here).
   ZoneVector<RelocEntry*> _relocations;  //!< Relocation entries.
-  ZoneHash<LabelEntry> _namedLabels;     //!< Label name -> LabelEntry (only named labels).
+  ZoneOpenHash<LabelEntry> _namedLabels; //!< Label name -> LabelEntry (only named labels).
 };
 
 //! \}
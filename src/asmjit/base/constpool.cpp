@@ -18,109 +18,101 @@
 
 namespace asmjit {
 
-// Binary tree code is based on Julienne Walker's "Andersson Binary Trees"
-// article and implementation. However, only three operations are implemented -
-// get, insert and traverse.
-
 // ============================================================================
-// [asmjit::ConstPool::Tree - Ops]
+// [asmjit::ConstPool - Hash]
 // ============================================================================
 
 //! \internal
 //!
-//! Remove left horizontal links.
-static ASMJIT_INLINE ConstPool::Node* ConstPoolTree_skewNode(ConstPool::Node* node) noexcept {
-  ConstPool::Node* link = node->_link[0];
-  uint32_t level = node->_level;
-
-  if (level != 0 && link && link->_level == level) {
-    node->_link[0] = link->_link[1];
-    link->_link[1] = node;
-
-    node = link;
+//! Get a hash code of constant `data` of the given `size`.
+//!
+//! All sizes except 1 and 2 are multiples of 4, so the data is hashed by
+//! 32-bit words and the result is mixed, so the low bits used to index the
+//! table depend on all bits of the data.
+static ASMJIT_INLINE uint32_t ConstPool_hashData(const void* data, size_t size) noexcept {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint32_t hashCode = static_cast<uint32_t>(size);
+
+  if (size < 4) {
+    hashCode ^= static_cast<uint32_t>(p[0]) << 8;
+    if (size == 2)
+      hashCode ^= static_cast<uint32_t>(p[1]) << 16;
+  }
+  else {
+    for (size_t i = 0; i < size; i += 4) {
+      hashCode = (hashCode ^ Utils::readU32u(p + i)) * 0x9E3779B1U;
+      hashCode = (hashCode << 15) | (hashCode >> 17);
+    }
   }
 
-  return node;
+  hashCode ^= hashCode >> 16;
+  hashCode *= 0x85EBCA6BU;
+  hashCode ^= hashCode >> 13;
+  return hashCode;
 }
 
-//! \internal
-//!
-//! Remove consecutive horizontal links.
-static ASMJIT_INLINE ConstPool::Node* ConstPoolTree_splitNode(ConstPool::Node* node) noexcept {
-  ConstPool::Node* link = node->_link[1];
-  uint32_t level = node->_level;
-
-  if (level != 0 && link && link->_link[1] && link->_link[1]->_level == level) {
-    node->_link[1] = link->_link[0];
-    link->_link[0] = node;
-
-    node = link;
-    node->_level++;
-  }
+// ============================================================================
+// [asmjit::ConstPool::Table - Ops]
+// ============================================================================
 
-  return node;
-}
+ConstPool::Node* ConstPool::Table::get(const void* data, uint32_t hashCode) const noexcept {
+  if (_length == 0)
+    return nullptr;
 
-ConstPool::Node* ConstPool::Tree::get(const void* data) noexcept {
-  ConstPool::Node* node = _root;
+  Node** table = _data;
+  size_t mask = _capacity - 1;
   size_t dataSize = _dataSize;
+  size_t i = hashCode & mask;
 
-  while (node) {
-    int c = ::memcmp(node->getData(), data, dataSize);
-    if (c == 0)
+  for (;;) {
+    Node* node = table[i];
+    if (!node)
+      return nullptr;
+
+    if (node->_hashCode == hashCode && ::memcmp(node->getData(), data, dataSize) == 0)
       return node;
-    node = node->_link[c < 0];
-  }
 
-  return nullptr;
+    i = (i + 1) & mask;
+  }
 }
 
-void ConstPool::Tree::put(ConstPool::Node* newNode) noexcept {
-  size_t dataSize = _dataSize;
-  _length++;
+Error ConstPool::Table::put(Zone* zone, ConstPool::Node* newNode) noexcept {
+  // Grow when the table would be more than 3/4 full.
+  if ((_length + 1) * 4 > _capacity * 3) {
+    size_t newCapacity = _capacity ? _capacity * 2 : static_cast<size_t>(kInitialCapacity);
+    Node** newData = zone->allocZeroedT<Node*>(newCapacity * sizeof(Node*));
 
-  if (!_root) {
-    _root = newNode;
-    return;
-  }
+    if (ASMJIT_UNLIKELY(!newData))
+      return DebugUtils::errored(kErrorNoHeapMemory);
 
-  ConstPool::Node* node = _root;
-  ConstPool::Node* stack[kHeightLimit];
+    Node** oldData = _data;
+    size_t oldCapacity = _capacity;
+    size_t newMask = newCapacity - 1;
 
-  unsigned int top = 0;
-  unsigned int dir;
-
-  // Find a spot and save the stack.
-  for (;;) {
-    stack[top++] = node;
-    dir = ::memcmp(node->getData(), newNode->getData(), dataSize) < 0;
+    for (size_t i = 0; i < oldCapacity; i++) {
+      Node* node = oldData[i];
+      if (!node) continue;
 
-    ConstPool::Node* link = node->_link[dir];
-    if (!link) break;
+      size_t j = node->_hashCode & newMask;
+      while (newData[j])
+        j = (j + 1) & newMask;
+      newData[j] = node;
+    }
 
-    node = link;
+    // The old table is not released, it's part of the zone now.
+    _data = newData;
+    _capacity = newCapacity;
   }
 
-  // Link and rebalance.
-  node->_link[dir] = newNode;
-
-  while (top > 0) {
-    // Which child?
-    node = stack[--top];
-
-    if (top != 0) {
-      dir = stack[top - 1]->_link[1] == node;
-    }
+  size_t mask = _capacity - 1;
+  size_t i = newNode->_hashCode & mask;
 
-    node = ConstPoolTree_skewNode(node);
-    node = ConstPoolTree_splitNode(node);
+  while (_data[i])
+    i = (i + 1) & mask;
 
-    // Fix the parent.
-    if (top != 0)
-      stack[top - 1]->_link[dir] = node;
-    else
-      _root = node;
-  }
+  _data[i] = newNode;
+  _length++;
+  return kErrorOk;
 }
 
 // ============================================================================
@@ -138,9 +130,9 @@ void ConstPool::reset(Zone* zone) noexcept {
   _zone = zone;
 
   size_t dataSize = 1;
-  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(_tree); i++) {
-    _tree[i].reset();
-    _tree[i].setDataSize(dataSize);
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(_table); i++) {
+    _table[i].reset();
+    _table[i].setDataSize(dataSize);
     _gaps[i] = nullptr;
     dataSize <<= 1;
   }
@@ -174,8 +166,8 @@ static void ConstPool_addGap(ConstPool* self, size_t offset, size_t length) noex
     size_t gapIndex;
     size_t gapLength;
 
-      gapIndex = ConstPool::kIndex16;
     if (length >= 16 && Utils::isAligned<size_t>(offset, 16)) {
+      gapIndex = ConstPool::kIndex16;
       gapLength = 16;
     }
     else if (length >= 8 && Utils::isAligned<size_t>(offset, 8)) {
@@ -213,24 +205,27 @@ static void ConstPool_addGap(ConstPool* self, size_t offset, size_t length) noex
 }
 
 Error ConstPool::add(const void* data, size_t size, size_t& dstOffset) noexcept {
-  size_t treeIndex;
+  size_t tableIndex;
 
-  if (size == 32)
-    treeIndex = kIndex32;
+  if (size == 64)
+    tableIndex = kIndex64;
+  else if (size == 32)
+    tableIndex = kIndex32;
   else if (size == 16)
-    treeIndex = kIndex16;
+    tableIndex = kIndex16;
   else if (size == 8)
-    treeIndex = kIndex8;
+    tableIndex = kIndex8;
   else if (size == 4)
-    treeIndex = kIndex4;
+    tableIndex = kIndex4;
   else if (size == 2)
-    treeIndex = kIndex2;
+    tableIndex = kIndex2;
   else if (size == 1)
-    treeIndex = kIndex1;
+    tableIndex = kIndex1;
   else
     return DebugUtils::errored(kErrorInvalidArgument);
 
-  ConstPool::Node* node = _tree[treeIndex].get(data);
+  uint32_t hashCode = ConstPool_hashData(data, size);
+  ConstPool::Node* node = _table[tableIndex].get(data, hashCode);
   if (node) {
     dstOffset = node->_offset;
     return kErrorOk;
@@ -238,11 +233,14 @@ Error ConstPool::add(const void* data, size_t size, size_t& dstOffset) noexcept
 
   // Before incrementing the current offset try if there is a gap that can
   // be used for the requested data.
+  //
+  // Gaps are never larger than 16 bytes and a gap of a bigger size can be used
+  // as well, the rest of it is turned into smaller gaps.
   size_t offset = ~static_cast<size_t>(0);
-  size_t gapIndex = treeIndex;
+  size_t gapIndex = tableIndex;
 
-  while (gapIndex != kIndexCount - 1) {
-    ConstPool::Gap* gap = _gaps[treeIndex];
+  while (gapIndex <= kIndex16) {
+    ConstPool::Gap* gap = _gaps[gapIndex];
 
     // Check if there is a gap.
     if (gap) {
@@ -250,7 +248,7 @@ Error ConstPool::add(const void* data, size_t size, size_t& dstOffset) noexcept
       size_t gapLength = gap->_length;
 
       // Destroy the gap for now.
-      _gaps[treeIndex] = gap->_next;
+      _gaps[gapIndex] = gap->_next;
       ConstPool_freeGap(this, gap);
 
       offset = gapOffset;
@@ -258,7 +256,8 @@ Error ConstPool::add(const void* data, size_t size, size_t& dstOffset) noexcept
 
       gapLength -= size;
       if (gapLength > 0)
-        ConstPool_addGap(this, gapOffset, gapLength);
+        ConstPool_addGap(this, gapOffset + size, gapLength);
+      break;
     }
 
     gapIndex++;
@@ -279,32 +278,46 @@ Error ConstPool::add(const void* data, size_t size, size_t& dstOffset) noexcept
   }
 
   // Add the initial node to the right index.
-  node = ConstPool::Tree::_newNode(_zone, data, size, offset, false);
+  node = ConstPool::Table::_newNode(_zone, data, size, hashCode, offset, false);
   if (!node) return DebugUtils::errored(kErrorNoHeapMemory);
 
-  _tree[treeIndex].put(node);
+  ASMJIT_PROPAGATE(_table[tableIndex].put(_zone, node));
   _alignment = std::max<size_t>(_alignment, size);
 
   dstOffset = offset;
 
-  // Now create a bunch of shared constants that are based on the data pattern.
-  // We stop at size 4, it probably doesn't make sense to split constants down
-  // to 1 byte.
+  // Now create a bunch of shared constants that are based on the data pattern,
+  // so a smaller constant that matches a part of this one is not added again.
+  // All parts down to size 4 are shared. It probably doesn't make sense to
+  // split constants down to 1 byte, except broadcasts, which have only one
+  // distinct part of each size.
+  size_t dataSize = size;
   size_t pCount = 1;
-  while (size > 4) {
+
+  while (size > 1) {
+    const uint8_t* pData = static_cast<const uint8_t*>(data);
+
     size >>= 1;
     pCount <<= 1;
 
-    ASMJIT_ASSERT(treeIndex != 0);
-    treeIndex--;
+    ASMJIT_ASSERT(tableIndex != 0);
+    tableIndex--;
+
+    if (size < 4) {
+      if (::memcmp(pData, pData + size, dataSize - size) != 0)
+        break;
+      pCount = 1;
+    }
 
-    const uint8_t* pData = static_cast<const uint8_t*>(data);
     for (size_t i = 0; i < pCount; i++, pData += size) {
-      node = _tree[treeIndex].get(pData);
+      hashCode = ConstPool_hashData(pData, size);
+      node = _table[tableIndex].get(pData, hashCode);
       if (node) continue;
 
-      node = ConstPool::Tree::_newNode(_zone, pData, size, offset + (i * size), true);
-      _tree[treeIndex].put(node);
+      node = ConstPool::Table::_newNode(_zone, pData, size, hashCode, offset + (i * size), true);
+      if (!node) return DebugUtils::errored(kErrorNoHeapMemory);
+
+      ASMJIT_PROPAGATE(_table[tableIndex].put(_zone, node));
     }
   }
 
@@ -334,8 +347,8 @@ void ConstPool::fill(void* dst) const noexcept {
   ::memset(dst, 0, _size);
 
   ConstPoolFill filler(static_cast<uint8_t*>(dst), 1);
-  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(_tree); i++) {
-    _tree[i].iterate(filler);
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(_table); i++) {
+    _table[i].iterate(filler);
     filler._dataSize <<= 1;
   }
 }
@@ -501,6 +514,78 @@ UNIT(base_constpool) {
       "pool.getSize() - Expected pool alignment to be 32 bytes");
     EXPECT(offset == 32,
       "pool.getSize() - Expected offset returned to be 32");
+
+    pool.add(bytes, 2, offset);
+    EXPECT(offset == 2,
+      "pool.add() - Expected 2-byte constant to be reused");
+  }
+
+  INFO("Checking 64-byte constants and sharing of their parts");
+  {
+    pool.reset(&zone);
+    zone.reset();
+
+    uint8_t bytes[64];
+    size_t offset;
+
+    for (i = 0; i < 64; i++)
+      bytes[i] = static_cast<uint8_t>(i);
+
+    EXPECT(pool.add(bytes, 64, offset) == kErrorOk,
+      "pool.add() - Returned error");
+    EXPECT(offset == 0,
+      "pool.add() - Expected offset returned to be 0");
+    EXPECT(pool.getSize() == 64,
+      "pool.getSize() - Expected pool size to be 64 bytes");
+    EXPECT(pool.getAlignment() == 64,
+      "pool.getAlignment() - Expected pool alignment to be 64 bytes");
+
+    pool.add(bytes + 32, 32, offset);
+    EXPECT(offset == 32,
+      "pool.add() - Expected 32-byte part to be reused");
+
+    pool.add(bytes + 16, 16, offset);
+    EXPECT(offset == 16,
+      "pool.add() - Expected 16-byte part to be reused");
+
+    pool.add(bytes + 60, 4, offset);
+    EXPECT(offset == 60,
+      "pool.add() - Expected 4-byte part to be reused");
+
+    pool.add(bytes + 2, 2, offset);
+    EXPECT(offset == 64,
+      "pool.add() - Expected 2-byte part of non-broadcast not to be shared");
+
+    uint8_t broadcast[64];
+    ::memset(broadcast, 0x80, 64);
+
+    EXPECT(pool.add(broadcast, 64, offset) == kErrorOk,
+      "pool.add() - Returned error");
+    EXPECT(offset == 128,
+      "pool.add() - Expected offset returned to be 128");
+
+    pool.add(broadcast, 16, offset);
+    EXPECT(offset == 128,
+      "pool.add() - Expected 16-byte lane of broadcast to be reused");
+
+    pool.add(broadcast, 2, offset);
+    EXPECT(offset == 128,
+      "pool.add() - Expected 2-byte lane of broadcast to be reused");
+
+    pool.add(broadcast, 1, offset);
+    EXPECT(offset == 128,
+      "pool.add() - Expected 1-byte lane of broadcast to be reused");
+
+    EXPECT(pool.getSize() == 192,
+      "pool.getSize() - Expected pool size to be 192 bytes");
+
+    uint8_t out[192];
+    pool.fill(out);
+
+    EXPECT(::memcmp(out, bytes, 64) == 0 && ::memcmp(out + 128, broadcast, 64) == 0,
+      "pool.fill() - Filled incorrect data");
+    EXPECT(out[64] == 2 && out[65] == 3,
+      "pool.fill() - Filled incorrect data");
   }
 }
 #endif // ASMJIT_TEST
@@ -35,7 +35,8 @@ public:
     kIndex8 = 3,
     kIndex16 = 4,
     kIndex32 = 5,
-    kIndexCount = 6
+    kIndex64 = 6,
+    kIndexCount = 7
   };
 
   // --------------------------------------------------------------------------
@@ -57,47 +58,51 @@ public:
 
   //! \internal
   //!
-  //! Zone-allocated const-pool node.
+  //! Zone-allocated const-pool node, followed by the data of the constant.
   struct Node {
     ASMJIT_INLINE void* getData() const noexcept {
       return static_cast<void*>(const_cast<ConstPool::Node*>(this) + 1);
     }
 
-    Node* _link[2];                      //!< Left/Right nodes.
-    uint32_t _level : 31;                //!< Horizontal level for balance.
+    uint32_t _hashCode;                  //!< Hash code of the data.
     uint32_t _shared : 1;                //!< If this constant is shared with another.
-    uint32_t _offset;                    //!< Data offset from the beginning of the pool.
+    uint32_t _offset : 31;               //!< Data offset from the beginning of the pool.
   };
 
   // --------------------------------------------------------------------------
-  // [Tree]
+  // [Table]
   // --------------------------------------------------------------------------
 
   //! \internal
   //!
-  //! Zone-allocated const-pool tree.
-  struct Tree {
+  //! Zone-allocated const-pool hash table of nodes having the same data size.
+  //!
+  //! The table uses open addressing with linear probing, it never removes
+  //! nodes and grows when it's 3/4 full.
+  struct Table {
     enum {
-      //! Maximum tree height == log2(1 << 64).
-      kHeightLimit = 64
+      //! Initial capacity of the table, must be a power of 2.
+      kInitialCapacity = 16
     };
 
     // --------------------------------------------------------------------------
     // [Construction / Destruction]
     // --------------------------------------------------------------------------
 
-    ASMJIT_INLINE Tree(size_t dataSize = 0) noexcept
-      : _root(nullptr),
+    ASMJIT_INLINE Table(size_t dataSize = 0) noexcept
+      : _data(nullptr),
+        _capacity(0),
         _length(0),
         _dataSize(dataSize) {}
-    ASMJIT_INLINE ~Tree() {}
+    ASMJIT_INLINE ~Table() {}
 
     // --------------------------------------------------------------------------
     // [Reset]
     // --------------------------------------------------------------------------
 
     ASMJIT_INLINE void reset() noexcept {
-      _root = nullptr;
+      _data = nullptr;
+      _capacity = 0;
       _length = 0;
     }
 
@@ -117,8 +122,10 @@ public:
     // [Ops]
     // --------------------------------------------------------------------------
 
-    ASMJIT_API Node* get(const void* data) noexcept;
-    ASMJIT_API void put(Node* node) noexcept;
+    //! Get a node that holds `data` of the given `hashCode`.
+    ASMJIT_API Node* get(const void* data, uint32_t hashCode) const noexcept;
+    //! Put `node` to the table, the table must not contain the same data.
+    ASMJIT_API Error put(Zone* zone, Node* node) noexcept;
 
     // --------------------------------------------------------------------------
     // [Iterate]
@@ -126,33 +133,12 @@ public:
 
     template<typename Visitor>
     ASMJIT_INLINE void iterate(Visitor& visitor) const noexcept {
-      Node* node = const_cast<Node*>(_root);
-      if (!node) return;
-
-      Node* stack[kHeightLimit];
-      size_t top = 0;
-
-      for (;;) {
-        Node* left = node->_link[0];
-        if (left != nullptr) {
-          ASMJIT_ASSERT(top != kHeightLimit);
-          stack[top++] = node;
-
-          node = left;
-          continue;
-        }
+      Node** data = _data;
+      size_t capacity = _capacity;
 
-Visit:
-        visitor.visit(node);
-        node = node->_link[1];
-        if (node != nullptr)
-          continue;
-
-        if (top == 0)
-          return;
-
-        node = stack[--top];
-        goto Visit;
+      for (size_t i = 0; i < capacity; i++) {
+        Node* node = data[i];
+        if (node) visitor.visit(node);
       }
     }
 
@@ -160,13 +146,11 @@ Visit:
     // [Helpers]
     // --------------------------------------------------------------------------
 
-    static ASMJIT_INLINE Node* _newNode(Zone* zone, const void* data, size_t size, size_t offset, bool shared) noexcept {
+    static ASMJIT_INLINE Node* _newNode(Zone* zone, const void* data, size_t size, uint32_t hashCode, size_t offset, bool shared) noexcept {
       Node* node = zone->allocT<Node>(sizeof(Node) + size);
       if (ASMJIT_UNLIKELY(!node)) return nullptr;
 
-      node->_link[0] = nullptr;
-      node->_link[1] = nullptr;
-      node->_level = 1;
+      node->_hashCode = hashCode;
       node->_shared = shared;
       node->_offset = static_cast<uint32_t>(offset);
 
@@ -178,8 +162,9 @@ Visit:
     // [Members]
     // --------------------------------------------------------------------------
 
-    Node* _root;                         //!< Root of the tree
-    size_t _length;                      //!< Length of the tree (count of nodes).
+    Node** _data;                        //!< Slots of the table.
+    size_t _capacity;                    //!< Capacity of the table (count of slots).
+    size_t _length;                      //!< Length of the table (count of nodes).
     size_t _dataSize;                    //!< Size of the data.
   };
 
@@ -209,9 +194,9 @@ Visit:
 
   //! Add a constant to the constant pool.
   //!
-  //! The constant must have known size, which is 1, 2, 4, 8, 16 or 32 bytes.
-  //! The constant is added to the pool only if it doesn't not exist, otherwise
-  //! cached value is returned.
+  //! The constant must have known size, which is 1, 2, 4, 8, 16, 32 or 64
+  //! bytes. The constant is added to the pool only if it doesn't not exist,
+  //! otherwise cached value is returned.
   //!
   //! AsmJit is able to subdivide added constants, so for example if you add
   //! 8-byte constant 0x1122334455667788 it will create the following slots:
@@ -220,9 +205,14 @@ Visit:
   //!   4-byte: 0x11223344, 0x55667788
   //!
   //! The reason is that when combining MMX/SSE/AVX code some patterns are used
-  //! frequently. However, AsmJit is not able to reallocate a constant that has
-  //! been already added. For example if you try to add 4-byte constant and then
-  //! 8-byte constant having the same 4-byte pattern as the previous one, two
+  //! frequently, so a 16-byte constant that matches the low or high half of an
+  //! existing 32-byte or 64-byte constant is not added again. Constants are
+  //! normally not split to 2-byte and 1-byte slots, the exception is a constant
+  //! that is a broadcast of such slot, like `Data128::fromU8(0x80)`.
+  //!
+  //! However, AsmJit is not able to reallocate a constant that has been already
+  //! added. For example if you try to add 4-byte constant and then 8-byte
+  //! constant having the same 4-byte pattern as the previous one, two
   //! independent slots will be generated by the pool.
   ASMJIT_API Error add(const void* data, size_t size, size_t& dstOffset) noexcept;
 
@@ -238,7 +228,7 @@ Visit:
   // --------------------------------------------------------------------------
 
   Zone* _zone;                           //!< Zone allocator.
-  Tree _tree[kIndexCount];               //!< Tree per size.
+  Table _table[kIndexCount];             //!< Table per size.
   Gap* _gaps[kIndexCount];               //!< Gaps per size.
   Gap* _gapPool;                         //!< Gaps pool
 
@@ -871,7 +871,10 @@ struct FuncFrameInfo {
     kX86AttrAlignedVecSR  = 0x00010000U, //!< Use aligned save/restore of VEC regs.
     kX86AttrMmxCleanup    = 0x00020000U, //!< Emit EMMS instruction in epilog (X86).
     kX86AttrAvxCleanup    = 0x00040000U, //!< Emit VZEROUPPER instruction in epilog (X86).
-    kX86AttrAvxEnabled    = 0x00080000U  //!< Use AVX instead of SSE for all operations (X86).
+    kX86AttrAvxEnabled    = 0x00080000U, //!< Use AVX instead of SSE for all operations (X86).
+    kX86AttrAvx512Enabled = 0x00100000U, //!< Allocate XMM|YMM|ZMM registers 16-31 (X64 and AVX512-F).
+    kX86AttrAvx512VL      = 0x00200000U, //!< Allow XMM|YMM registers 16-31 in EVEX instructions (AVX512-VL).
+    kX86AttrVexPromotion  = 0x00400000U  //!< Re-encode SSE instructions as VEX (X86 and AVX).
   };
 
   // --------------------------------------------------------------------------
@@ -948,6 +951,27 @@ struct FuncFrameInfo {
   //! Disable AVX cleanup.
   ASMJIT_INLINE void disableAvx() noexcept { _attributes &= ~kX86AttrAvxEnabled; }
 
+  //! Get if SSE instructions are re-encoded as their VEX equivalents.
+  ASMJIT_INLINE bool isVexPromotionEnabled() const noexcept { return (_attributes & kX86AttrVexPromotion) != 0; }
+  //! Enable re-encoding of SSE instructions as VEX (requires AVX).
+  ASMJIT_INLINE void enableVexPromotion() noexcept { _attributes |= kX86AttrVexPromotion; }
+  //! Disable re-encoding of SSE instructions as VEX.
+  ASMJIT_INLINE void disableVexPromotion() noexcept { _attributes &= ~kX86AttrVexPromotion; }
+
+  //! Get if the register allocator can use all 32 XMM|YMM|ZMM registers (AVX-512).
+  ASMJIT_INLINE bool isAvx512Enabled() const noexcept { return (_attributes & kX86AttrAvx512Enabled) != 0; }
+  //! Enable allocation of XMM|YMM|ZMM registers 16-31.
+  ASMJIT_INLINE void enableAvx512() noexcept { _attributes |= kX86AttrAvx512Enabled; }
+  //! Disable allocation of XMM|YMM|ZMM registers 16-31.
+  ASMJIT_INLINE void disableAvx512() noexcept { _attributes &= ~kX86AttrAvx512Enabled; }
+
+  //! Get if XMM|YMM registers 16-31 can be used by EVEX instructions (AVX512-VL).
+  ASMJIT_INLINE bool isAvx512VLEnabled() const noexcept { return (_attributes & kX86AttrAvx512VL) != 0; }
+  //! Enable XMM|YMM registers 16-31 (requires also \ref enableAvx512()).
+  ASMJIT_INLINE void enableAvx512VL() noexcept { _attributes |= kX86AttrAvx512VL; }
+  //! Disable XMM|YMM registers 16-31, only ZMM registers can use them.
+  ASMJIT_INLINE void disableAvx512VL() noexcept { _attributes &= ~kX86AttrAvx512VL; }
+
   //! Get which registers (by `kind`) are saved/restored in prolog/epilog, respectively.
   ASMJIT_INLINE uint32_t getDirtyRegs(uint32_t kind) const noexcept {
     ASMJIT_ASSERT(kind < kMaxVRegKinds);
@@ -193,6 +193,15 @@ uint32_t OSUtils::getTickCount() noexcept {
 
   return ::GetTickCount();
 }
+
+uint64_t OSUtils::getTickCountUs() noexcept {
+  LARGE_INTEGER qpf, now;
+
+  if (!::QueryPerformanceFrequency(&qpf) || !::QueryPerformanceCounter(&now))
+    return uint64_t(::GetTickCount()) * 1000;
+
+  return static_cast<uint64_t>(double(now.QuadPart) * 1000000.0 / double(qpf.QuadPart));
+}
 #elif ASMJIT_OS_MAC
 uint32_t OSUtils::getTickCount() noexcept {
   static mach_timebase_info_data_t _machTime;
@@ -207,6 +216,15 @@ uint32_t OSUtils::getTickCount() noexcept {
   t = t * _machTime.numer / _machTime.denom;
   return static_cast<uint32_t>(t & 0xFFFFFFFFU);
 }
+
+uint64_t OSUtils::getTickCountUs() noexcept {
+  static mach_timebase_info_data_t _machTime;
+
+  if (ASMJIT_UNLIKELY(_machTime.denom == 0) || mach_timebase_info(&_machTime) != KERN_SUCCESS)
+    return 0;
+
+  return mach_absolute_time() * _machTime.numer / _machTime.denom / 1000;
+}
 #elif defined(_POSIX_MONOTONIC_CLOCK) && _POSIX_MONOTONIC_CLOCK >= 0
 uint32_t OSUtils::getTickCount() noexcept {
   struct timespec ts;
@@ -217,9 +235,19 @@ uint32_t OSUtils::getTickCount() noexcept {
   uint64_t t = (uint64_t(ts.tv_sec ) * 1000) + (uint64_t(ts.tv_nsec) / 1000000);
   return static_cast<uint32_t>(t & 0xFFFFFFFFU);
 }
+
+uint64_t OSUtils::getTickCountUs() noexcept {
+  struct timespec ts;
+
+  if (ASMJIT_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0))
+    return 0;
+
+  return (uint64_t(ts.tv_sec) * 1000000) + (uint64_t(ts.tv_nsec) / 1000);
+}
 #else
 #error "[asmjit] OSUtils::getTickCount() is not implemented for your target OS."
 uint32_t OSUtils::getTickCount() noexcept { return 0; }
+uint64_t OSUtils::getTickCountUs() noexcept { return 0; }
 #endif
 
 } // asmjit namespace
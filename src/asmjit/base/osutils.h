@@ -53,7 +53,8 @@ struct VMemInfo {
 //! OSUtils also provide a function `getTickCount()` that can be used for
 //! benchmarking purposes. It's similar to Windows-only `GetTickCount()`, but
 //! it's cross-platform and tries to be the most reliable platform specific
-//! calls to make the result usable.
+//! calls to make the result usable. `getTickCountUs()` has a microsecond
+//! resolution and is used to profile individual `CBPass` phases.
 struct OSUtils {
   // --------------------------------------------------------------------------
   // [Virtual Memory]
@@ -86,6 +87,8 @@ struct OSUtils {
 
   //! Get the current CPU tick count, used for benchmarking (1ms resolution).
   ASMJIT_API static uint32_t getTickCount() noexcept;
+  //! Get the current CPU tick count in microseconds, used for profiling.
+  ASMJIT_API static uint64_t getTickCountUs() noexcept;
 };
 
 // ============================================================================
@@ -12,6 +12,7 @@
 #if !defined(ASMJIT_DISABLE_COMPILER)
 
 // [Dependencies]
+#include "../base/osutils.h"
 #include "../base/regalloc_p.h"
 #include "../base/utils.h"
 
@@ -62,30 +63,62 @@ Error RAPass::process(Zone* zone) noexcept {
   return err;
 }
 
+//! \internal
+//!
+//! State of a phase measured by `RAPass_beginPhase()` and `RAPass_endPhase()`.
+struct RAPhaseStats {
+  uint64_t startTime;
+  size_t startZoneSize;
+};
+
+static ASMJIT_INLINE void RAPass_beginPhase(RAPass* self, RAPhaseStats& phase) noexcept {
+  phase.startZoneSize = self->_zone->getUsedSize();
+  phase.startTime = OSUtils::getTickCountUs();
+}
+
+static ASMJIT_NOINLINE Error RAPass_endPhase(RAPass* self, RAPhaseStats& phase, const char* name) noexcept {
+  uint64_t time = OSUtils::getTickCountUs() - phase.startTime;
+  size_t zoneSize = self->_zone->getUsedSize() - phase.startZoneSize;
+
+  // Nodes visited by the phase are the nodes of the function being compiled.
+  uint64_t nodeCount = 0;
+  for (CBNode* node = self->getFunc(); node != self->getStop(); node = node->getNext())
+    nodeCount++;
+
+  return self->cc()->addPassStats(name, 1, 1, time, nodeCount, zoneSize);
+}
+
 Error RAPass::compile(CCFunc* func) noexcept {
   ASMJIT_PROPAGATE(prepare(func));
 
+  bool stats = cc()->isPassStatsEnabled();
+  RAPhaseStats phase;
+
+#define RA_PHASE(NAME, CALL) \
+  if (ASMJIT_UNLIKELY(stats)) RAPass_beginPhase(this, phase); \
+  err = CALL; \
+  if (ASMJIT_UNLIKELY(stats) && !err) err = RAPass_endPhase(this, phase, NAME); \
+  if (err) break
+
   Error err;
   do {
-    err = fetch();
-    if (err) break;
-
-    err = removeUnreachableCode();
-    if (err) break;
+    RA_PHASE("Fetch", fetch());
+    RA_PHASE("Unreachable", removeUnreachableCode());
+    RA_PHASE("Liveness", livenessAnalysis());
 
-    err = livenessAnalysis();
-    if (err) break;
+    RA_PHASE("Coalesce", coalesce());
 
 #if !defined(ASMJIT_DISABLE_LOGGING)
     if (cc()->getGlobalOptions() & CodeEmitter::kOptionLoggingEnabled) {
-      err = annotate();
-      if (err) break;
+      RA_PHASE("Annotate", annotate());
     }
 #endif // !ASMJIT_DISABLE_LOGGING
 
-    err = translate();
+    RA_PHASE("Translate", translate());
   } while (false);
 
+#undef RA_PHASE
+
   cleanup();
 
   // We alter the compiler cursor, because it doesn't make sense to reference
@@ -122,6 +155,9 @@ Error RAPass::prepare(CCFunc* func) noexcept {
   _memVarTotal = 0;
   _memStackTotal = 0;
   _memAllTotal = 0;
+  _memVarShared = 0;
+
+  _flowPosition = 0;
   _annotationLength = 12;
 
   return kErrorOk;
@@ -179,6 +215,8 @@ RACell* RAPass::_newVarCell(VirtReg* vreg) {
     cell->offset = 0;
     cell->size = size;
     cell->alignment = size;
+    cell->rangeStart = ~static_cast<uint32_t>(0);
+    cell->rangeEnd = 0;
 
     _memVarCells = cell;
     _memMaxAlign = std::max<uint32_t>(_memMaxAlign, size);
@@ -233,6 +271,7 @@ RACell* RAPass::_newStackCell(uint32_t size, uint32_t alignment) {
     cell->offset = 0;
     cell->size = size;
     cell->alignment = alignment;
+    cell->makeFixed();
 
     *pPrev = cell;
     _memStackCellsUsed++;
@@ -244,42 +283,133 @@ RACell* RAPass::_newStackCell(uint32_t size, uint32_t alignment) {
   return cell;
 }
 
+//! \internal
+//!
+//! Orders variable cells by size (descending) and then by the start of their
+//! live range, which is the order in which `resolveCellOffsets()` assigns
+//! home slots.
+struct RACellOrder {
+  ASMJIT_INLINE bool operator()(const RACell* a, const RACell* b) const noexcept {
+    if (a->size != b->size)
+      return a->size > b->size;
+    return a->rangeStart < b->rangeStart;
+  }
+};
+
+//! \internal
+//!
+//! Extends live ranges of all variable cells by positions of nodes where
+//! their variables are live. Positions of nodes that accessed the cells
+//! during translation have been already added by `getVarCell()`. Returns
+//! false if the liveness information is incomplete, in that case no cell
+//! can share its home slot with another one.
+static bool RAPass_extendCellRanges(RAPass* self, VirtReg** vRegs, uint32_t count) {
+  CCFunc* func = self->getFunc();
+  CBNode* node = func;
+  CBNode* stop = self->getStop();
+
+  do {
+    if (node->hasPassData()) {
+      RABits* liveness = node->getPassData<RAData>()->liveness;
+      if (!liveness) {
+        // The exit label and the end of the function are not visited by the
+        // liveness analysis, but there is nothing alive at that point anyway.
+        if (node != func->getExitNode() && node != func->getEnd())
+          return false;
+      }
+      else {
+        uint32_t position = node->getPosition();
+        for (uint32_t i = 0; i < count; i++) {
+          VirtReg* vreg = vRegs[i];
+          if (liveness->getBit(vreg->_raId))
+            vreg->getMemCell()->addPosition(position);
+        }
+      }
+    }
+    node = node->getNext();
+  } while (node != stop);
+
+  return true;
+}
+
 Error RAPass::resolveCellOffsets() {
   RACell* varCell = _memVarCells;
   RACell* stackCell = _memStackCells;
 
-  uint32_t pos64 = 0;
-  uint32_t pos32 = pos64 + _mem64ByteVarsUsed * 64;
-  uint32_t pos16 = pos32 + _mem32ByteVarsUsed * 32;
-  uint32_t pos8  = pos16 + _mem16ByteVarsUsed * 16;
-  uint32_t pos4  = pos8  + _mem8ByteVarsUsed  * 8 ;
-  uint32_t pos2  = pos4  + _mem4ByteVarsUsed  * 4 ;
-  uint32_t pos1  = pos2  + _mem2ByteVarsUsed  * 2 ;
+  uint32_t varCount = _mem1ByteVarsUsed  + _mem2ByteVarsUsed  +
+                      _mem4ByteVarsUsed  + _mem8ByteVarsUsed  +
+                      _mem16ByteVarsUsed + _mem32ByteVarsUsed +
+                      _mem64ByteVarsUsed ;
+  uint32_t varPos = 0;
+
+  if (varCount) {
+    RACell** cells = _zone->allocT<RACell*>(varCount * sizeof(RACell*));
+    uint32_t* slots = _zone->allocT<uint32_t>(varCount * sizeof(uint32_t));
+
+    VirtReg** vRegs = _zone->allocT<VirtReg*>(varCount * sizeof(VirtReg*));
+    if (ASMJIT_UNLIKELY(!cells || !slots || !vRegs))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    // Collect variables that have a home slot and extend their live ranges.
+    VirtReg** virtArray = _contextVd.getData();
+    uint32_t virtCount = static_cast<uint32_t>(_contextVd.getLength());
+    uint32_t vRegCount = 0;
+
+    for (uint32_t i = 0; i < virtCount; i++) {
+      VirtReg* vreg = virtArray[i];
+      RACell* cell = vreg->getMemCell();
+      if (cell && !vreg->isStack()) {
+        if (vRegCount < varCount) vRegs[vRegCount] = vreg;
+        vRegCount++;
+      }
+    }
 
-  // Assign home slots.
-  while (varCell) {
-    uint32_t size = varCell->size;
-    uint32_t offset = 0;
+    uint32_t i = 0;
+    bool canShare = vRegCount == varCount && RAPass_extendCellRanges(this, vRegs, vRegCount);
 
-    switch (size) {
-      case  1: offset = pos1 ; pos1  += 1 ; break;
-      case  2: offset = pos2 ; pos2  += 2 ; break;
-      case  4: offset = pos4 ; pos4  += 4 ; break;
-      case  8: offset = pos8 ; pos8  += 8 ; break;
-      case 16: offset = pos16; pos16 += 16; break;
-      case 32: offset = pos32; pos32 += 32; break;
-      case 64: offset = pos64; pos64 += 64; break;
-
-      default:
-        ASMJIT_NOT_REACHED();
+    while (varCell) {
+      if (!canShare) varCell->makeFixed();
+      cells[i++] = varCell;
+      varCell = varCell->next;
     }
+    ASMJIT_ASSERT(i == varCount);
+
+    // Assign home slots. Cells are processed by size and by the start of their
+    // live ranges, so the first slot of the same size, which is no longer used,
+    // is always the best candidate (this is a greedy interval graph coloring).
+    // Each slot tracks the end of the live range of its last cell.
+    std::sort(cells, cells + varCount, RACellOrder());
+
+    uint32_t slotCount = 0;
+    uint32_t slotFirst = 0;
+
+    for (i = 0; i < varCount; i++) {
+      RACell* cell = cells[i];
+      uint32_t size = cell->size;
+
+      if (i > 0 && cells[i - 1]->size != size)
+        slotFirst = slotCount;
+
+      uint32_t slotIndex = slotFirst;
+      while (slotIndex < slotCount && slots[slotIndex] >= cell->rangeStart)
+        slotIndex++;
 
-    varCell->offset = static_cast<int32_t>(offset);
-    varCell = varCell->next;
+      if (slotIndex == slotCount) {
+        slotCount++;
+        varPos += size;
+      }
+
+      // Slots of the same size are consecutive and larger slots come first,
+      // so the offset of each slot is naturally aligned to its size.
+      slots[slotIndex] = cell->rangeEnd;
+      cell->offset = static_cast<int32_t>(varPos - (slotCount - slotIndex) * size);
+    }
   }
 
+  _memVarShared = varPos;
+
   // Assign stack slots.
-  uint32_t stackPos = pos1 + _mem1ByteVarsUsed;
+  uint32_t stackPos = varPos;
   while (stackCell) {
     uint32_t size = stackCell->size;
     uint32_t alignment = stackCell->alignment;
@@ -532,6 +662,477 @@ NoMem:
   return DebugUtils::errored(kErrorNoHeapMemory);
 }
 
+// ============================================================================
+// [asmjit::RAPass - Coalesce]
+// ============================================================================
+
+//! \internal
+static ASMJIT_INLINE TiedReg* RAPass_getTiedArray(RAPass* self, RAData* raData) {
+  return reinterpret_cast<TiedReg*>(reinterpret_cast<uint8_t*>(raData) + self->_varMapToVaListOffset);
+}
+
+//! \internal
+//!
+//! Live span of a virtual register, `start` and `end` (inclusive) are indexes
+//! of nodes that have liveness information.
+struct RALiveSpan {
+  uint32_t start;
+  uint32_t end;
+};
+
+//! \internal
+//!
+//! Sorted and non-overlapping live spans of a virtual register.
+struct RALiveSpans {
+  RALiveSpan* data;
+  uint32_t length;
+};
+
+//! \internal
+//!
+//! State of `RAPass::coalesce()`.
+struct RACoalesceContext {
+  CBNode** liveNodes;                    //!< Nodes that have liveness, null if removed.
+  uint32_t liveCount;                    //!< Number of nodes that have liveness.
+  uint32_t* parent;                      //!< Union-find parents of virtual registers.
+  RALiveSpans* spans;                    //!< Live spans of union-find roots.
+  RABits* copied;                        //!< Virtual registers used by copies.
+};
+
+//! \internal
+static ASMJIT_INLINE uint32_t RAPass_findFirstBit(uintptr_t word) noexcept {
+  uint32_t lo = static_cast<uint32_t>(word);
+  if (lo)
+    return Utils::findFirstBit(lo);
+  return 32 + Utils::findFirstBit(static_cast<uint32_t>(static_cast<uint64_t>(word) >> 32));
+}
+
+//! \internal
+//!
+//! Get the coalesced register `raId` was merged to.
+static ASMJIT_INLINE uint32_t RAPass_findRoot(uint32_t* parent, uint32_t raId) noexcept {
+  while (parent[raId] != raId) {
+    parent[raId] = parent[parent[raId]];
+    raId = parent[raId];
+  }
+  return raId;
+}
+
+//! \internal
+//!
+//! Build live spans of virtual registers used by copies, requires two passes
+//! over nodes that have liveness, the first counts spans, the second fills
+//! them.
+static Error RAPass_buildLiveSpans(RAPass* self, RACoalesceContext& ctx, uint32_t vdCount, uint32_t bLen) {
+  Zone* zone = self->_zone;
+  uint32_t* last = zone->allocT<uint32_t>(vdCount * sizeof(uint32_t));
+  uint32_t* counts = zone->allocZeroedT<uint32_t>(vdCount * sizeof(uint32_t));
+  RALiveSpans* spans = zone->allocT<RALiveSpans>(vdCount * sizeof(RALiveSpans));
+
+  if (ASMJIT_UNLIKELY(!last || !counts || !spans))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  uint32_t i, k, r;
+  uint32_t total = 0;
+
+  for (int fill = 0; fill < 2; fill++) {
+    for (r = 0; r < vdCount; r++)
+      last[r] = kInvalidValue;
+
+    for (k = 0; k < ctx.liveCount; k++) {
+      const RABits* liveness = ctx.liveNodes[k]->getPassData<RAData>()->liveness;
+
+      for (i = 0; i < bLen; i++) {
+        uintptr_t word = liveness->data[i] & ctx.copied->data[i];
+        while (word) {
+          r = i * RABits::kEntityBits + RAPass_findFirstBit(word);
+          word &= word - 1;
+
+          bool extends = last[r] != kInvalidValue && last[r] + 1 == k;
+          last[r] = k;
+
+          if (!fill) {
+            counts[r] += !extends;
+          }
+          else if (extends) {
+            spans[r].data[spans[r].length - 1].end = k;
+          }
+          else {
+            RALiveSpan& span = spans[r].data[spans[r].length++];
+            span.start = k;
+            span.end = k;
+          }
+        }
+      }
+    }
+
+    if (!fill) {
+      for (r = 0; r < vdCount; r++)
+        total += counts[r];
+
+      RALiveSpan* pool = zone->allocT<RALiveSpan>(total * sizeof(RALiveSpan));
+      if (ASMJIT_UNLIKELY(total && !pool))
+        return DebugUtils::errored(kErrorNoHeapMemory);
+
+      for (r = 0; r < vdCount; r++) {
+        spans[r].data = pool;
+        spans[r].length = 0;
+        pool += counts[r];
+      }
+    }
+  }
+
+  ctx.spans = spans;
+  return kErrorOk;
+}
+
+//! \internal
+//!
+//! Get whether coalesced registers `a` and `b` are alive at the same node.
+//! Copies between `a` and `b` (in any direction) don't cause interference.
+static bool RAPass_interferes(RAPass* self, RACoalesceContext& ctx, uint32_t a, uint32_t b) {
+  const RALiveSpans& aSpans = ctx.spans[a];
+  const RALiveSpans& bSpans = ctx.spans[b];
+
+  uint32_t i = 0;
+  uint32_t j = 0;
+
+  while (i < aSpans.length && j < bSpans.length) {
+    const RALiveSpan& aSpan = aSpans.data[i];
+    const RALiveSpan& bSpan = bSpans.data[j];
+
+    uint32_t start = aSpan.start > bSpan.start ? aSpan.start : bSpan.start;
+    uint32_t end = aSpan.end < bSpan.end ? aSpan.end : bSpan.end;
+
+    for (uint32_t k = start; k <= end; k++) {
+      CBNode* node = ctx.liveNodes[k];
+      if (!node) continue;
+
+      VirtReg* dst;
+      VirtReg* src;
+      if (!self->isCopyInst(node, &dst, &src))
+        return true;
+
+      uint32_t dstRoot = RAPass_findRoot(ctx.parent, dst->_raId);
+      uint32_t srcRoot = RAPass_findRoot(ctx.parent, src->_raId);
+      if (!((dstRoot == a && srcRoot == b) || (dstRoot == b && srcRoot == a)))
+        return true;
+    }
+
+    if (aSpan.end < bSpan.end)
+      i++;
+    else
+      j++;
+  }
+
+  return false;
+}
+
+//! \internal
+//!
+//! Merge live spans of `a` to `b`.
+static Error RAPass_mergeLiveSpans(RAPass* self, RACoalesceContext& ctx, uint32_t a, uint32_t b) {
+  const RALiveSpans& aSpans = ctx.spans[a];
+  RALiveSpans& bSpans = ctx.spans[b];
+
+  uint32_t capacity = aSpans.length + bSpans.length;
+  if (!aSpans.length || !capacity)
+    return kErrorOk;
+
+  RALiveSpan* data = self->_zone->allocT<RALiveSpan>(capacity * sizeof(RALiveSpan));
+  if (ASMJIT_UNLIKELY(!data))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t length = 0;
+
+  while (i < aSpans.length || j < bSpans.length) {
+    RALiveSpan span;
+    if (j == bSpans.length || (i < aSpans.length && aSpans.data[i].start < bSpans.data[j].start))
+      span = aSpans.data[i++];
+    else
+      span = bSpans.data[j++];
+
+    if (length && data[length - 1].end + 1 >= span.start) {
+      if (data[length - 1].end < span.end)
+        data[length - 1].end = span.end;
+    }
+    else
+      data[length++] = span;
+  }
+
+  bSpans.data = data;
+  bSpans.length = length;
+  return kErrorOk;
+}
+
+//! \internal
+static ASMJIT_INLINE void RAPass_renameOperand(RAPass* self, Operand_* op, const uint32_t* parent) {
+  ZoneSmallVector<VirtReg*, 16>& vds = self->_contextVd;
+  CodeCompiler* cc = self->cc();
+
+  uint32_t* ids[2];
+  uint32_t count = 0;
+
+  if (op->isReg()) {
+    ids[count++] = &op->_reg.id;
+  }
+  else if (op->isMem()) {
+    if (static_cast<Mem*>(op)->hasBaseReg()) ids[count++] = &op->_mem.base;
+    if (static_cast<Mem*>(op)->hasIndexReg()) ids[count++] = &op->_mem.index;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t id = *ids[i];
+    if (!Operand::isPackedId(id) || !cc->isVirtRegValid(id))
+      continue;
+
+    uint32_t raId = cc->getVirtRegById(id)->_raId;
+    if (raId < vds.getLength() && parent[raId] != raId)
+      *ids[i] = vds[parent[raId]]->getId();
+  }
+}
+
+//! \internal
+static ASMJIT_INLINE VirtReg* RAPass_renameVirtReg(RAPass* self, VirtReg* vreg, const uint32_t* parent) {
+  uint32_t raId = vreg ? vreg->_raId : kInvalidValue;
+  if (raId < self->_contextVd.getLength() && parent[raId] != raId)
+    return self->_contextVd[parent[raId]];
+  return vreg;
+}
+
+//! \internal
+//!
+//! Rename all coalesced virtual registers in all nodes of the function and
+//! merge their liveness. All entries of `parent` must be roots.
+static void RAPass_renameVirtRegs(RAPass* self, const uint32_t* parent, const RABits* renamed, uint32_t bLen) {
+  CBNode* node = self->getFunc();
+  CBNode* stop = self->getStop();
+
+  do {
+    if (node->hasPassData()) {
+      RAData* raData = node->getPassData<RAData>();
+      RABits* liveness = raData->liveness;
+
+      if (liveness) {
+        for (uint32_t i = 0; i < bLen; i++) {
+          uintptr_t word = liveness->data[i] & renamed->data[i];
+          liveness->data[i] ^= word;
+
+          while (word) {
+            uint32_t r = i * RABits::kEntityBits + RAPass_findFirstBit(word);
+            word &= word - 1;
+            liveness->setBit(parent[r]);
+          }
+        }
+      }
+
+      TiedReg* tiedArray = RAPass_getTiedArray(self, raData);
+      for (uint32_t i = 0; i < raData->tiedTotal; i++)
+        tiedArray[i].vreg = RAPass_renameVirtReg(self, tiedArray[i].vreg, parent);
+    }
+
+    switch (node->getType()) {
+      case CBNode::kNodeInst:
+      case CBNode::kNodeFuncCall: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        Operand* opArray = inst->getOpArray();
+        uint32_t opCount = inst->getOpCount();
+
+        for (uint32_t i = 0; i < opCount; i++)
+          RAPass_renameOperand(self, &opArray[i], parent);
+
+        RegOnly& extraReg = inst->getExtraReg();
+        if (extraReg.isValid() && extraReg.isVirtReg()) {
+          VirtReg* vreg = self->cc()->getVirtRegById(extraReg.getId());
+          VirtReg* renamedReg = RAPass_renameVirtReg(self, vreg, parent);
+          if (renamedReg != vreg)
+            extraReg.init(extraReg.getSignature(), renamedReg->getId());
+        }
+
+        if (node->getType() == CBNode::kNodeFuncCall) {
+          CCFuncCall* call = static_cast<CCFuncCall*>(node);
+          uint32_t argCount = call->getDetail().getArgCount();
+
+          for (uint32_t i = 0; i < argCount; i++)
+            RAPass_renameOperand(self, &call->_args[i], parent);
+
+          RAPass_renameOperand(self, &call->_ret[0], parent);
+          RAPass_renameOperand(self, &call->_ret[1], parent);
+        }
+        break;
+      }
+
+      case CBNode::kNodeFuncExit: {
+        CCFuncRet* ret = static_cast<CCFuncRet*>(node);
+        RAPass_renameOperand(self, &ret->_ret[0], parent);
+        RAPass_renameOperand(self, &ret->_ret[1], parent);
+        break;
+      }
+
+      case CBNode::kNodePushArg: {
+        CCPushArg* arg = static_cast<CCPushArg*>(node);
+        arg->_src = RAPass_renameVirtReg(self, arg->_src, parent);
+        arg->_cvt = RAPass_renameVirtReg(self, arg->_cvt, parent);
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    node = node->getNext();
+  } while (node != stop);
+}
+
+Error RAPass::coalesce() {
+  uint32_t vdCount = static_cast<uint32_t>(_contextVd.getLength());
+  uint32_t bLen = static_cast<uint32_t>(
+    ((vdCount + RABits::kEntityBits - 1) / RABits::kEntityBits));
+
+  // No variables.
+  if (bLen == 0)
+    return kErrorOk;
+
+  CCFunc* func = getFunc();
+  CBNode* stop = getStop();
+
+  // Collect virtual registers that must keep their identity. Function
+  // arguments can still absorb other registers, but can't be renamed.
+  RACoalesceContext ctx;
+  RABits* keep = newBits(bLen);
+  RABits* args = newBits(bLen);
+
+  ctx.liveCount = 0;
+  ctx.copied = newBits(bLen);
+
+  if (ASMJIT_UNLIKELY(!keep || !args || !ctx.copied))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  uint32_t i;
+  uint32_t argCount = func->getArgCount();
+
+  for (i = 0; i < argCount; i++) {
+    VirtReg* vreg = func->getArg(i);
+    if (vreg && vreg->_raId != kInvalidValue)
+      args->setBit(vreg->_raId);
+  }
+
+  bool anyCopy = false;
+  CBNode* node = func;
+
+  do {
+    if (node->hasPassData()) {
+      RAData* raData = node->getPassData<RAData>();
+      TiedReg* tiedArray = RAPass_getTiedArray(this, raData);
+
+      bool isHint = node->getType() == CBNode::kNodeHint;
+      for (i = 0; i < raData->tiedTotal; i++) {
+        TiedReg* tied = &tiedArray[i];
+        if (isHint || (tied->flags & (TiedReg::kRMem | TiedReg::kWMem)))
+          keep->setBit(tied->vreg->_raId);
+      }
+
+      VirtReg* dst;
+      VirtReg* src;
+
+      ctx.liveCount += raData->liveness != nullptr;
+      if (isCopyInst(node, &dst, &src)) {
+        ctx.copied->setBit(dst->_raId);
+        ctx.copied->setBit(src->_raId);
+        anyCopy = true;
+      }
+    }
+    node = node->getNext();
+  } while (node != stop);
+
+  if (!anyCopy)
+    return kErrorOk;
+
+  // Liveness of each virtual register is turned into spans of indexes of
+  // nodes once, coalescing then only checks and merges spans, and renames
+  // all registers in a single pass at the end.
+  ctx.liveNodes = _zone->allocT<CBNode*>(ctx.liveCount * sizeof(CBNode*));
+  ctx.parent = _zone->allocT<uint32_t>(vdCount * sizeof(uint32_t));
+
+  if (ASMJIT_UNLIKELY((ctx.liveCount && !ctx.liveNodes) || !ctx.parent))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  for (i = 0; i < vdCount; i++)
+    ctx.parent[i] = i;
+
+  uint32_t k = 0;
+  node = func;
+
+  do {
+    if (node->hasPassData() && node->getPassData<RAData>()->liveness)
+      ctx.liveNodes[k++] = node;
+    node = node->getNext();
+  } while (node != stop);
+
+  ASMJIT_PROPAGATE(RAPass_buildLiveSpans(this, ctx, vdCount, bLen));
+
+  // Coalesce.
+  bool anyMerged = false;
+
+  k = 0;
+  node = func;
+
+  do {
+    CBNode* next = node->getNext();
+    VirtReg* dst;
+    VirtReg* src;
+
+    if (node->hasPassData()) {
+      // Index of this node in `liveNodes`, if it has liveness.
+      uint32_t liveIndex = node->getPassData<RAData>()->liveness ? k++ : kInvalidValue;
+
+      if (isCopyInst(node, &dst, &src)) {
+        uint32_t dstRAId = RAPass_findRoot(ctx.parent, dst->_raId);
+        uint32_t srcRAId = RAPass_findRoot(ctx.parent, src->_raId);
+        bool remove = false;
+
+        if (dstRAId == srcRAId) {
+          // Copy to itself (a result of previous coalescing).
+          remove = true;
+        }
+        else if (!keep->getBit(dstRAId) && !keep->getBit(srcRAId) && !args->getBit(dstRAId) &&
+                 !RAPass_interferes(this, ctx, dstRAId, srcRAId)) {
+          ASMJIT_PROPAGATE(RAPass_mergeLiveSpans(this, ctx, dstRAId, srcRAId));
+          ctx.parent[dstRAId] = srcRAId;
+          anyMerged = true;
+          remove = true;
+        }
+
+        if (remove) {
+          if (liveIndex != kInvalidValue)
+            ctx.liveNodes[liveIndex] = nullptr;
+          cc()->removeNode(node);
+        }
+      }
+    }
+
+    node = next;
+  } while (node != stop);
+
+  if (!anyMerged)
+    return kErrorOk;
+
+  RABits* renamed = newBits(bLen);
+  if (ASMJIT_UNLIKELY(!renamed))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  for (i = 0; i < vdCount; i++) {
+    ctx.parent[i] = RAPass_findRoot(ctx.parent, i);
+    if (ctx.parent[i] != i)
+      renamed->setBit(i);
+  }
+
+  RAPass_renameVirtRegs(this, ctx.parent, renamed, bLen);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::RAPass - Annotate]
 // ============================================================================
@@ -12,6 +12,7 @@
 #if !defined(ASMJIT_DISABLE_COMPILER)
 
 // [Dependencies]
+#include "../base/bitops.h"
 #include "../base/codecompiler.h"
 #include "../base/zone.h"
 
@@ -172,7 +173,7 @@ struct RABits {
   // --------------------------------------------------------------------------
 
   enum {
-    kEntitySize = static_cast<int>(sizeof(uintptr_t)),
+    kEntitySize = static_cast<int>(sizeof(BitOps::Word)),
     kEntityBits = kEntitySize * 8
   };
 
@@ -198,13 +199,7 @@ struct RABits {
 
   //! Copy bits from `s0`, returns `true` if at least one bit is set in `s0`.
   ASMJIT_INLINE bool copyBits(const RABits* s0, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::copy(data, s0->data, len);
   }
 
   ASMJIT_INLINE bool addBits(const RABits* s0, uint32_t len) noexcept {
@@ -212,13 +207,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool addBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] | s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::or_(data, s0->data, s1->data, len);
   }
 
   ASMJIT_INLINE bool andBits(const RABits* s1, uint32_t len) noexcept {
@@ -226,13 +215,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool andBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] & s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::and_(data, s0->data, s1->data, len);
   }
 
   ASMJIT_INLINE bool delBits(const RABits* s1, uint32_t len) noexcept {
@@ -240,13 +223,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool delBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] & ~s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::andNot(data, s0->data, s1->data, len);
   }
 
   ASMJIT_INLINE bool _addBitsDelSource(RABits* s1, uint32_t len) noexcept {
@@ -254,25 +231,14 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool _addBitsDelSource(const RABits* s0, RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t a = s0->data[i];
-      uintptr_t b = s1->data[i];
-
-      this->data[i] = a | b;
-      b &= ~a;
-
-      s1->data[i] = b;
-      r |= b;
-    }
-    return r != 0;
+    return BitOps::orDelSource(data, s0->data, s1->data, len);
   }
 
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
 
-  uintptr_t data[1];
+  BitOps::Word data[1];
 };
 
 // ============================================================================
@@ -280,11 +246,30 @@ struct RABits {
 // ============================================================================
 
 //! Register allocator's (RA) memory cell.
+//!
+//! Cells used to spill variables track the range of node positions in which
+//! their content matters (`rangeStart` to `rangeEnd`, inclusive). Cells that
+//! have non-overlapping ranges can share the same home slot, see
+//! `RAPass::resolveCellOffsets()`.
 struct RACell {
+  //! Make the cell alive in the whole function so it never shares its slot.
+  ASMJIT_INLINE void makeFixed() noexcept {
+    rangeStart = 0;
+    rangeEnd = ~static_cast<uint32_t>(0);
+  }
+
+  //! Extend the cell's live range so it includes `position`.
+  ASMJIT_INLINE void addPosition(uint32_t position) noexcept {
+    if (position < rangeStart) rangeStart = position;
+    if (position > rangeEnd) rangeEnd = position;
+  }
+
   RACell* next;                          //!< Next active cell.
   int32_t offset;                        //!< Cell offset, relative to base-offset.
   uint32_t size;                         //!< Cell size.
   uint32_t alignment;                    //!< Cell alignment.
+  uint32_t rangeStart;                   //!< First position where the cell is used.
+  uint32_t rangeEnd;                     //!< Last position where the cell is used.
 };
 
 // ============================================================================
@@ -403,9 +388,17 @@ public:
   RACell* _newVarCell(VirtReg* vreg);
   RACell* _newStackCell(uint32_t size, uint32_t alignment);
 
+  //! Get a memory cell of `vreg`, create it if it doesn't exist yet. The
+  //! cell's live range is extended by the current `_flowPosition`.
   ASMJIT_INLINE RACell* getVarCell(VirtReg* vreg) {
     RACell* cell = vreg->getMemCell();
-    return cell ? cell : _newVarCell(vreg);
+    if (!cell) {
+      cell = _newVarCell(vreg);
+      if (ASMJIT_UNLIKELY(!cell)) return nullptr;
+    }
+
+    cell->addPosition(_flowPosition);
+    return cell;
   }
 
   virtual Error resolveCellOffsets();
@@ -496,6 +489,25 @@ public:
   //! repeats until all variables are resolved.
   virtual Error livenessAnalysis();
 
+  // --------------------------------------------------------------------------
+  // [Coalesce]
+  // --------------------------------------------------------------------------
+
+  //! Get whether `node` is a plain register copy `dst <- src`, which could be
+  //! removed if both virtual registers are coalesced into one.
+  virtual bool isCopyInst(CBNode* node, VirtReg** dst, VirtReg** src) = 0;
+
+  //! Coalesce virtual registers linked by copies.
+  //!
+  //! Coalescing is conservative - a copy is removed only if its destination
+  //! and source registers are never alive at the same time (except the copy
+  //! itself). Live spans of registers used by copies are built once from the
+  //! liveness, and coalesced registers are renamed and their liveness merged
+  //! by a single pass over the function at the end. Registers that are
+  //! used by hints (\ref CCHint), accessed through their home memory, or
+  //! passed as function arguments are never renamed.
+  virtual Error coalesce();
+
   // --------------------------------------------------------------------------
   // [Annotate]
   // --------------------------------------------------------------------------
@@ -534,7 +546,7 @@ public:
   ZoneList<CBNode*> _returningList;       //!< Returning nodes.
   ZoneList<CBNode*> _jccList;             //!< Jump nodes.
 
-  ZoneVector<VirtReg*> _contextVd;       //!< All variables used by the current function.
+  ZoneSmallVector<VirtReg*, 16> _contextVd; //!< All variables used by the current function.
   RACell* _memVarCells;                  //!< Memory used to spill variables.
   RACell* _memStackCells;                //!< Memory used to allocate memory on the stack.
 
@@ -551,6 +563,9 @@ public:
   uint32_t _memVarTotal;                 //!< Count of bytes used by variables.
   uint32_t _memStackTotal;               //!< Count of bytes used by stack.
   uint32_t _memAllTotal;                 //!< Count of bytes used by variables and stack after alignment.
+  uint32_t _memVarShared;                //!< Count of bytes used by variables after slot sharing.
+
+  uint32_t _flowPosition;                //!< Position of the node being translated.
 
   uint32_t _annotationLength;            //!< Default length of an annotated instruction.
   RAState* _state;                       //!< Current RA state.
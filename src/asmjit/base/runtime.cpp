@@ -11,6 +11,7 @@
 #include "../base/assembler.h"
 #include "../base/cpuinfo.h"
 #include "../base/runtime.h"
+#include "../base/utils.h"
 
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
@@ -100,7 +101,14 @@ void HostRuntime::flush(const void* p, size_t size) noexcept {
 // [asmjit::JitRuntime - Construction / Destruction]
 // ============================================================================
 
-JitRuntime::JitRuntime() noexcept {}
+JitRuntime::JitRuntime() noexcept
+  : _constZone(8192 - Zone::kZoneOverhead),
+    _constHeap(&_constZone),
+    _constHash(&_constHeap),
+    _constPtr(nullptr),
+    _constEnd(nullptr) {
+  ::memset(_constFree, 0, sizeof(_constFree));
+}
 JitRuntime::~JitRuntime() noexcept {}
 
 // ============================================================================
@@ -141,6 +149,117 @@ Error JitRuntime::_release(void* p) noexcept {
   return _memMgr.release(p);
 }
 
+// ============================================================================
+// [asmjit::JitRuntime - Shared Constants]
+// ============================================================================
+
+//! \internal
+//!
+//! Key used to find a shared constant.
+struct JitConstKey {
+  ASMJIT_INLINE JitConstKey(const void* data, uint32_t size) noexcept
+    : data(data),
+      size(size),
+      hVal(Utils::hashString(static_cast<const char*>(data), size)) {}
+
+  ASMJIT_INLINE bool matches(const JitRuntime::ConstNode* node) const noexcept {
+    return node->_size == size && ::memcmp(node->_ptr, data, size) == 0;
+  }
+
+  const void* data;
+  uint32_t size;
+  uint32_t hVal;
+};
+
+static ASMJIT_INLINE uint32_t JitRuntime_getConstSizeIndex(size_t size) noexcept {
+  if (size == 0 || size > 64 || !Utils::isPowerOf2(size))
+    return static_cast<uint32_t>(Globals::kInvalidIndex);
+  return Utils::findFirstBit(static_cast<uint32_t>(size));
+}
+
+Error JitRuntime::addConst(const void** dst, const void* data, size_t size, uint32_t allocType) noexcept {
+  uint32_t sizeIndex = JitRuntime_getConstSizeIndex(size);
+  if (ASMJIT_UNLIKELY(sizeIndex == static_cast<uint32_t>(Globals::kInvalidIndex))) {
+    *dst = nullptr;
+    return DebugUtils::errored(kErrorInvalidArgument);
+  }
+
+  AutoLock locked(_constLock);
+  JitConstKey key(data, static_cast<uint32_t>(size));
+
+  ConstNode* node = _constHash.get(key);
+  if (node) {
+    // Zero reference count means a permanent constant.
+    if (allocType == VMemMgr::kAllocPermanent)
+      node->_refCount = 0;
+    else if (node->_refCount != 0)
+      node->_refCount++;
+
+    *dst = node->_ptr;
+    return kErrorOk;
+  }
+
+  // Reuse the space of a released constant of the same size if possible.
+  node = _constFree[sizeIndex];
+  if (node) {
+    _constFree[sizeIndex] = node->_freeNext;
+  }
+  else {
+    uint8_t* p = Utils::alignTo<uint8_t*>(_constPtr, size);
+    if (!p || p + size > _constEnd) {
+      p = static_cast<uint8_t*>(_memMgr.alloc(kConstBlockSize, VMemMgr::kAllocPermanent));
+      if (ASMJIT_UNLIKELY(!p)) {
+        *dst = nullptr;
+        return DebugUtils::errored(kErrorNoVirtualMemory);
+      }
+
+      _constEnd = p + kConstBlockSize;
+      p = Utils::alignTo<uint8_t*>(p, size);
+    }
+
+    node = _constZone.allocT<ConstNode>();
+    if (ASMJIT_UNLIKELY(!node)) {
+      *dst = nullptr;
+      return DebugUtils::errored(kErrorNoHeapMemory);
+    }
+
+    node->_ptr = p;
+    node->_size = static_cast<uint32_t>(size);
+    _constPtr = p + size;
+  }
+
+  ::memcpy(node->_ptr, data, size);
+  node->_hashNext = nullptr;
+  node->_hVal = key.hVal;
+  node->_freeNext = nullptr;
+  node->_refCount = allocType == VMemMgr::kAllocPermanent ? 0 : 1;
+
+  _constHash.put(node);
+  *dst = node->_ptr;
+  return kErrorOk;
+}
+
+Error JitRuntime::releaseConst(const void* p, size_t size) noexcept {
+  uint32_t sizeIndex = JitRuntime_getConstSizeIndex(size);
+  if (ASMJIT_UNLIKELY(sizeIndex == static_cast<uint32_t>(Globals::kInvalidIndex) || !p))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  AutoLock locked(_constLock);
+  JitConstKey key(p, static_cast<uint32_t>(size));
+
+  ConstNode* node = _constHash.get(key);
+  if (ASMJIT_UNLIKELY(!node || node->_ptr != p))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (node->_refCount == 0 || --node->_refCount != 0)
+    return kErrorOk;
+
+  _constHash.del(node);
+  node->_freeNext = _constFree[sizeIndex];
+  _constFree[sizeIndex] = node;
+  return kErrorOk;
+}
+
 } // asmjit namespace
 
 // [Api-End]
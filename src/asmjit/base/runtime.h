@@ -10,7 +10,9 @@
 
 // [Dependencies]
 #include "../base/codeholder.h"
+#include "../base/osutils.h"
 #include "../base/vmem.h"
+#include "../base/zone.h"
 
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
@@ -151,6 +153,23 @@ class ASMJIT_VIRTAPI JitRuntime : public HostRuntime {
 public:
   ASMJIT_NONCOPYABLE(JitRuntime)
 
+  enum {
+    //! Number of sizes of shared constants (1, 2, 4, 8, 16, 32 and 64 bytes).
+    kConstSizeCount = 7,
+    //! Size of a block of virtual memory that holds shared constants.
+    kConstBlockSize = 4096
+  };
+
+  //! \internal
+  //!
+  //! Shared constant.
+  struct ConstNode : public ZoneHashNode {
+    uint8_t* _ptr;                       //!< Address of the constant.
+    ConstNode* _freeNext;                //!< Next released node of the same size.
+    uint32_t _size;                      //!< Size of the constant.
+    uint32_t _refCount;                  //!< Reference count, zero if permanent.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -179,12 +198,52 @@ public:
   ASMJIT_API Error _add(void** dst, CodeHolder* code) noexcept override;
   ASMJIT_API Error _release(void* p) noexcept override;
 
+  // --------------------------------------------------------------------------
+  // [Shared Constants]
+  // --------------------------------------------------------------------------
+
+  //! Add a read-only constant shared by all functions of the runtime and get
+  //! its address in `dst`.
+  //!
+  //! The constant must have 1, 2, 4, 8, 16, 32 or 64 bytes and it's aligned to
+  //! its size. Constants are deduplicated, adding data that was already added
+  //! returns the same address and increments its reference count. Constants
+  //! are stored in the memory managed by `VMemMgr`, which keeps them close to
+  //! the code, so 64-bit code can address them relative to RIP. Use a memory
+  //! operand created by `x86::ptr_rel()` to refer to a shared constant:
+  //!
+  //! ~~~
+  //! const void* p;
+  //! rt.addConst(&p, &data, 16);
+  //!
+  //! cc.movaps(xmm0, x86::ptr_rel((uint64_t)p, 16));
+  //! ~~~
+  //!
+  //! Each `addConst()` of `VMemMgr::kAllocFreeable` type has to be paired with
+  //! `releaseConst()` when the code that uses the constant is released, the
+  //! space of a constant is reused when it's no longer referenced. A constant
+  //! added as `VMemMgr::kAllocPermanent` is never released.
+  ASMJIT_API Error addConst(const void** dst, const void* data, size_t size, uint32_t allocType = VMemMgr::kAllocFreeable) noexcept;
+  //! Release a constant `p` of `size` added by `addConst()`.
+  ASMJIT_API Error releaseConst(const void* p, size_t size) noexcept;
+
+  //! Get the number of shared constants.
+  ASMJIT_INLINE size_t getConstCount() const noexcept { return _constHash.getSize(); }
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
 
   //! Virtual memory manager.
   VMemMgr _memMgr;
+
+  Lock _constLock;                       //!< Lock that protects shared constants.
+  Zone _constZone;                       //!< Zone used to allocate `ConstNode`s.
+  ZoneHeap _constHeap;                   //!< Heap used by `_constHash`.
+  ZoneHash<ConstNode> _constHash;        //!< Shared constants.
+  ConstNode* _constFree[kConstSizeCount];//!< Released constants per size, their space is reused.
+  uint8_t* _constPtr;                    //!< Current position in the block of constants.
+  uint8_t* _constEnd;                    //!< End of the block of constants.
 };
 
 //! \}
@@ -1064,6 +1064,295 @@ union Data256 {
   double df[4];
 };
 
+// ============================================================================
+// [asmjit::Data512]
+// ============================================================================
+
+//! 512-bit data useful for creating SIMD constants.
+//!
+//! Only broadcasts and 32-bit and 64-bit lanes can be set by factories, use
+//! `ub[]` or `uw[]` to set 8-bit and 16-bit lanes.
+union Data512 {
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Set all sixty four 8-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI8(int8_t x0) noexcept {
+    Data512 self;
+    self.setI8(x0);
+    return self;
+  }
+
+  //! Set all sixty four 8-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU8(uint8_t x0) noexcept {
+    Data512 self;
+    self.setU8(x0);
+    return self;
+  }
+
+  //! Set all thirty two 16-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI16(int16_t x0) noexcept {
+    Data512 self;
+    self.setI16(x0);
+    return self;
+  }
+
+  //! Set all thirty two 16-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU16(uint16_t x0) noexcept {
+    Data512 self;
+    self.setU16(x0);
+    return self;
+  }
+
+  //! Set all sixteen 32-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI32(int32_t x0) noexcept {
+    Data512 self;
+    self.setI32(x0);
+    return self;
+  }
+
+  //! Set all sixteen 32-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU32(uint32_t x0) noexcept {
+    Data512 self;
+    self.setU32(x0);
+    return self;
+  }
+
+  //! Set all sixteen 32-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI32(
+    int32_t x0, int32_t x1, int32_t x2 , int32_t x3 , int32_t x4 , int32_t x5 , int32_t x6 , int32_t x7 ,
+    int32_t x8, int32_t x9, int32_t x10, int32_t x11, int32_t x12, int32_t x13, int32_t x14, int32_t x15) noexcept {
+
+    Data512 self;
+    self.setI32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15);
+    return self;
+  }
+
+  //! Set all sixteen 32-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU32(
+    uint32_t x0, uint32_t x1, uint32_t x2 , uint32_t x3 , uint32_t x4 , uint32_t x5 , uint32_t x6 , uint32_t x7 ,
+    uint32_t x8, uint32_t x9, uint32_t x10, uint32_t x11, uint32_t x12, uint32_t x13, uint32_t x14, uint32_t x15) noexcept {
+
+    Data512 self;
+    self.setU32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15);
+    return self;
+  }
+
+  //! Set all eight 64-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI64(int64_t x0) noexcept {
+    Data512 self;
+    self.setI64(x0);
+    return self;
+  }
+
+  //! Set all eight 64-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU64(uint64_t x0) noexcept {
+    Data512 self;
+    self.setU64(x0);
+    return self;
+  }
+
+  //! Set all eight 64-bit signed integers.
+  static ASMJIT_INLINE Data512 fromI64(
+    int64_t x0, int64_t x1, int64_t x2, int64_t x3,
+    int64_t x4, int64_t x5, int64_t x6, int64_t x7) noexcept {
+
+    Data512 self;
+    self.setI64(x0, x1, x2, x3, x4, x5, x6, x7);
+    return self;
+  }
+
+  //! Set all eight 64-bit unsigned integers.
+  static ASMJIT_INLINE Data512 fromU64(
+    uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3,
+    uint64_t x4, uint64_t x5, uint64_t x6, uint64_t x7) noexcept {
+
+    Data512 self;
+    self.setU64(x0, x1, x2, x3, x4, x5, x6, x7);
+    return self;
+  }
+
+  //! Set all sixteen SP-FP floats.
+  static ASMJIT_INLINE Data512 fromF32(float x0) noexcept {
+    Data512 self;
+    self.setF32(x0);
+    return self;
+  }
+
+  //! Set all sixteen SP-FP floats.
+  static ASMJIT_INLINE Data512 fromF32(
+    float x0, float x1, float x2 , float x3 , float x4 , float x5 , float x6 , float x7 ,
+    float x8, float x9, float x10, float x11, float x12, float x13, float x14, float x15) noexcept {
+
+    Data512 self;
+    self.setF32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15);
+    return self;
+  }
+
+  //! Set all eight DP-FP floats.
+  static ASMJIT_INLINE Data512 fromF64(double x0) noexcept {
+    Data512 self;
+    self.setF64(x0);
+    return self;
+  }
+
+  //! Set all eight DP-FP floats.
+  static ASMJIT_INLINE Data512 fromF64(
+    double x0, double x1, double x2, double x3,
+    double x4, double x5, double x6, double x7) noexcept {
+
+    Data512 self;
+    self.setF64(x0, x1, x2, x3, x4, x5, x6, x7);
+    return self;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Set all sixty four 8-bit signed integers.
+  ASMJIT_INLINE void setI8(int8_t x0) noexcept {
+    setU8(static_cast<uint8_t>(x0));
+  }
+
+  //! Set all sixty four 8-bit unsigned integers.
+  ASMJIT_INLINE void setU8(uint8_t x0) noexcept {
+    setU64(static_cast<uint64_t>(x0) * ASMJIT_UINT64_C(0x0101010101010101));
+  }
+
+  //! Set all thirty two 16-bit signed integers.
+  ASMJIT_INLINE void setI16(int16_t x0) noexcept {
+    setU16(static_cast<uint16_t>(x0));
+  }
+
+  //! Set all thirty two 16-bit unsigned integers.
+  ASMJIT_INLINE void setU16(uint16_t x0) noexcept {
+    setU64(static_cast<uint64_t>(x0) * ASMJIT_UINT64_C(0x0001000100010001));
+  }
+
+  //! Set all sixteen 32-bit signed integers.
+  ASMJIT_INLINE void setI32(int32_t x0) noexcept {
+    setU32(static_cast<uint32_t>(x0));
+  }
+
+  //! Set all sixteen 32-bit unsigned integers.
+  ASMJIT_INLINE void setU32(uint32_t x0) noexcept {
+    setU64((static_cast<uint64_t>(x0) << 32) + x0);
+  }
+
+  //! Set all sixteen 32-bit signed integers.
+  ASMJIT_INLINE void setI32(
+    int32_t x0, int32_t x1, int32_t x2 , int32_t x3 , int32_t x4 , int32_t x5 , int32_t x6 , int32_t x7 ,
+    int32_t x8, int32_t x9, int32_t x10, int32_t x11, int32_t x12, int32_t x13, int32_t x14, int32_t x15) noexcept {
+
+    sd[0 ] = x0 ; sd[1 ] = x1 ; sd[2 ] = x2 ; sd[3 ] = x3 ;
+    sd[4 ] = x4 ; sd[5 ] = x5 ; sd[6 ] = x6 ; sd[7 ] = x7 ;
+    sd[8 ] = x8 ; sd[9 ] = x9 ; sd[10] = x10; sd[11] = x11;
+    sd[12] = x12; sd[13] = x13; sd[14] = x14; sd[15] = x15;
+  }
+
+  //! Set all sixteen 32-bit unsigned integers.
+  ASMJIT_INLINE void setU32(
+    uint32_t x0, uint32_t x1, uint32_t x2 , uint32_t x3 , uint32_t x4 , uint32_t x5 , uint32_t x6 , uint32_t x7 ,
+    uint32_t x8, uint32_t x9, uint32_t x10, uint32_t x11, uint32_t x12, uint32_t x13, uint32_t x14, uint32_t x15) noexcept {
+
+    ud[0 ] = x0 ; ud[1 ] = x1 ; ud[2 ] = x2 ; ud[3 ] = x3 ;
+    ud[4 ] = x4 ; ud[5 ] = x5 ; ud[6 ] = x6 ; ud[7 ] = x7 ;
+    ud[8 ] = x8 ; ud[9 ] = x9 ; ud[10] = x10; ud[11] = x11;
+    ud[12] = x12; ud[13] = x13; ud[14] = x14; ud[15] = x15;
+  }
+
+  //! Set all eight 64-bit signed integers.
+  ASMJIT_INLINE void setI64(int64_t x0) noexcept {
+    setU64(static_cast<uint64_t>(x0));
+  }
+
+  //! Set all eight 64-bit unsigned integers.
+  ASMJIT_INLINE void setU64(uint64_t x0) noexcept {
+    uq[0] = x0; uq[1] = x0; uq[2] = x0; uq[3] = x0;
+    uq[4] = x0; uq[5] = x0; uq[6] = x0; uq[7] = x0;
+  }
+
+  //! Set all eight 64-bit signed integers.
+  ASMJIT_INLINE void setI64(
+    int64_t x0, int64_t x1, int64_t x2, int64_t x3,
+    int64_t x4, int64_t x5, int64_t x6, int64_t x7) noexcept {
+
+    sq[0] = x0; sq[1] = x1; sq[2] = x2; sq[3] = x3;
+    sq[4] = x4; sq[5] = x5; sq[6] = x6; sq[7] = x7;
+  }
+
+  //! Set all eight 64-bit unsigned integers.
+  ASMJIT_INLINE void setU64(
+    uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3,
+    uint64_t x4, uint64_t x5, uint64_t x6, uint64_t x7) noexcept {
+
+    uq[0] = x0; uq[1] = x1; uq[2] = x2; uq[3] = x3;
+    uq[4] = x4; uq[5] = x5; uq[6] = x6; uq[7] = x7;
+  }
+
+  //! Set all sixteen SP-FP floats.
+  ASMJIT_INLINE void setF32(float x0) noexcept {
+    sf[0 ] = x0; sf[1 ] = x0; sf[2 ] = x0; sf[3 ] = x0;
+    sf[4 ] = x0; sf[5 ] = x0; sf[6 ] = x0; sf[7 ] = x0;
+    sf[8 ] = x0; sf[9 ] = x0; sf[10] = x0; sf[11] = x0;
+    sf[12] = x0; sf[13] = x0; sf[14] = x0; sf[15] = x0;
+  }
+
+  //! Set all sixteen SP-FP floats.
+  ASMJIT_INLINE void setF32(
+    float x0, float x1, float x2 , float x3 , float x4 , float x5 , float x6 , float x7 ,
+    float x8, float x9, float x10, float x11, float x12, float x13, float x14, float x15) noexcept {
+
+    sf[0 ] = x0 ; sf[1 ] = x1 ; sf[2 ] = x2 ; sf[3 ] = x3 ;
+    sf[4 ] = x4 ; sf[5 ] = x5 ; sf[6 ] = x6 ; sf[7 ] = x7 ;
+    sf[8 ] = x8 ; sf[9 ] = x9 ; sf[10] = x10; sf[11] = x11;
+    sf[12] = x12; sf[13] = x13; sf[14] = x14; sf[15] = x15;
+  }
+
+  //! Set all eight DP-FP floats.
+  ASMJIT_INLINE void setF64(double x0) noexcept {
+    df[0] = x0; df[1] = x0; df[2] = x0; df[3] = x0;
+    df[4] = x0; df[5] = x0; df[6] = x0; df[7] = x0;
+  }
+
+  //! Set all eight DP-FP floats.
+  ASMJIT_INLINE void setF64(
+    double x0, double x1, double x2, double x3,
+    double x4, double x5, double x6, double x7) noexcept {
+
+    df[0] = x0; df[1] = x1; df[2] = x2; df[3] = x3;
+    df[4] = x4; df[5] = x5; df[6] = x6; df[7] = x7;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  //! Array of sixty four 8-bit signed integers.
+  int8_t sb[64];
+  //! Array of sixty four 8-bit unsigned integers.
+  uint8_t ub[64];
+  //! Array of thirty two 16-bit signed integers.
+  int16_t sw[32];
+  //! Array of thirty two 16-bit unsigned integers.
+  uint16_t uw[32];
+  //! Array of sixteen 32-bit signed integers.
+  int32_t sd[16];
+  //! Array of sixteen 32-bit unsigned integers.
+  uint32_t ud[16];
+  //! Array of eight 64-bit signed integers.
+  int64_t sq[8];
+  //! Array of eight 64-bit unsigned integers.
+  uint64_t uq[8];
+
+  //! Array of sixteen 32-bit single precision floating points.
+  float sf[16];
+  //! Array of eight 64-bit double precision floating points.
+  double df[8];
+};
+
 //! \}
 
 } // asmjit namespace
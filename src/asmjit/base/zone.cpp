@@ -33,6 +33,102 @@ static ASMJIT_INLINE uint32_t Zone_getAlignmentOffsetFromAlignment(uint32_t x) n
   }
 }
 
+// ============================================================================
+// [asmjit::ZoneBlockCache - Construction / Destruction]
+// ============================================================================
+
+ZoneBlockCache::ZoneBlockCache(size_t maxCachedSize) noexcept
+  : _chunks(nullptr),
+    _maxCachedSize(maxCachedSize),
+    _cachedSize(0),
+    _cachedCount(0),
+    _missCount(0),
+    _hitCount(0) {}
+
+ZoneBlockCache::~ZoneBlockCache() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmjit::ZoneBlockCache - Reset]
+// ============================================================================
+
+void ZoneBlockCache::reset() noexcept {
+  Chunk* chunk = _chunks;
+  while (chunk) {
+    Chunk* next = chunk->next;
+    Internal::releaseMemory(chunk);
+    chunk = next;
+  }
+
+  _chunks = nullptr;
+  _cachedSize = 0;
+  _cachedCount = 0;
+  _missCount = 0;
+  _hitCount = 0;
+}
+
+// ============================================================================
+// [asmjit::ZoneBlockCache - Alloc / Release]
+// ============================================================================
+
+void* ZoneBlockCache::alloc(size_t size, size_t& allocatedSize) noexcept {
+  // Find the smallest chunk that is large enough.
+  Chunk** pBest = nullptr;
+  Chunk** pPrev = &_chunks;
+  Chunk* chunk = *pPrev;
+
+  while (chunk) {
+    if (chunk->size >= size && (!pBest || chunk->size < (*pBest)->size)) {
+      pBest = pPrev;
+      if (chunk->size == size)
+        break;
+    }
+
+    pPrev = &chunk->next;
+    chunk = *pPrev;
+  }
+
+  if (pBest) {
+    chunk = *pBest;
+    *pBest = chunk->next;
+
+    _cachedSize -= chunk->size;
+    _cachedCount--;
+    _hitCount++;
+
+    allocatedSize = chunk->size;
+    return static_cast<void*>(chunk);
+  }
+
+  void* p = Internal::allocMemory(std::max<size_t>(size, sizeof(Chunk)));
+  if (ASMJIT_UNLIKELY(!p)) {
+    allocatedSize = 0;
+    return nullptr;
+  }
+
+  _missCount++;
+  allocatedSize = std::max<size_t>(size, sizeof(Chunk));
+  return p;
+}
+
+void ZoneBlockCache::release(void* p, size_t size) noexcept {
+  ASMJIT_ASSERT(p != nullptr);
+
+  if (size < sizeof(Chunk) || _maxCachedSize - _cachedSize < size) {
+    Internal::releaseMemory(p);
+    return;
+  }
+
+  Chunk* chunk = static_cast<Chunk*>(p);
+  chunk->next = _chunks;
+  chunk->size = size;
+  _chunks = chunk;
+
+  _cachedSize += size;
+  _cachedCount++;
+}
+
 // ============================================================================
 // [asmjit::Zone - Construction / Destruction]
 // ============================================================================
@@ -41,6 +137,7 @@ Zone::Zone(uint32_t blockSize, uint32_t blockAlignment) noexcept
   : _ptr(nullptr),
     _end(nullptr),
     _block(const_cast<Zone::Block*>(&Zone_zeroBlock)),
+    _blockCache(nullptr),
     _blockSize(blockSize),
     _blockAlignmentShift(Zone_getAlignmentOffsetFromAlignment(blockAlignment)) {}
 
@@ -60,19 +157,21 @@ void Zone::reset(bool releaseMemory) noexcept {
     return;
 
   if (releaseMemory) {
+    ZoneBlockCache* cache = _blockCache;
+
     // Since cur can be in the middle of the double-linked list, we have to
     // traverse to both directions `prev` and `next` separately.
     Block* next = cur->next;
     do {
       Block* prev = cur->prev;
-      Internal::releaseMemory(cur);
+      ZoneBlockCache::releaseBlock(cache, cur, sizeof(Block) + cur->size);
       cur = prev;
     } while (cur);
 
     cur = next;
     while (cur) {
       next = cur->next;
-      Internal::releaseMemory(cur);
+      ZoneBlockCache::releaseBlock(cache, cur, sizeof(Block) + cur->size);
       cur = next;
     }
 
@@ -90,6 +189,43 @@ void Zone::reset(bool releaseMemory) noexcept {
   }
 }
 
+// ============================================================================
+// [asmjit::Zone - Checkpoint / Rollback]
+// ============================================================================
+
+void Zone::rollback(const Checkpoint& cp) noexcept {
+  // A checkpoint saved before the first allocation doesn't point to any block,
+  // rolling back to it means rewinding to the first block.
+  if (cp.block == &Zone_zeroBlock) {
+    reset(false);
+    return;
+  }
+
+  _block = cp.block;
+  _ptr = cp.ptr;
+  _end = cp.end;
+}
+
+// ============================================================================
+// [asmjit::Zone - Accessors]
+// ============================================================================
+
+void Zone::setBlockCache(ZoneBlockCache* cache) noexcept {
+  reset(true);
+  _blockCache = cache;
+}
+
+size_t Zone::getUsedSize() const noexcept {
+  const Block* cur = _block;
+  if (cur == &Zone_zeroBlock)
+    return 0;
+
+  size_t size = (size_t)(_ptr - cur->data);
+  while ((cur = cur->prev) != nullptr)
+    size += cur->size;
+  return size;
+}
+
 // ============================================================================
 // [asmjit::Zone - Alloc]
 // ============================================================================
@@ -125,11 +261,17 @@ void* Zone::_alloc(size_t size) noexcept {
     return nullptr;
 
   blockSize += blockAlignment;
-  Block* newBlock = static_cast<Block*>(Internal::allocMemory(sizeof(Block) + blockSize));
+
+  size_t allocatedSize;
+  Block* newBlock = static_cast<Block*>(
+    ZoneBlockCache::allocBlock(_blockCache, sizeof(Block) + blockSize, allocatedSize));
 
   if (ASMJIT_UNLIKELY(!newBlock))
     return nullptr;
 
+  // A cached block can be larger than requested.
+  blockSize = allocatedSize - sizeof(Block);
+
   // Align the pointer to `blockAlignment` and adjust the size of this block
   // accordingly. It's the same as using `blockAlignment - Utils::alignDiff()`,
   // just written differently.
@@ -214,10 +356,13 @@ static bool ZoneHeap_hasDynamicBlock(ZoneHeap* self, ZoneHeap::DynamicBlock* blo
 void ZoneHeap::reset(Zone* zone) noexcept {
   // Free dynamic blocks.
   DynamicBlock* block = _dynamicBlocks;
-  while (block) {
-    DynamicBlock* next = block->next;
-    Internal::releaseMemory(block);
-    block = next;
+  if (block) {
+    ZoneBlockCache* cache = _zone->getBlockCache();
+    do {
+      DynamicBlock* next = block->next;
+      ZoneBlockCache::releaseBlock(cache, block, block->size);
+      block = next;
+    } while (block);
   }
 
   // Zero the entire class and initialize to the given `zone`.
@@ -225,6 +370,60 @@ void ZoneHeap::reset(Zone* zone) noexcept {
   _zone = zone;
 }
 
+// ============================================================================
+// [asmjit::ZoneHeap - Checkpoint / Rollback]
+// ============================================================================
+
+void ZoneHeap::checkpoint(Checkpoint& cp) noexcept {
+  ASMJIT_ASSERT(isInitialized());
+
+  _zone->checkpoint(cp.zone);
+  ::memcpy(cp.slots, _slots, sizeof(_slots));
+  cp.dynamicBlocks = _dynamicBlocks;
+
+  // Slots may contain memory released before the checkpoint, which has to be
+  // kept intact for the rollback.
+  ::memset(_slots, 0, sizeof(_slots));
+  _checkpointCount++;
+}
+
+void ZoneHeap::rollback(const Checkpoint& cp) noexcept {
+  ASMJIT_ASSERT(isInitialized());
+  ASMJIT_ASSERT(_checkpointCount != 0);
+
+  // Dynamic blocks are not unlinked during a checkpoint, all blocks allocated
+  // after it precede `cp.dynamicBlocks` in the list.
+  ZoneBlockCache* cache = _zone->getBlockCache();
+  DynamicBlock* block = _dynamicBlocks;
+
+  while (block != cp.dynamicBlocks) {
+    DynamicBlock* next = block->next;
+    ZoneBlockCache::releaseBlock(cache, block, block->size);
+    block = next;
+  }
+
+  if (block)
+    block->prev = nullptr;
+  _dynamicBlocks = block;
+
+  ::memcpy(_slots, cp.slots, sizeof(_slots));
+  _zone->rollback(cp.zone);
+  _checkpointCount--;
+}
+
+void ZoneHeap::commit(const Checkpoint& cp) noexcept {
+  ASMJIT_ASSERT(isInitialized());
+  ASMJIT_ASSERT(_checkpointCount != 0);
+
+  // Keep the memory released before the checkpoint if the slot is empty,
+  // otherwise the list would have to be traversed to merge both.
+  for (uint32_t i = 0; i < kLoCount + kHiCount; i++)
+    if (!_slots[i])
+      _slots[i] = cp.slots[i];
+
+  _checkpointCount--;
+}
+
 // ============================================================================
 // [asmjit::ZoneHeap - Alloc / Release]
 // ============================================================================
@@ -292,7 +491,8 @@ void* ZoneHeap::_alloc(size_t size, size_t& allocatedSize) noexcept {
     if (ASMJIT_UNLIKELY(overhead >= ~static_cast<size_t>(0) - size))
       return nullptr;
 
-    void* p = Internal::allocMemory(size + overhead);
+    size_t blockSize;
+    void* p = ZoneBlockCache::allocBlock(_zone->getBlockCache(), size + overhead, blockSize);
     if (ASMJIT_UNLIKELY(!p)) {
       allocatedSize = 0;
       return nullptr;
@@ -307,6 +507,7 @@ void* ZoneHeap::_alloc(size_t size, size_t& allocatedSize) noexcept {
 
     block->prev = nullptr;
     block->next = next;
+    block->size = blockSize;
     _dynamicBlocks = block;
 
     // Align the pointer to the guaranteed alignment and store `DynamicBlock`
@@ -348,7 +549,7 @@ void ZoneHeap::_releaseDynamic(void* p, size_t size) noexcept {
   if (next)
     next->prev = prev;
 
-  Internal::releaseMemory(block);
+  ZoneBlockCache::releaseBlock(_zone->getBlockCache(), block, block->size);
 }
 
 // ============================================================================
@@ -410,7 +611,7 @@ Error ZoneVectorBase::_reserve(ZoneHeap* heap, size_t sizeOfT, size_t n) noexcep
   if (_length)
     ::memcpy(newData, oldData, _length * sizeOfT);
 
-  if (oldData)
+  if (oldData && !_isEmbedded())
     heap->release(oldData, oldCapacity * sizeOfT);
 
   _capacity = allocatedBytes / sizeOfT;
@@ -818,6 +1019,7 @@ ZoneHashNode* ZoneHashBase::_del(ZoneHashNode* node) noexcept {
   while (p) {
     if (p == node) {
       *pPrev = p->_hashNext;
+      _size--;
       return node;
     }
 
@@ -828,11 +1030,337 @@ ZoneHashNode* ZoneHashBase::_del(ZoneHashNode* node) noexcept {
   return nullptr;
 }
 
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Helpers]
+// ============================================================================
+
+static ASMJIT_INLINE size_t ZoneOpenHash_dataSize(uint32_t capacity) noexcept {
+  return static_cast<size_t>(capacity) * (sizeof(ZoneHashNode*) + sizeof(uint32_t));
+}
+
+static ASMJIT_INLINE void ZoneOpenHash_releaseTable(ZoneHeap* heap, ZoneOpenHashBase::Table& table) noexcept {
+  // Nodes are allocated first, fingerprints follow them.
+  heap->release(table.nodes, ZoneOpenHash_dataSize(table.mask + 1));
+}
+
+// Insert `node` into `table`, which must have at least one empty slot.
+static ASMJIT_INLINE void ZoneOpenHash_insert(ZoneOpenHashBase::Table& table, uint32_t fp, ZoneHashNode* node) noexcept {
+  uint32_t mask = table.mask;
+  uint32_t i = ZoneOpenHashBase::_slotOf(fp, mask);
+
+  while (table.fps[i] != ZoneOpenHashBase::kFpEmpty)
+    i = (i + 1) & mask;
+
+  table.fps[i] = fp;
+  table.nodes[i] = node;
+}
+
+// Get the slot of `node` in `table` or `Globals::kInvalidIndex` if not found.
+static ASMJIT_INLINE uint32_t ZoneOpenHash_find(const ZoneOpenHashBase::Table& table, uint32_t fp, ZoneHashNode* node) noexcept {
+  uint32_t mask = table.mask;
+  uint32_t i = ZoneOpenHashBase::_slotOf(fp, mask);
+
+  for (;;) {
+    uint32_t x = table.fps[i];
+    if (x == fp && table.nodes[i] == node)
+      return i;
+    if (x == ZoneOpenHashBase::kFpEmpty)
+      return static_cast<uint32_t>(Globals::kInvalidIndex);
+    i = (i + 1) & mask;
+  }
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Reset]
+// ============================================================================
+
+void ZoneOpenHashBase::reset(ZoneHeap* heap) noexcept {
+  if (_table.fps != &_embedded)
+    ZoneOpenHash_releaseTable(_heap, _table);
+
+  if (_old.fps)
+    ZoneOpenHash_releaseTable(_heap, _old);
+
+  _heap = heap;
+  _size = 0;
+  _growAt = 0;
+  _oldIndex = 0;
+  _oldSize = 0;
+  _embedded = kFpEmpty;
+
+  _table.fps = &_embedded;
+  _table.nodes = nullptr;
+  _table.mask = 0;
+
+  _old.fps = nullptr;
+  _old.nodes = nullptr;
+  _old.mask = 0;
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Grow / Migrate]
+// ============================================================================
+
+bool ZoneOpenHashBase::_grow() noexcept {
+  ASMJIT_ASSERT(isInitialized());
+  ASMJIT_ASSERT(!isMigrating());
+
+  uint32_t oldCapacity = _table.mask + 1;
+  uint32_t newCapacity = _table.fps == &_embedded ? static_cast<uint32_t>(kMinCapacity) : oldCapacity * 2;
+
+  if (ASMJIT_UNLIKELY(newCapacity > (static_cast<uint32_t>(1) << 30)))
+    return false;
+
+  ZoneHashNode** nodes = static_cast<ZoneHashNode**>(_heap->alloc(ZoneOpenHash_dataSize(newCapacity)));
+  if (ASMJIT_UNLIKELY(!nodes))
+    return false;
+
+  uint32_t* fps = reinterpret_cast<uint32_t*>(nodes + newCapacity);
+  ::memset(fps, 0, newCapacity * sizeof(uint32_t));
+
+  if (_size != 0) {
+    _old = _table;
+    _oldIndex = 0;
+    _oldSize = static_cast<uint32_t>(_size);
+  }
+  else if (_table.fps != &_embedded) {
+    ZoneOpenHash_releaseTable(_heap, _table);
+  }
+
+  _table.fps = fps;
+  _table.nodes = nodes;
+  _table.mask = newCapacity - 1;
+  _growAt = newCapacity / 2 + newCapacity / 4;
+
+  return true;
+}
+
+void ZoneOpenHashBase::_migrate(uint32_t n) noexcept {
+  ASMJIT_ASSERT(isMigrating());
+
+  uint32_t i = _oldIndex;
+  uint32_t end = std::min<uint32_t>(_old.mask + 1 - i, n) + i;
+
+  // Moved slots are marked as deleted instead of empty, as other nodes of the
+  // old table may still be probed through them.
+  while (i < end && _oldSize) {
+    uint32_t fp = _old.fps[i];
+    if (fp >= kFpFirst) {
+      ZoneOpenHash_insert(_table, fp, _old.nodes[i]);
+      _old.fps[i] = kFpDeleted;
+      _oldSize--;
+    }
+    i++;
+  }
+  _oldIndex = i;
+
+  if (_oldSize == 0) {
+    ZoneOpenHash_releaseTable(_heap, _old);
+    _old.fps = nullptr;
+    _old.nodes = nullptr;
+    _old.mask = 0;
+    _oldIndex = 0;
+  }
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Ops]
+// ============================================================================
+
+ZoneHashNode* ZoneOpenHashBase::_put(ZoneHashNode* node) noexcept {
+  if (_size >= _growAt) {
+    // Nodes of the previous growth should have been moved already, as each
+    // operation moves `kMigrateCount` slots, finish it if they weren't.
+    if (_old.fps)
+      _migrate(_old.mask + 1);
+
+    // Keep at least one empty slot if the table can't grow, probing relies
+    // on it.
+    if (!_grow() && _size + 1 >= static_cast<size_t>(_table.mask) + 1)
+      return nullptr;
+  }
+
+  ZoneOpenHash_insert(_table, _fpOf(node->_hVal), node);
+  _size++;
+
+  if (_old.fps)
+    _migrate(kMigrateCount);
+  return node;
+}
+
+ZoneHashNode* ZoneOpenHashBase::_del(ZoneHashNode* node) noexcept {
+  uint32_t fp = _fpOf(node->_hVal);
+  uint32_t i = ZoneOpenHash_find(_table, fp, node);
+
+  if (i != static_cast<uint32_t>(Globals::kInvalidIndex)) {
+    // Shift nodes that follow the removed one back, so the table never has
+    // deleted slots. A node at `j` can fill the hole at `i` if `i` is between
+    // its home slot and `j`.
+    uint32_t mask = _table.mask;
+    uint32_t j = i;
+
+    for (;;) {
+      j = (j + 1) & mask;
+
+      uint32_t x = _table.fps[j];
+      if (x == kFpEmpty) break;
+
+      uint32_t home = _slotOf(x, mask);
+      if (((j - home) & mask) >= ((j - i) & mask)) {
+        _table.fps[i] = x;
+        _table.nodes[i] = _table.nodes[j];
+        i = j;
+      }
+    }
+
+    _table.fps[i] = kFpEmpty;
+    _size--;
+
+    if (_old.fps)
+      _migrate(kMigrateCount);
+    return node;
+  }
+
+  if (_old.fps) {
+    i = ZoneOpenHash_find(_old, fp, node);
+    if (i != static_cast<uint32_t>(Globals::kInvalidIndex)) {
+      _old.fps[i] = kFpDeleted;
+      _oldSize--;
+      _size--;
+
+      _migrate(kMigrateCount);
+      return node;
+    }
+  }
+
+  return nullptr;
+}
+
 // ============================================================================
 // [asmjit::Zone - Test]
 // ============================================================================
 
 #if defined(ASMJIT_TEST)
+UNIT(base_zoneblockcache) {
+  ZoneBlockCache cache;
+  size_t i;
+
+  INFO("Zone returns its blocks to ZoneBlockCache");
+  {
+    Zone zone(8096 - Zone::kZoneOverhead);
+    zone.setBlockCache(&cache);
+
+    for (i = 0; i < 10; i++)
+      EXPECT(zone.alloc(4096) != nullptr);
+    size_t missCount = cache.getMissCount();
+    EXPECT(missCount == 10);
+
+    zone.reset(true);
+    EXPECT(cache.getCachedCount() == missCount);
+
+    for (i = 0; i < 10; i++)
+      EXPECT(zone.alloc(4096) != nullptr);
+    EXPECT(cache.getMissCount() == missCount);
+    EXPECT(cache.getHitCount() == missCount);
+    EXPECT(cache.getCachedCount() == 0);
+  }
+  EXPECT(cache.getCachedCount() == 10);
+
+  INFO("ZoneHeap returns its dynamic blocks to ZoneBlockCache");
+  {
+    Zone zone(8096 - Zone::kZoneOverhead);
+    zone.setBlockCache(&cache);
+
+    ZoneHeap heap(&zone);
+    ZoneVector<int> vec;
+
+    for (i = 0; i < 10000; i++)
+      EXPECT(vec.append(&heap, static_cast<int>(i)) == kErrorOk);
+    vec.release(&heap);
+    heap.reset(&zone);
+
+    size_t missCount = cache.getMissCount();
+    for (i = 0; i < 10000; i++)
+      EXPECT(vec.append(&heap, static_cast<int>(i)) == kErrorOk);
+    EXPECT(cache.getMissCount() == missCount);
+  }
+
+  INFO("ZoneBlockCache::getMaxCachedSize()");
+  {
+    ZoneBlockCache limited(8192);
+    Zone zone(4096 - Zone::kZoneOverhead);
+    zone.setBlockCache(&limited);
+
+    for (i = 0; i < 4; i++)
+      EXPECT(zone.alloc(4096 - Zone::kZoneOverhead) != nullptr);
+    zone.reset(true);
+    EXPECT(limited.getCachedCount() == 2);
+    EXPECT(limited.getCachedSize() <= limited.getMaxCachedSize());
+  }
+
+  cache.reset();
+  EXPECT(cache.getCachedCount() == 0);
+  EXPECT(cache.getCachedSize() == 0);
+}
+
+UNIT(base_zone_checkpoint) {
+  Zone zone(8096 - Zone::kZoneOverhead);
+  ZoneHeap heap(&zone);
+  size_t i;
+
+  INFO("Zone::checkpoint() and Zone::rollback()");
+  {
+    Zone::Checkpoint cp;
+    EXPECT(zone.alloc(100) != nullptr);
+
+    zone.checkpoint(cp);
+    void* p = zone.alloc(100);
+    for (i = 0; i < 10; i++)
+      EXPECT(zone.alloc(4096) != nullptr);
+
+    zone.rollback(cp);
+    EXPECT(zone.alloc(100) == p);
+    zone.reset();
+  }
+
+  INFO("ZoneHeap::checkpoint() and ZoneHeap::rollback()");
+  {
+    ZoneVector<int> vec;
+    ZoneHeap::Checkpoint cp;
+
+    for (i = 0; i < 20; i++)
+      EXPECT(vec.append(&heap, static_cast<int>(i)) == kErrorOk);
+
+    ZoneVectorBase::Storage storage;
+    vec._saveStorage(storage);
+    heap.checkpoint(cp);
+    EXPECT(heap.hasCheckpoint());
+
+    // Grow the vector during the checkpoint, its storage is reallocated
+    // (also by a dynamic block).
+    for (i = 20; i < 2000; i++)
+      EXPECT(vec.append(&heap, -1) == kErrorOk);
+
+    heap.rollback(cp);
+    vec._restoreStorage(storage);
+    EXPECT(!heap.hasCheckpoint());
+
+    EXPECT(vec.getLength() == 20);
+    for (i = 0; i < 20; i++)
+      EXPECT(vec[i] == static_cast<int>(i));
+
+    heap.checkpoint(cp);
+    for (i = 20; i < 2000; i++)
+      EXPECT(vec.append(&heap, static_cast<int>(i)) == kErrorOk);
+    heap.commit(cp);
+
+    EXPECT(vec.getLength() == 2000);
+    for (i = 0; i < 2000; i++)
+      EXPECT(vec[i] == static_cast<int>(i));
+    vec.release(&heap);
+  }
+}
+
 UNIT(base_zonevector) {
   Zone zone(8096 - Zone::kZoneOverhead);
   ZoneHeap heap(&zone);
@@ -861,6 +1389,44 @@ UNIT(base_zonevector) {
   EXPECT(vec.isEmpty() == false);
   EXPECT(vec.getLength() == static_cast<size_t>(kMax));
   EXPECT(vec.indexOf(kMax - 1) == static_cast<size_t>(kMax - 1));
+
+  INFO("ZoneVector<int>::insert()");
+  EXPECT(vec.insert(&heap, 1, -1) == kErrorOk);
+  EXPECT(vec.getLength() == static_cast<size_t>(kMax + 1));
+  EXPECT(vec[0] == 0);
+  EXPECT(vec[1] == -1);
+  for (i = 1; i < kMax; i++) {
+    EXPECT(vec[i + 1] == i);
+  }
+
+  INFO("ZoneVector<int>::removeAt()");
+  vec.removeAt(1);
+  EXPECT(vec.getLength() == static_cast<size_t>(kMax));
+  for (i = 0; i < kMax; i++) {
+    EXPECT(vec[i] == i);
+  }
+
+  INFO("ZoneSmallVector<int, 8> inline storage");
+  ZoneSmallVector<int, 8> small;
+  EXPECT(small._isEmbedded());
+  EXPECT(small.getCapacity() == 8);
+
+  for (i = 0; i < 8; i++) {
+    EXPECT(small.append(&heap, i) == kErrorOk);
+  }
+  EXPECT(small._isEmbedded(), "ZoneSmallVector must not allocate up to its inline capacity");
+
+  EXPECT(small.append(&heap, 8) == kErrorOk);
+  EXPECT(!small._isEmbedded());
+  EXPECT(small.getLength() == 9);
+  for (i = 0; i < 9; i++) {
+    EXPECT(small[i] == i);
+  }
+
+  small.release(&heap);
+  EXPECT(small._isEmbedded());
+  EXPECT(small.isEmpty());
+  EXPECT(small.getCapacity() == 8);
 }
 
 UNIT(base_ZoneBitVector) {
@@ -954,6 +1520,103 @@ UNIT(base_zonestack) {
   }
   EXPECT(stack.isEmpty());
 }
+
+class ZoneOpenHashTestNode : public ZoneHashNode {
+public:
+  ASMJIT_INLINE ZoneOpenHashTestNode(uint32_t key) noexcept
+    : ZoneHashNode(key / 4) { _customData = key; }
+};
+
+class ZoneOpenHashTestKey {
+public:
+  ASMJIT_INLINE ZoneOpenHashTestKey(uint32_t key) noexcept
+    : hVal(key / 4),
+      key(key) {}
+
+  ASMJIT_INLINE bool matches(const ZoneOpenHashTestNode* node) const noexcept {
+    return node->_customData == key;
+  }
+
+  uint32_t hVal;
+  uint32_t key;
+};
+
+UNIT(base_zoneopenhash) {
+  Zone zone(8096 - Zone::kZoneOverhead);
+  ZoneHeap heap(&zone);
+  ZoneOpenHash<ZoneOpenHashTestNode> hash(&heap);
+
+  // Each 4 consecutive keys have the same hash, keys 0-7 have the same
+  // fingerprint as keys 8-15.
+  uint32_t i;
+  uint32_t count = 10000;
+  bool migrated = false;
+
+  ZoneOpenHashTestNode* nodes = static_cast<ZoneOpenHashTestNode*>(
+    zone.alloc(count * sizeof(ZoneOpenHashTestNode)));
+  EXPECT(nodes != nullptr);
+
+  INFO("Inserting %u nodes", count);
+  for (i = 0; i < count; i++) {
+    new(&nodes[i]) ZoneOpenHashTestNode(i);
+    EXPECT(hash.get(ZoneOpenHashTestKey(i)) == nullptr);
+    EXPECT(hash.put(&nodes[i]) == &nodes[i]);
+    EXPECT(hash.get(ZoneOpenHashTestKey(i)) == &nodes[i]);
+
+    migrated |= hash.isMigrating();
+    EXPECT(hash.getSize() <= hash.getCapacity() * 3 / 4);
+  }
+  EXPECT(migrated);
+  EXPECT(hash.getSize() == count);
+
+  for (i = 0; i < count; i++)
+    EXPECT(hash.get(ZoneOpenHashTestKey(i)) == &nodes[i],
+      "Node %u not found after all nodes were inserted", i);
+
+  INFO("Deleting nodes of even keys");
+  for (i = 0; i < count; i += 2) {
+    EXPECT(hash.del(&nodes[i]) == &nodes[i]);
+    EXPECT(hash.del(&nodes[i]) == nullptr);
+  }
+  EXPECT(hash.getSize() == count / 2);
+
+  for (i = 0; i < count; i++) {
+    ZoneOpenHashTestNode* node = hash.get(ZoneOpenHashTestKey(i));
+    EXPECT(node == ((i & 1) ? &nodes[i] : nullptr),
+      "Node %u %s after nodes of even keys were deleted", i, (i & 1) ? "not found" : "found");
+  }
+
+  INFO("Inserting nodes of even keys again");
+  for (i = 0; i < count; i += 2)
+    EXPECT(hash.put(&nodes[i]) == &nodes[i]);
+  EXPECT(hash.getSize() == count);
+
+  for (i = 0; i < count; i++)
+    EXPECT(hash.get(ZoneOpenHashTestKey(i)) == &nodes[i]);
+
+  hash.reset(&heap);
+  EXPECT(hash.getSize() == 0);
+  EXPECT(hash.get(ZoneOpenHashTestKey(0)) == nullptr);
+
+  INFO("Deleting nodes that were not moved from the old table yet");
+  uint32_t grownAt = 0;
+  for (i = 0; i < count; i++) {
+    EXPECT(hash.put(&nodes[i]) == &nodes[i]);
+    if (i > ZoneOpenHashBase::kMinCapacity && hash.isMigrating()) {
+      grownAt = i;
+      break;
+    }
+  }
+  EXPECT(grownAt != 0);
+
+  for (i = 0; i < grownAt; i++)
+    EXPECT(hash.del(&nodes[i]) == &nodes[i]);
+  EXPECT(hash.getSize() == 1);
+  EXPECT(!hash.isMigrating());
+
+  for (i = 0; i <= grownAt; i++)
+    EXPECT(hash.get(ZoneOpenHashTestKey(i)) == (i == grownAt ? &nodes[i] : nullptr));
+}
 #endif // ASMJIT_TEST
 
 } // asmjit namespace
@@ -9,6 +9,7 @@
 #define _ASMJIT_BASE_ZONE_H
 
 // [Dependencies]
+#include "../base/bitops.h"
 #include "../base/utils.h"
 
 // [Api-Begin]
@@ -19,6 +20,131 @@ namespace asmjit {
 //! \addtogroup asmjit_base
 //! \{
 
+// ============================================================================
+// [asmjit::ZoneBlockCache]
+// ============================================================================
+
+//! Cache of memory blocks released by \ref Zone, \ref ZoneHeap, and
+//! \ref CodeHolder.
+//!
+//! Zones return their blocks to the cache instead of releasing them to the
+//! system and draw new blocks from the cache before allocating them by `malloc`.
+//! If the same cache is used by all `CodeHolder`s and `CodeEmitter`s created
+//! to compile functions, compilation does no `malloc` calls once the cache
+//! holds enough blocks.
+//!
+//! The cache is not thread-safe, each thread should use its own cache. It
+//! has to outlive all `Zone`s and `CodeHolder`s that use it:
+//!
+//! ~~~
+//! ZoneBlockCache cache;
+//!
+//! for (...) {
+//!   CodeHolder code;
+//!   code.setBlockCache(&cache);
+//!   code.init(...);
+//!
+//!   // The compiler uses the cache of `code` when it's attached.
+//!   X86Compiler cc(&code);
+//!
+//!   // ... generate the code ...
+//! }
+//! ~~~
+class ZoneBlockCache {
+public:
+  ASMJIT_NONCOPYABLE(ZoneBlockCache)
+
+  //! \internal
+  //!
+  //! A block of memory held by the cache.
+  struct Chunk {
+    Chunk* next;                         //!< Next chunk in the cache.
+    size_t size;                         //!< Size of the chunk, including `Chunk`.
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `ZoneBlockCache` that holds at most `maxCachedSize` bytes,
+  //! blocks released above the limit are released to the system.
+  ASMJIT_API ZoneBlockCache(size_t maxCachedSize = ~static_cast<size_t>(0)) noexcept;
+  //! Destroy the `ZoneBlockCache` and release all cached blocks.
+  ASMJIT_API ~ZoneBlockCache() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Reset]
+  // --------------------------------------------------------------------------
+
+  //! Release all cached blocks to the system and reset statistics.
+  ASMJIT_API void reset() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the maximum number of bytes the cache holds.
+  ASMJIT_INLINE size_t getMaxCachedSize() const noexcept { return _maxCachedSize; }
+  //! Get the number of bytes the cache holds.
+  ASMJIT_INLINE size_t getCachedSize() const noexcept { return _cachedSize; }
+  //! Get the number of blocks the cache holds.
+  ASMJIT_INLINE size_t getCachedCount() const noexcept { return _cachedCount; }
+
+  //! Get how many blocks were allocated by `malloc` because the cache had no
+  //! suitable block.
+  ASMJIT_INLINE size_t getMissCount() const noexcept { return _missCount; }
+  //! Get how many blocks were taken from the cache.
+  ASMJIT_INLINE size_t getHitCount() const noexcept { return _hitCount; }
+
+  // --------------------------------------------------------------------------
+  // [Alloc / Release]
+  // --------------------------------------------------------------------------
+
+  //! Allocate a block of at least `size` bytes, the real size of the block is
+  //! stored in `allocatedSize`. The smallest cached block that is large enough
+  //! is used, if there is none the block is allocated by `malloc`.
+  ASMJIT_API void* alloc(size_t size, size_t& allocatedSize) noexcept;
+  //! Release a block `p` of `size` bytes (the `allocatedSize` returned by
+  //! `alloc()`) to the cache.
+  //!
+  //! NOTE: The block must be allocated by `alloc()` or `Internal::allocMemory()`.
+  ASMJIT_API void release(void* p, size_t size) noexcept;
+
+  //! \internal
+  //!
+  //! Allocate a block of at least `size` bytes from `cache`, or by `malloc`
+  //! if `cache` is null.
+  static ASMJIT_INLINE void* allocBlock(ZoneBlockCache* cache, size_t size, size_t& allocatedSize) noexcept {
+    if (cache)
+      return cache->alloc(size, allocatedSize);
+
+    allocatedSize = size;
+    return Internal::allocMemory(size);
+  }
+
+  //! \internal
+  //!
+  //! Release a block allocated by `allocBlock()` to `cache`, or by `free` if
+  //! `cache` is null.
+  static ASMJIT_INLINE void releaseBlock(ZoneBlockCache* cache, void* p, size_t size) noexcept {
+    if (cache)
+      cache->release(p, size);
+    else
+      Internal::releaseMemory(p);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  Chunk* _chunks;                        //!< Cached blocks.
+  size_t _maxCachedSize;                 //!< Maximum number of bytes cached.
+  size_t _cachedSize;                    //!< Number of bytes cached.
+  size_t _cachedCount;                   //!< Number of blocks cached.
+  size_t _missCount;                     //!< Number of blocks allocated by `malloc`.
+  size_t _hitCount;                      //!< Number of blocks taken from the cache.
+};
+
 // ============================================================================
 // [asmjit::Zone]
 // ============================================================================
@@ -50,6 +176,13 @@ public:
     kZoneOverhead = Globals::kAllocOverhead + static_cast<int>(sizeof(Block))
   };
 
+  //! State of the `Zone` saved by `checkpoint()`.
+  struct Checkpoint {
+    Block* block;                        //!< Current block.
+    uint8_t* ptr;                        //!< Pointer in the current block's buffer.
+    uint8_t* end;                        //!< End of the current block's buffer.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -78,9 +211,27 @@ public:
 
   //! Reset the `Zone` invalidating all blocks allocated.
   //!
-  //! If `releaseMemory` is true all buffers will be released to the system.
+  //! If `releaseMemory` is true all buffers will be released to the system,
+  //! or to the block cache if the `Zone` has one.
   ASMJIT_API void reset(bool releaseMemory = false) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Checkpoint / Rollback]
+  // --------------------------------------------------------------------------
+
+  //! Save the current state of the `Zone` to `cp`.
+  ASMJIT_INLINE void checkpoint(Checkpoint& cp) const noexcept {
+    cp.block = _block;
+    cp.ptr = _ptr;
+    cp.end = _end;
+  }
+
+  //! Roll back to the state saved by `checkpoint()`, all memory allocated
+  //! since then becomes invalid and will be reused. Blocks are kept.
+  //!
+  //! NOTE: The `Zone` must not be reset between `checkpoint()` and `rollback()`.
+  ASMJIT_API void rollback(const Checkpoint& cp) noexcept;
+
   // --------------------------------------------------------------------------
   // [Accessors]
   // --------------------------------------------------------------------------
@@ -89,8 +240,19 @@ public:
   ASMJIT_INLINE uint32_t getBlockSize() const noexcept { return _blockSize; }
   //! Get the default block alignment.
   ASMJIT_INLINE uint32_t getBlockAlignment() const noexcept { return (uint32_t)1 << _blockAlignmentShift; }
+  //! Get the block cache used by the `Zone`, or null if it has none.
+  ASMJIT_INLINE ZoneBlockCache* getBlockCache() const noexcept { return _blockCache; }
+  //! Set the block cache used by the `Zone` to `cache` (can be null).
+  //!
+  //! The `Zone` is reset by `reset(true)` first, all memory allocated by it
+  //! becomes invalid.
+  ASMJIT_API void setBlockCache(ZoneBlockCache* cache) noexcept;
+
   //! Get remaining size of the current block.
   ASMJIT_INLINE size_t getRemainingSize() const noexcept { return (size_t)(_end - _ptr); }
+  //! Get the number of bytes used since the last `reset()`, including unused
+  //! tails of blocks that were skipped because an allocation didn't fit.
+  ASMJIT_API size_t getUsedSize() const noexcept;
 
   //! Get the current zone cursor (dangerous).
   //!
@@ -225,6 +387,7 @@ public:
   uint8_t* _ptr;                         //!< Pointer in the current block's buffer.
   uint8_t* _end;                         //!< End of the current block's buffer.
   Block* _block;                         //!< Current block.
+  ZoneBlockCache* _blockCache;           //!< Block cache (optional).
 
 #if ASMJIT_ARCH_64BIT
   uint32_t _blockSize;                   //!< Default size of a newly allocated block.
@@ -288,6 +451,14 @@ class ZoneHeap {
   struct DynamicBlock {
     DynamicBlock* prev;
     DynamicBlock* next;
+    size_t size;
+  };
+
+  //! State of the `ZoneHeap` saved by `checkpoint()`.
+  struct Checkpoint {
+    Zone::Checkpoint zone;               //!< State of the `Zone`.
+    Slot* slots[kLoCount + kHiCount];    //!< Slots containing released memory.
+    DynamicBlock* dynamicBlocks;         //!< First dynamic block.
   };
 
   // --------------------------------------------------------------------------
@@ -325,6 +496,32 @@ class ZoneHeap {
   //! keeps the `ZoneHeap` in an uninitialized state, if `zone` is null.
   ASMJIT_API void reset(Zone* zone = nullptr) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Checkpoint / Rollback]
+  // --------------------------------------------------------------------------
+
+  //! Save the current state of the `ZoneHeap` and its `Zone` to `cp`.
+  //!
+  //! Until the checkpoint is ended by `rollback()` or `commit()`, memory
+  //! released by `release()` is not reused (it may still be used by objects
+  //! that are restored by the rollback). Checkpoints can be nested, but they
+  //! have to be ended in the reverse order.
+  ASMJIT_API void checkpoint(Checkpoint& cp) noexcept;
+
+  //! Roll back to the state saved by `checkpoint()`, all memory allocated
+  //! since then becomes invalid, including memory allocated from the `Zone`
+  //! directly.
+  ASMJIT_API void rollback(const Checkpoint& cp) noexcept;
+
+  //! End the checkpoint `cp` without a rollback.
+  //!
+  //! Memory released since the `checkpoint()` is not reused until the `Zone`
+  //! is reset.
+  ASMJIT_API void commit(const Checkpoint& cp) noexcept;
+
+  //! Get if there is a checkpoint that was not ended yet.
+  ASMJIT_INLINE bool hasCheckpoint() const noexcept { return _checkpointCount != 0; }
+
   // --------------------------------------------------------------------------
   // [Accessors]
   // --------------------------------------------------------------------------
@@ -433,6 +630,10 @@ class ZoneHeap {
     ASMJIT_ASSERT(p != nullptr);
     ASMJIT_ASSERT(size != 0);
 
+    // Memory released during a checkpoint is not reused, see `checkpoint()`.
+    if (ASMJIT_UNLIKELY(_checkpointCount != 0))
+      return;
+
     uint32_t slot;
     if (_getSlotIndex(size, slot)) {
       //printf("RELEASING %p of size %d (SLOT %u)\n", p, int(size), slot);
@@ -451,6 +652,7 @@ class ZoneHeap {
   Zone* _zone;                           //!< Zone used to allocate memory that fits into slots.
   Slot* _slots[kLoCount + kHiCount];     //!< Indexed slots containing released memory.
   DynamicBlock* _dynamicBlocks;          //!< Dynamic blocks for larger allocations (no slots).
+  uint32_t _checkpointCount;             //!< Number of checkpoints not ended yet.
 };
 
 // ============================================================================
@@ -562,6 +764,15 @@ class ZoneVectorBase {
 public:
   ASMJIT_NONCOPYABLE(ZoneVectorBase)
 
+  //! \internal
+  //!
+  //! Storage of the vector, used to restore it after \ref ZoneHeap::rollback().
+  struct Storage {
+    void* data;
+    size_t length;
+    size_t capacity;
+  };
+
 protected:
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
@@ -603,6 +814,30 @@ public:
     _length = std::min(_length, n);
   }
 
+  //! \internal
+  ASMJIT_INLINE void _saveStorage(Storage& storage) const noexcept {
+    storage.data = _data;
+    storage.length = _length;
+    storage.capacity = _capacity;
+  }
+
+  //! \internal
+  ASMJIT_INLINE void _restoreStorage(const Storage& storage) noexcept {
+    _data = storage.data;
+    _length = storage.length;
+    _capacity = storage.capacity;
+  }
+
+  //! \internal
+  //!
+  //! Get if the vector uses the inline elements of \ref ZoneSmallVector,
+  //! which directly follow the vector. Such data is never released (the same
+  //! applies to heap data that happens to directly follow a `ZoneVector`,
+  //! which is harmless as it's only not reused).
+  ASMJIT_INLINE bool _isEmbedded() const noexcept {
+    return _data == static_cast<const void*>(this + 1);
+  }
+
   // --------------------------------------------------------------------------
   // [Memory Management]
   // --------------------------------------------------------------------------
@@ -610,7 +845,8 @@ public:
 protected:
   ASMJIT_INLINE void _release(ZoneHeap* heap, size_t sizeOfT) noexcept {
     if (_data != nullptr) {
-      heap->release(_data, _capacity * sizeOfT);
+      if (!_isEmbedded())
+        heap->release(_data, _capacity * sizeOfT);
       reset();
     }
   }
@@ -685,7 +921,7 @@ public:
       ASMJIT_PROPAGATE(grow(heap, 1));
 
     T* dst = static_cast<T*>(_data) + index;
-    ::memmove(dst + 1, dst, _length - index);
+    ::memmove(dst + 1, dst, (_length - index) * sizeof(T));
     ::memcpy(dst, &item, sizeof(T));
 
     _length++;
@@ -774,7 +1010,7 @@ public:
 
     T* data = static_cast<T*>(_data) + i;
     _length--;
-    ::memmove(data, data + 1, _length - i);
+    ::memmove(data, data + 1, (_length - i) * sizeof(T));
   }
 
   //! Swap this pod-vector with `other`.
@@ -827,6 +1063,67 @@ public:
   }
 };
 
+// ============================================================================
+// [asmjit::ZoneSmallVector<T, N>]
+// ============================================================================
+
+//! \ref ZoneVector<T> that has room for `N` elements inline.
+//!
+//! The vector doesn't allocate until it has more than `N` elements, which is
+//! what most vectors used to generate a single function need. Elements move to
+//! `ZoneHeap` memory when the vector grows and return inline on `reset()`.
+//!
+//! The inline storage is aligned to `uintptr_t`, which is enough for vectors
+//! of pointers and 32-bit integers. Vectors that use their inline storage must
+//! not be swapped, and must not be moved, as their data points into them.
+template <typename T, size_t N>
+class ZoneSmallVector : public ZoneVector<T> {
+public:
+  enum {
+    //! Count of inline elements.
+    kEmbeddedCount = N,
+    //! Count of `uintptr_t` words used to store inline elements.
+    kEmbeddedWords = (N * sizeof(T) + sizeof(uintptr_t) - 1) / sizeof(uintptr_t)
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new instance of `ZoneSmallVector<T, N>`.
+  explicit ASMJIT_INLINE ZoneSmallVector() noexcept : ZoneVector<T>() {
+    reset();
+    ASMJIT_ASSERT(this->_isEmbedded());
+  }
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  //! Reset the vector to use its inline storage and set its `length` to zero.
+  ASMJIT_INLINE void reset() noexcept {
+    this->_data = _embedded;
+    this->_length = 0;
+    this->_capacity = N;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Memory Management]
+  // --------------------------------------------------------------------------
+
+  //! Release the memory held by `ZoneSmallVector<T, N>` back to the `heap`.
+  ASMJIT_INLINE void release(ZoneHeap* heap) noexcept {
+    this->_release(heap, sizeof(T));
+    reset();
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uintptr_t _embedded[kEmbeddedWords];   //!< Inline elements.
+};
+
 // ============================================================================
 // [asmjit::ZoneBitVector]
 // ============================================================================
@@ -836,7 +1133,7 @@ public:
   ASMJIT_NONCOPYABLE(ZoneBitVector)
 
   //! Storage used to store a pack of bits (should by compatible with a machine word).
-  typedef uintptr_t BitWord;
+  typedef BitOps::Word BitWord;
   enum { kBitsPerWord = static_cast<int>(sizeof(BitWord)) * 8 };
 
   static ASMJIT_INLINE size_t _wordsPerBits(size_t nBits) noexcept {
@@ -941,32 +1238,20 @@ public:
   ASMJIT_API Error fill(size_t fromIndex, size_t toIndex, bool value) noexcept;
 
   ASMJIT_INLINE void and_(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] & src[i];
+    BitOps::and_(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
   ASMJIT_INLINE void andNot(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] & ~src[i];
+    BitOps::andNot(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
   ASMJIT_INLINE void or_(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] | src[i];
+    BitOps::or_(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
@@ -1318,6 +1603,168 @@ public:
   ASMJIT_INLINE Node* del(Node* node) noexcept { return static_cast<Node*>(_del(node)); }
 };
 
+// ============================================================================
+// [asmjit::ZoneOpenHashBase]
+// ============================================================================
+
+//! Open-addressing hash table of \ref ZoneHashNode nodes.
+//!
+//! Slots are probed linearly. Each slot has a 32-bit fingerprint (the hash of
+//! its node), and fingerprints are stored in their own array, so a lookup
+//! reads a node only if its fingerprint matches. One 64-byte cache line holds
+//! 16 fingerprints.
+//!
+//! The table grows incrementally. When it's 3/4 full a table with twice the
+//! capacity is allocated and new nodes go there. Each `_put()` and `_del()`
+//! then moves nodes of `kMigrateCount` slots from the old table, so no single
+//! insertion has to rehash all nodes. Lookups check both tables while nodes
+//! are being moved.
+class ZoneOpenHashBase {
+public:
+  ASMJIT_NONCOPYABLE(ZoneOpenHashBase)
+
+  enum {
+    kFpEmpty = 0,                        //!< Fingerprint of an empty slot.
+    kFpDeleted = 1,                      //!< Fingerprint of a moved or deleted slot (only in the old table).
+    kFpFirst = 2,                        //!< First fingerprint of a node.
+
+    kMinCapacity = 16,                   //!< Capacity of the first allocated table.
+    kMigrateCount = 4                    //!< Slots of the old table moved per `_put()` and `_del()`.
+  };
+
+  //! Table data.
+  struct Table {
+    uint32_t* fps;                       //!< Fingerprints.
+    ZoneHashNode** nodes;                //!< Nodes.
+    uint32_t mask;                       //!< Capacity minus one.
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE ZoneOpenHashBase(ZoneHeap* heap) noexcept {
+    _heap = heap;
+    _size = 0;
+    _growAt = 0;
+    _oldIndex = 0;
+    _oldSize = 0;
+    _embedded = kFpEmpty;
+
+    _table.fps = &_embedded;
+    _table.nodes = nullptr;
+    _table.mask = 0;
+
+    _old.fps = nullptr;
+    _old.nodes = nullptr;
+    _old.mask = 0;
+  }
+  ASMJIT_INLINE ~ZoneOpenHashBase() noexcept { reset(nullptr); }
+
+  // --------------------------------------------------------------------------
+  // [Reset]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE bool isInitialized() const noexcept { return _heap != nullptr; }
+  ASMJIT_API void reset(ZoneHeap* heap) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get a `ZoneHeap` attached to this container.
+  ASMJIT_INLINE ZoneHeap* getHeap() const noexcept { return _heap; }
+
+  ASMJIT_INLINE size_t getSize() const noexcept { return _size; }
+  //! Get the capacity of the table that receives new nodes.
+  ASMJIT_INLINE size_t getCapacity() const noexcept { return _table.fps == &_embedded ? size_t(0) : size_t(_table.mask) + 1; }
+  //! Get if nodes are being moved from the old table.
+  ASMJIT_INLINE bool isMigrating() const noexcept { return _old.fps != nullptr; }
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  static ASMJIT_INLINE uint32_t _fpOf(uint32_t hVal) noexcept {
+    return hVal >= kFpFirst ? hVal : hVal + kFpFirst;
+  }
+
+  static ASMJIT_INLINE uint32_t _slotOf(uint32_t fp, uint32_t mask) noexcept {
+    uint32_t x = fp * 0x9E3779B1U;
+    return (x ^ (x >> 16)) & mask;
+  }
+
+  ASMJIT_API bool _grow() noexcept;
+  ASMJIT_API void _migrate(uint32_t n) noexcept;
+  ASMJIT_API ZoneHashNode* _put(ZoneHashNode* node) noexcept;
+  ASMJIT_API ZoneHashNode* _del(ZoneHashNode* node) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  ZoneHeap* _heap;                       //!< ZoneHeap used to allocate data.
+  size_t _size;                          //!< Count of nodes in both tables.
+  size_t _growAt;                        //!< Size at which the table grows.
+
+  Table _table;                          //!< Table that receives new nodes.
+  Table _old;                            //!< Table being moved to `_table`, if any.
+  uint32_t _oldIndex;                    //!< Index of the next slot of `_old` to move.
+  uint32_t _oldSize;                     //!< Count of nodes remaining in `_old`.
+  uint32_t _embedded;                    //!< Fingerprint of the empty table.
+};
+
+// ============================================================================
+// [asmjit::ZoneOpenHash<Node>]
+// ============================================================================
+
+//! Open-addressing variant of \ref ZoneHash<>, which has the same interface
+//! and uses the same nodes.
+//!
+//! Prefer it for tables of many nodes that are mostly looked up, as probing
+//! reads consecutive fingerprints instead of following a chain of nodes, and
+//! growing never rehashes all nodes at once. Unlike `ZoneHash::put()`, `put()`
+//! returns null if the table ran out of memory.
+template<typename Node>
+class ZoneOpenHash : public ZoneOpenHashBase {
+public:
+  explicit ASMJIT_INLINE ZoneOpenHash(ZoneHeap* heap = nullptr) noexcept
+    : ZoneOpenHashBase(heap) {}
+  ASMJIT_INLINE ~ZoneOpenHash() noexcept {}
+
+  template<typename Key>
+  ASMJIT_INLINE Node* get(const Key& key) const noexcept {
+    uint32_t fp = _fpOf(key.hVal);
+
+    Node* node = _getFrom(_table, fp, key);
+    if (!node && _old.fps)
+      node = _getFrom(_old, fp, key);
+    return node;
+  }
+
+  ASMJIT_INLINE Node* put(Node* node) noexcept { return static_cast<Node*>(_put(node)); }
+  ASMJIT_INLINE Node* del(Node* node) noexcept { return static_cast<Node*>(_del(node)); }
+
+  template<typename Key>
+  static ASMJIT_INLINE Node* _getFrom(const Table& table, uint32_t fp, const Key& key) noexcept {
+    uint32_t mask = table.mask;
+    uint32_t i = _slotOf(fp, mask);
+
+    for (;;) {
+      uint32_t x = table.fps[i];
+      if (x == fp) {
+        Node* node = static_cast<Node*>(table.nodes[i]);
+        if (key.matches(node))
+          return node;
+      }
+      else if (x == kFpEmpty) {
+        return nullptr;
+      }
+      i = (i + 1) & mask;
+    }
+  }
+};
+
 //! \}
 
 } // asmjit namespace
@@ -12,12 +12,18 @@
 #include "./base.h"
 
 #include "./x86/x86assembler.h"
+#include "./x86/x86avxcleanup.h"
 #include "./x86/x86builder.h"
 #include "./x86/x86compiler.h"
+#include "./x86/x86cse.h"
 #include "./x86/x86emitter.h"
+#include "./x86/x86inliner.h"
 #include "./x86/x86inst.h"
+#include "./x86/x86licm.h"
 #include "./x86/x86misc.h"
 #include "./x86/x86operand.h"
+#include "./x86/x86peephole.h"
+#include "./x86/x86profile.h"
 
 // [Guard]
 #endif // _ASMJIT_X86_H
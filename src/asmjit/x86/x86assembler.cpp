@@ -3782,6 +3782,30 @@ EmitModSib:
           }
         }
 
+        // If the memory operand is relative, but the base address is not known
+        // yet, the displacement is calculated by the relocator.
+        if (rmRel->as<X86Mem>().isRel() && baseAddress == Globals::kNoBaseAddress) {
+          if (ASMJIT_UNLIKELY(_code->_relocations.willGrow(&_code->_baseHeap) != kErrorOk))
+            goto NoHeapMemory;
+
+          err = _code->newRelocEntry(&re, RelocEntry::kTypeAbsToRel, 4);
+          if (ASMJIT_UNLIKELY(err)) goto Failed;
+
+          EMIT_BYTE(x86EncodeMod(0, opReg, 5));
+
+          // The displacement is relative to the end of the instruction, which
+          // follows the immediate, if any.
+          re->_sourceSectionId = _section->getId();
+          re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(cursor - _bufferData));
+          re->_data = static_cast<uint64_t>(rmRel->as<X86Mem>().getOffset() - static_cast<int64_t>(imLen));
+
+          EMIT_32(0);
+          if (imLen != 0)
+            goto EmitImm;
+          else
+            goto EmitDone;
+        }
+
         if (ASMJIT_UNLIKELY(!absoluteValid))
           goto InvalidAddress64Bit;
 
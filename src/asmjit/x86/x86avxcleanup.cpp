@@ -0,0 +1,329 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../x86/x86avxcleanup.h"
+#include "../x86/x86compiler.h"
+#include "../x86/x86operand.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86AvxCleanup - Utils]
+// ============================================================================
+
+//! \internal
+//!
+//! Get whether the instruction having `opCount` operands `opArray` makes the
+//! upper parts of YMM/ZMM registers dirty - it uses a YMM or ZMM register.
+static ASMJIT_INLINE bool X86AvxCleanup_makesDirty(const Operand* opArray, uint32_t opCount) noexcept {
+  for (uint32_t i = 0; i < opCount; i++) {
+    const Operand& op = opArray[i];
+    if (X86Reg::isYmm(op) || X86Reg::isZmm(op))
+      return true;
+  }
+
+  return false;
+}
+
+//! \internal
+//!
+//! Get whether the type-id `typeId` is passed in a YMM or ZMM register.
+static ASMJIT_INLINE bool X86AvxCleanup_isWideVec(uint32_t typeId) noexcept {
+  return TypeId::isVec256(typeId) || TypeId::isVec512(typeId);
+}
+
+//! \internal
+//!
+//! Get whether the function described by `fd` passes or returns YMM/ZMM
+//! registers - 'vzeroupper' would destroy them.
+static bool X86AvxCleanup_usesWideVec(const FuncDetail& fd) noexcept {
+  uint32_t i;
+
+  for (i = 0; i < fd.getArgCount(); i++)
+    if (X86AvxCleanup_isWideVec(fd.getArg(i).getTypeId()))
+      return true;
+
+  for (i = 0; i < fd.getRetCount(); i++)
+    if (X86AvxCleanup_isWideVec(fd.getRet(i).getTypeId()))
+      return true;
+
+  return false;
+}
+
+//! \internal
+//!
+//! Get whether the callee of `node` doesn't need 'vzeroupper'.
+static ASMJIT_INLINE bool X86AvxCleanup_isCleanCall(const CCFuncCall* node) noexcept {
+  return node->hasAttribute(CCFuncCall::kX86AttrAvxClean) ||
+         X86AvxCleanup_usesWideVec(node->getDetail());
+}
+
+//! \internal
+//!
+//! Effect of a node on the state of upper parts of YMM/ZMM registers.
+ASMJIT_ENUM(X86AvxCleanupEffect) {
+  kX86AvxCleanupNone     = 0,            //!< Doesn't change the state.
+  kX86AvxCleanupDirty    = 1,            //!< Makes the state dirty.
+  kX86AvxCleanupClean    = 2,            //!< Makes the state clean.
+  kX86AvxCleanupLeave    = 3,            //!< Leaves to a legacy code, requires clean state.
+  kX86AvxCleanupLabel    = 4,            //!< Merges the state of the label.
+  kX86AvxCleanupFunc     = 5,            //!< Starts a function with the state of its label.
+  kX86AvxCleanupJcc      = 6,            //!< Propagates the state to the target.
+  kX86AvxCleanupJmp      = 7             //!< Propagates the state to the target and ends the block.
+};
+
+// ============================================================================
+// [asmjit::X86AvxCleanupPass - Construction / Destruction]
+// ============================================================================
+
+X86AvxCleanupPass::X86AvxCleanupPass() noexcept
+  : CBPass("AvxCleanup"),
+    _insertedCount(0) {}
+X86AvxCleanupPass::~X86AvxCleanupPass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86AvxCleanupPass - Interface]
+// ============================================================================
+
+Error X86AvxCleanupPass::process(Zone* zone) noexcept {
+  CodeBuilder* cb = _cb;
+  _insertedCount = 0;
+
+  // Nothing to do if the code never makes the state dirty, which is the common
+  // case. A single walk over the nodes is cheaper than building the store.
+  CBNode* node;
+  for (node = cb->getFirstNode(); node; node = node->getNext()) {
+    if (node->getType() == CBNode::kNodeInst) {
+      CBInst* inst = static_cast<CBInst*>(node);
+      if (X86AvxCleanup_makesDirty(inst->getOpArray(), inst->getOpCount()))
+        break;
+    }
+  }
+
+  if (!node)
+    return kErrorOk;
+
+  // Dirty state at each label, as merged from all jumps to it. The state that
+  // falls through to a label is handled inline when the label is visited.
+  size_t labelCount = cb->getCode()->getLabelsCount();
+  uint8_t* labelDirty = nullptr;
+
+  if (labelCount) {
+    labelDirty = zone->allocZeroedT<uint8_t>(labelCount);
+    if (ASMJIT_UNLIKELY(!labelDirty))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+  }
+
+  // The analysis may need many iterations over the whole code. The effect of
+  // each node is computed once from a compact store of nodes, iterations then
+  // only stream effects and label ids, and access nodes to insert 'vzeroupper'.
+  CBNodeStore store;
+  ASMJIT_PROPAGATE(store.init(zone, cb->getFirstNode()));
+
+  uint32_t i;
+  uint32_t count = store.getCount();
+
+  uint8_t* effects = zone->allocT<uint8_t>(count);
+  if (ASMJIT_UNLIKELY(count && !effects))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  bool retIsWide = false;                // Current function returns YMM/ZMM registers.
+
+  for (i = 0; i < count; i++) {
+    uint32_t effect = kX86AvxCleanupNone;
+
+    switch (store.getType(i)) {
+      case CBNode::kNodeFunc:
+        retIsWide = X86AvxCleanup_usesWideVec(static_cast<CCFunc*>(store.getNode(i))->getDetail());
+        effect = kX86AvxCleanupFunc;
+        break;
+
+      case CBNode::kNodeLabel:
+        effect = kX86AvxCleanupLabel;
+        break;
+
+      case CBNode::kNodeSentinel:
+        effect = kX86AvxCleanupClean;
+        break;
+
+      case CBNode::kNodeFuncCall:
+        // The callee follows the ABI and returns with clean state.
+        if (!X86AvxCleanup_isCleanCall(static_cast<CCFuncCall*>(store.getNode(i))))
+          effect = kX86AvxCleanupLeave;
+        break;
+
+      case CBNode::kNodeInst: {
+        uint32_t instId = store.getInstId(i);
+
+        if (store.hasFlag(i, CBNode::kFlagIsJmp))
+          effect = kX86AvxCleanupJmp;
+        else if (store.hasFlag(i, CBNode::kFlagIsJcc))
+          effect = kX86AvxCleanupJcc;
+        else if (instId == X86Inst::kIdVzeroupper || instId == X86Inst::kIdVzeroall)
+          effect = kX86AvxCleanupClean;
+        else if (instId == X86Inst::kIdCall || (instId == X86Inst::kIdRet && !retIsWide))
+          effect = kX86AvxCleanupLeave;
+        else if (X86AvxCleanup_makesDirty(store.getOpArray(i), store.getOpCount(i)))
+          effect = kX86AvxCleanupDirty;
+        break;
+      }
+    }
+
+    effects[i] = static_cast<uint8_t>(effect);
+  }
+
+  bool unfollowed = false;               // Dirty state reached an unfollowed jump.
+  bool insert = false;                   // Last iteration, insert 'vzeroupper'.
+
+  // Iterate until the states of all labels are stable (the first iteration
+  // without a change can already insert, as the analysis is deterministic).
+  for (;;) {
+    bool changed = false;
+    bool dirty = false;
+
+    for (i = 0; i < count; i++) {
+      uint32_t effect = effects[i];
+
+      switch (effect) {
+        case kX86AvxCleanupDirty:
+          dirty = true;
+          break;
+
+        case kX86AvxCleanupClean:
+          dirty = false;
+          break;
+
+        case kX86AvxCleanupLeave:
+          if (dirty && insert) {
+            CBNode* prevCursor = cb->setCursor(store.getNode(i)->getPrev());
+            ASMJIT_PROPAGATE(cb->emit(X86Inst::kIdVzeroupper));
+            cb->setCursor(prevCursor);
+            _insertedCount++;
+          }
+
+          dirty = false;
+          break;
+
+        case kX86AvxCleanupLabel:
+          dirty |= labelDirty[Operand::unpackId(store.getLabelId(i))] != 0;
+          break;
+
+        case kX86AvxCleanupFunc:
+          dirty = labelDirty[Operand::unpackId(store.getLabelId(i))] != 0;
+          break;
+
+        case kX86AvxCleanupJcc:
+        case kX86AvxCleanupJmp:
+          if (dirty) {
+            uint32_t targetId = store.getLabelId(i);
+            if (targetId) {
+              uint8_t& targetDirty = labelDirty[Operand::unpackId(targetId)];
+              changed |= targetDirty == 0;
+              targetDirty = 1;
+            }
+            else if (!unfollowed) {
+              // Jump to an unknown location, any label can be reached.
+              ::memset(labelDirty, 1, labelCount);
+              unfollowed = true;
+              changed = true;
+            }
+          }
+
+          if (effect == kX86AvxCleanupJmp)
+            dirty = false;
+          break;
+      }
+    }
+
+    if (insert)
+      break;
+
+    if (!changed)
+      insert = true;
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86AvxCleanupPass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_avx_cleanup) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  X86AvxCleanupPass* pass = nullptr;
+
+  for (size_t i = 0; i < cc.getPasses().getLength(); i++)
+    if (::strcmp(cc.getPasses()[i]->getName(), "AvxCleanup") == 0)
+      pass = static_cast<X86AvxCleanupPass*>(cc.getPasses()[i]);
+
+  INFO("Checking X86AvxCleanupPass is added by X86Compiler");
+  EXPECT(pass != nullptr);
+
+  // Function that never uses YMM registers doesn't need any 'vzeroupper'.
+  cc.addFunc(FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+
+  X86Gp a = cc.newInt32("a");
+  X86Xmm x = cc.newXmm("x");
+
+  cc.setArg(0, a);
+  cc.vpxor(x, x, x);
+  cc.call(imm_ptr((void*)0x1000), FuncSignature0<void>(CallConv::kIdX86SysV64));
+  cc.vmovd(a, x);
+  cc.ret(a);
+  cc.endFunc();
+
+  // Function that calls a legacy function in a loop that dirties the state,
+  // calls an AVX-clean function, and returns with the state dirty.
+  cc.addFunc(FuncSignature1<void, int>(CallConv::kIdX86SysV64));
+
+  X86Gp n = cc.newInt32("n");
+  X86Ymm y = cc.newYmm("y");
+  Label L_Loop = cc.newLabel();
+
+  cc.setArg(0, n);
+  cc.bind(L_Loop);
+  cc.call(imm_ptr((void*)0x1000), FuncSignature0<void>(CallConv::kIdX86SysV64));
+  cc.vpxor(y, y, y);
+  cc.dec(n);
+  cc.jnz(L_Loop);
+
+  CCFuncCall* call = cc.call(imm_ptr((void*)0x2000), FuncSignature0<void>(CallConv::kIdX86SysV64));
+  call->addAttributes(CCFuncCall::kX86AttrAvxClean);
+  cc.endFunc();
+
+  INFO("Checking X86AvxCleanupPass inserts 'vzeroupper' before the looped call and the return");
+  EXPECT(cc.finalize() == kErrorOk);
+  EXPECT(pass->getInsertedCount() == 2,
+    "X86AvxCleanupPass inserted %u 'vzeroupper', expected 2", pass->getInsertedCount());
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
@@ -0,0 +1,83 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86AVXCLEANUP_H
+#define _ASMJIT_X86_X86AVXCLEANUP_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codebuilder.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::X86AvxCleanupPass]
+// ============================================================================
+
+//! AVX cleanup, \ref CBPass that inserts 'vzeroupper' where the code leaves
+//! to a code that may use legacy SSE instructions.
+//!
+//! The pass tracks whether the upper parts of YMM/ZMM registers can be dirty
+//! (any instruction that uses a YMM or ZMM register makes them dirty,
+//! 'vzeroupper' and 'vzeroall' make them clean) across the whole control flow
+//! graph and inserts 'vzeroupper' only before function calls and returns that
+//! can be reached with the dirty state. Calls to functions that pass or return
+//! YMM/ZMM registers and calls marked by \ref CCFuncCall::kX86AttrAvxClean are
+//! considered AVX-clean and don't require 'vzeroupper'.
+//!
+//! The pass is added by `X86Compiler` and runs after the register allocator,
+//! so it sees the final instructions (including spills, prolog and epilog).
+class ASMJIT_VIRTAPI X86AvxCleanupPass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86AvxCleanupPass)
+  typedef CBPass Base;
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API X86AvxCleanupPass() noexcept;
+  ASMJIT_API virtual ~X86AvxCleanupPass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get how many 'vzeroupper' instructions were inserted by the last `process()`.
+  ASMJIT_INLINE uint32_t getInsertedCount() const noexcept { return _insertedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _insertedCount;               //!< Number of inserted 'vzeroupper' instructions.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86AVXCLEANUP_H
@@ -13,9 +13,12 @@
 
 // [Dependencies]
 #include "../base/utils.h"
+#include "../x86/x86avxcleanup.h"
 #include "../x86/x86compiler.h"
 #include "../x86/x86regalloc_p.h"
 
+#include <algorithm>
+
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
 
@@ -40,8 +43,8 @@ Error X86Compiler::onAttach(CodeHolder* code) noexcept {
   if (!ArchInfo::isX86Family(archType))
     return DebugUtils::errored(kErrorInvalidArch);
 
-  ASMJIT_PROPAGATE(_cbPasses.willGrow(&_cbHeap, 1));
   ASMJIT_PROPAGATE(Base::onAttach(code));
+  ASMJIT_PROPAGATE(_cbPasses.willGrow(&_cbHeap, 2));
 
   if (archType == ArchInfo::kTypeX86)
     _nativeGpArray = x86OpData.gpd;
@@ -49,7 +52,8 @@ Error X86Compiler::onAttach(CodeHolder* code) noexcept {
     _nativeGpArray = x86OpData.gpq;
   _nativeGpReg = _nativeGpArray[0];
 
-  return addPassT<X86RAPass>();
+  ASMJIT_PROPAGATE(addPassT<X86RAPass>());
+  return addPassT<X86AvxCleanupPass>();
 }
 
 // ============================================================================
@@ -65,17 +69,7 @@ Error X86Compiler::finalize() {
     _globalConstPool = nullptr;
   }
 
-  Error err = kErrorOk;
-  ZoneVector<CBPass*>& passes = _cbPasses;
-
-  for (size_t i = 0, len = passes.getLength(); i < len; i++) {
-    CBPass* pass = passes[i];
-    err = pass->process(&_cbPassZone);
-    _cbPassZone.reset();
-    if (err) break;
-  }
-
-  _cbPassZone.reset();
+  Error err = runPasses();
   if (ASMJIT_UNLIKELY(err)) return setLastError(err);
 
   // TODO: There must be possibility to attach more assemblers, this is not so nice.
@@ -367,6 +361,178 @@ Error X86Compiler::_emit(uint32_t instId, const Operand_& o0, const Operand_& o1
   }
 }
 
+// ============================================================================
+// [asmjit::X86Compiler - Const]
+// ============================================================================
+
+//! \internal
+//!
+//! Get the size of the smallest element `data` is a broadcast of, or `size` if
+//! it's not a broadcast.
+static size_t X86Compiler_getBroadcastSize(const void* data, size_t size) noexcept {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+
+  for (size_t elementSize = 1; elementSize < size; elementSize <<= 1) {
+    if (::memcmp(p, p + elementSize, size - elementSize) == 0)
+      return elementSize;
+  }
+
+  return size;
+}
+
+X86Mem X86Compiler::newBroadcastConst(uint32_t scope, const void* data, size_t size) {
+  size_t elementSize = X86Compiler_getBroadcastSize(data, size);
+
+  // Embedded broadcast works only with 32-bit and 64-bit elements, smaller
+  // elements are broadcasts of 32-bit elements as well.
+  if (size >= 16 && elementSize < size)
+    size = std::max<size_t>(elementSize, 4);
+
+  return newConst(scope, data, size);
+}
+
+Error X86Compiler::_loadConst(const X86Vec& dst, uint32_t scope, const void* data) {
+  if (!dst.isXmm() && !dst.isYmm() && !dst.isZmm())
+    return setLastError(DebugUtils::errored(kErrorInvalidArgument));
+
+  // YMM and ZMM registers imply AVX even if it's not enabled for the function.
+  CCFunc* func = getFunc();
+  bool avxEnabled = !dst.isXmm() || (func && func->getFrameInfo().isAvxEnabled());
+  bool avx512Enabled = func && func->getFrameInfo().isAvx512Enabled();
+
+  size_t size = dst.getSize();
+  size_t elementSize = X86Compiler_getBroadcastSize(data, size);
+  uint8_t element = static_cast<const uint8_t*>(data)[0];
+
+  // All bits zero or all bits set - zero and ones idioms.
+  if (elementSize == 1 && (element == 0x00 || element == 0xFF)) {
+    if (element == 0x00) {
+      if (dst.isZmm())
+        return emit(X86Inst::kIdVpxord, dst, dst, dst);
+      else if (avxEnabled)
+        return emit(X86Inst::kIdVxorps, dst, dst, dst);
+      else
+        return emit(X86Inst::kIdXorps, dst, dst);
+    }
+    else {
+      if (dst.isZmm())
+        return emit(X86Inst::kIdVpternlogd, dst, dst, dst, Imm(0xFF));
+      // YMM `vpcmpeqd` requires AVX2, which is implied by AVX-512.
+      else if (dst.isXmm() ? avxEnabled : avx512Enabled)
+        return emit(X86Inst::kIdVpcmpeqd, dst, dst, dst);
+      else if (dst.isXmm())
+        return emit(X86Inst::kIdPcmpeqd, dst, dst);
+    }
+  }
+
+  X86Mem m(NoInit);
+  if (elementSize < size && (avxEnabled || dst.isZmm())) {
+    // 8-bit and 16-bit broadcasts are loaded as 32-bit broadcasts, so they
+    // don't require AVX512-BW when `dst` is ZMM or XMM|YMM 16-31.
+    elementSize = std::max<size_t>(elementSize, 4);
+    ASMJIT_PROPAGATE(_newConst(m, scope, data, elementSize));
+
+    if (dst.isZmm() || avx512Enabled)
+      return emit(elementSize == 4 ? X86Inst::kIdVpbroadcastd : X86Inst::kIdVpbroadcastq, dst, m);
+    else if (elementSize == 4)
+      return emit(X86Inst::kIdVbroadcastss, dst, m);
+    else if (dst.isYmm())
+      return emit(X86Inst::kIdVbroadcastsd, dst, m);
+    else
+      return emit(X86Inst::kIdVmovddup, dst, m);
+  }
+
+  ASMJIT_PROPAGATE(_newConst(m, scope, data, size));
+  if (dst.isZmm())
+    return emit(X86Inst::kIdVmovdqa32, dst, m);
+  else if (avxEnabled)
+    return emit(X86Inst::kIdVmovaps, dst, m);
+  else
+    return emit(X86Inst::kIdMovaps, dst, m);
+}
+
+// ============================================================================
+// [asmjit::X86Compiler - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_compiler_nodestore) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  Zone zone(8096 - Zone::kZoneOverhead);
+  CBNodeStore store;
+  Label L = cc.newLabel();
+
+  cc.comment("first");
+  CBNode* first = cc.getLastNode();
+
+  cc.bind(L);
+  cc.mov(x86::eax, x86::ebx);
+  cc.add(x86::eax, x86::dword_ptr(x86::rcx, 8));
+  cc.jnz(L);
+
+  cc.comment("stop");
+  CBNode* stop = cc.getLastNode();
+  cc.nop();
+
+  INFO("Checking CBNodeStore stores the range of nodes");
+  EXPECT(store.init(&zone, first, stop) == kErrorOk);
+  EXPECT(store.getCount() == 5,
+    "CBNodeStore stored %u nodes, expected 5", store.getCount());
+
+  static const uint32_t types[] = {
+    CBNode::kNodeComment, CBNode::kNodeLabel, CBNode::kNodeInst, CBNode::kNodeInst, CBNode::kNodeInst
+  };
+  static const uint32_t instIds[] = {
+    Inst::kIdNone, Inst::kIdNone, X86Inst::kIdMov, X86Inst::kIdAdd, X86Inst::kIdJnz
+  };
+
+  uint32_t i;
+  CBNode* node = first;
+
+  for (i = 0; i < 5; i++, node = node->getNext()) {
+    EXPECT(store.getNode(i) == node);
+    EXPECT(store.getType(i) == types[i],
+      "CBNodeStore node #%u has type %u, expected %u", i, store.getType(i), types[i]);
+    EXPECT(store.getFlags(i) == node->getFlags());
+    EXPECT(store.getInstId(i) == instIds[i],
+      "CBNodeStore node #%u has instruction %u, expected %u", i, store.getInstId(i), instIds[i]);
+
+    uint32_t opCount = node->getType() == CBNode::kNodeInst ? static_cast<CBInst*>(node)->getOpCount() : 0;
+    EXPECT(store.getOpCount(i) == opCount,
+      "CBNodeStore node #%u has %u operands, expected %u", i, store.getOpCount(i), opCount);
+
+    for (uint32_t j = 0; j < opCount; j++)
+      EXPECT(store.getOpArray(i)[j].isEqual(static_cast<CBInst*>(node)->getOpArray()[j]));
+  }
+
+  EXPECT(store.getLabelId(0) == 0);
+  EXPECT(store.getLabelId(1) == L.getId());
+  EXPECT(store.getLabelId(2) == 0);
+  EXPECT(store.getLabelId(4) == L.getId());
+  EXPECT(store.hasFlag(4, CBNode::kFlagIsJcc));
+
+  EXPECT(store.findType(0, CBNode::kNodeInst) == 2);
+  EXPECT(store.findType(3, CBNode::kNodeInst) == 3);
+  EXPECT(store.findType(0, CBNode::kNodeFunc) == 5);
+
+  INFO("Checking CBNodeStore stores all nodes up to the end of the list");
+  EXPECT(store.init(&zone, first) == kErrorOk);
+  EXPECT(store.getCount() == 7,
+    "CBNodeStore stored %u nodes, expected 7", store.getCount());
+  EXPECT(store.getNode(6) == cc.getLastNode());
+  EXPECT(store.getInstId(6) == X86Inst::kIdNop);
+
+  INFO("Checking CBNodeStore stores an empty range");
+  EXPECT(store.init(&zone, first, first) == kErrorOk);
+  EXPECT(store.getCount() == 0);
+}
+#endif // ASMJIT_TEST
+
 } // asmjit namespace
 
 // [Api-End]
@@ -244,6 +244,41 @@ public:
   ASMJIT_INLINE X86Mem newXmmConst(uint32_t scope, const Data128& val) noexcept { return newConst(scope, &val, 16); }
   //! Put a YMM `val` to a constant-pool.
   ASMJIT_INLINE X86Mem newYmmConst(uint32_t scope, const Data256& val) noexcept { return newConst(scope, &val, 32); }
+  //! Put a ZMM `val` to a constant-pool.
+  ASMJIT_INLINE X86Mem newZmmConst(uint32_t scope, const Data512& val) noexcept { return newConst(scope, &val, 64); }
+
+  //! Put a vector constant to a constant-pool, but store only its element if
+  //! the constant is a broadcast of a single element.
+  //!
+  //! The returned memory operand has the size of the element (4 or 8 bytes) in
+  //! that case and has to be used by an AVX-512 instruction with an embedded
+  //! broadcast `{1toN}`, which is selected by `_1tox()`:
+  //!
+  //! ~~~
+  //! X86Mem c = cc.newBroadcastConst(kConstScopeLocal, &val, 64);
+  //! if (c.getSize() != 64)
+  //!   cc._1tox();
+  //! cc.vpaddd(zmm, zmm, c);
+  //! ~~~
+  ASMJIT_API X86Mem newBroadcastConst(uint32_t scope, const void* data, size_t size);
+
+  //! \internal
+  ASMJIT_API Error _loadConst(const X86Vec& dst, uint32_t scope, const void* data);
+
+  //! Load a XMM constant `val` to `dst`.
+  //!
+  //! Constants having all bits zero or all bits set are materialized by a zero
+  //! or ones idiom and take no space in the constant-pool. A broadcast of a
+  //! single element is stored as a scalar and loaded by `vbroadcastss`,
+  //! `vbroadcastsd`, `vmovddup`, or `vpbroadcastd|q`, other constants are
+  //! loaded as is. Broadcasts require AVX to be enabled for the function (see
+  //! \ref FuncFrameInfo::kX86AttrAvxEnabled), the SSE code loads a full 16-byte
+  //! constant instead. AVX2 is assumed only if AVX-512 is enabled as well.
+  ASMJIT_INLINE Error loadConst(const X86Xmm& dst, uint32_t scope, const Data128& val) { return _loadConst(dst, scope, &val); }
+  //! Load a YMM constant `val` to `dst`, see \ref loadConst(const X86Xmm&, uint32_t, const Data128&).
+  ASMJIT_INLINE Error loadConst(const X86Ymm& dst, uint32_t scope, const Data256& val) { return _loadConst(dst, scope, &val); }
+  //! Load a ZMM constant `val` to `dst`, see \ref loadConst(const X86Xmm&, uint32_t, const Data128&).
+  ASMJIT_INLINE Error loadConst(const X86Zmm& dst, uint32_t scope, const Data512& val) { return _loadConst(dst, scope, &val); }
 
   // -------------------------------------------------------------------------
   // [Instruction Options]
@@ -0,0 +1,678 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../x86/x86compiler.h"
+#include "../x86/x86cse.h"
+#include "../x86/x86operand.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86CseEntry]
+// ============================================================================
+
+//! \internal
+//!
+//! Expression computed by an instruction, stored in `X86CseContext`.
+//!
+//! Operands are copied from the instruction, but ids of virtual registers are
+//! replaced by their value numbers, so expressions can be compared by operands.
+struct X86CseEntry {
+  X86CseEntry* next;                     //!< Next entry in the bucket.
+  uint32_t hVal;                         //!< Hash value of the expression.
+  uint32_t value;                        //!< Value number of the result.
+  uint32_t holderId;                     //!< Virtual register that received the result.
+
+  uint32_t instId;                       //!< Instruction id.
+  uint32_t options;                      //!< Instruction options.
+  uint32_t opCount;                      //!< Number of operands.
+  uint32_t memEpoch;                     //!< Memory epoch of a load, or zero.
+  Operand_ opArray[6];                   //!< Operands (value numbers instead of virtual registers).
+};
+
+// ============================================================================
+// [asmjit::X86CseContext]
+// ============================================================================
+
+//! \internal
+//!
+//! State of the CSE pass.
+//!
+//! Value numbers of virtual registers are valid only if their stamp matches
+//! the current `block`, so nothing has to be cleared when a block ends except
+//! the hash table buckets that were used.
+struct X86CseContext {
+  enum {
+    kBucketCount = 256                   //!< Number of hash table buckets.
+  };
+
+  X86Compiler* cc;                       //!< Compiler.
+  Zone* zone;                            //!< Zone used to allocate entries.
+
+  uint32_t block;                        //!< Current block (stamp).
+  uint32_t valueCount;                   //!< Last value number assigned.
+  uint32_t memEpoch;                     //!< Incremented by each memory write.
+  uint32_t entryCount;                   //!< Number of entries in the current block.
+
+  uint32_t vregCount;                    //!< Number of virtual registers.
+  uint32_t* vregStamp;                   //!< Virtual register stamps.
+  uint32_t* vregValue;                   //!< Value numbers of virtual registers.
+
+  X86CseEntry* buckets[kBucketCount];    //!< Hash table of expressions.
+};
+
+// ============================================================================
+// [asmjit::X86Cse - Utils]
+// ============================================================================
+
+//! \internal
+static const uint32_t X86Cse_kArithFlags =
+  x86::kSpecialReg_FLAGS_CF | x86::kSpecialReg_FLAGS_PF | x86::kSpecialReg_FLAGS_AF |
+  x86::kSpecialReg_FLAGS_ZF | x86::kSpecialReg_FLAGS_SF | x86::kSpecialReg_FLAGS_OF;
+
+//! \internal
+//!
+//! Start a new block - forget all value numbers and expressions.
+static ASMJIT_INLINE void X86Cse_newBlock(X86CseContext& ctx) noexcept {
+  ctx.block++;
+  if (ctx.entryCount) {
+    ::memset(ctx.buckets, 0, sizeof(ctx.buckets));
+    ctx.entryCount = 0;
+  }
+}
+
+//! \internal
+//!
+//! Get the value number of a virtual register `id`, a new value is assigned if
+//! the register hasn't been read or written in the current block yet.
+static ASMJIT_INLINE uint32_t X86Cse_getValue(X86CseContext& ctx, uint32_t id) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  if (!Operand::isPackedId(id) || index >= ctx.vregCount)
+    return 0;
+
+  if (ctx.vregStamp[index] != ctx.block) {
+    ctx.vregStamp[index] = ctx.block;
+    ctx.vregValue[index] = ++ctx.valueCount;
+  }
+  return ctx.vregValue[index];
+}
+
+//! \internal
+static ASMJIT_INLINE void X86Cse_setValue(X86CseContext& ctx, uint32_t id, uint32_t value) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  if (!Operand::isPackedId(id) || index >= ctx.vregCount)
+    return;
+
+  ctx.vregStamp[index] = ctx.block;
+  ctx.vregValue[index] = value;
+}
+
+//! \internal
+static ASMJIT_INLINE void X86Cse_newValue(X86CseContext& ctx, uint32_t id) noexcept {
+  X86Cse_setValue(ctx, id, ++ctx.valueCount);
+}
+
+//! \internal
+//!
+//! Get whether the instruction `node` writes memory or has side effects that
+//! prevent reusing loads across it.
+static bool X86Cse_writesMem(const CBInst* node) noexcept {
+  const X86Inst& inst = X86Inst::getInst(node->getInstId());
+  const X86Inst::CommonData& commonData = inst.getCommonData();
+
+  if (commonData.hasFixedMem() || inst.getOperationData().isVolatile())
+    return true;
+
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  // XCHG and XADD write both operands, the memory operand can be the second.
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagUseXX)) {
+    for (uint32_t i = 0; i < opCount; i++)
+      if (opArray[i].isMem())
+        return true;
+    return false;
+  }
+
+  return opCount != 0 && opArray[0].isMem() && !commonData.isUseR();
+}
+
+//! \internal
+//!
+//! Assign new value numbers to virtual registers written by `node`.
+//!
+//! The first operand is written if the instruction is not read-only. All
+//! register operands are considered written if the use information is not
+//! precise (implicit operands, VSIB masks, and instructions like XCHG).
+static void X86Cse_killWrites(X86CseContext& ctx, const CBInst* node) noexcept {
+  const X86Inst::CommonData& commonData = X86Inst::getInst(node->getInstId()).getCommonData();
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagUseXX | X86Inst::kFlagFixedReg | X86Inst::kFlagVsib)) {
+    for (uint32_t i = 0; i < opCount; i++)
+      if (opArray[i].isReg())
+        X86Cse_newValue(ctx, opArray[i].getId());
+  }
+  else if (opCount && opArray[0].isReg() && !commonData.isUseR()) {
+    X86Cse_newValue(ctx, opArray[0].getId());
+  }
+}
+
+//! \internal
+//!
+//! Get whether `instId` is a full register move, see `X86Cse_isCopy()`.
+static ASMJIT_INLINE bool X86Cse_isMoveInst(uint32_t instId) noexcept {
+  switch (instId) {
+    case X86Inst::kIdMov:
+    case X86Inst::kIdMovapd:
+    case X86Inst::kIdMovaps:
+    case X86Inst::kIdMovdqa:
+    case X86Inst::kIdMovdqu:
+    case X86Inst::kIdMovupd:
+    case X86Inst::kIdMovups:
+    case X86Inst::kIdVmovapd:
+    case X86Inst::kIdVmovaps:
+    case X86Inst::kIdVmovdqa:
+    case X86Inst::kIdVmovdqa32:
+    case X86Inst::kIdVmovdqa64:
+    case X86Inst::kIdVmovdqu:
+    case X86Inst::kIdVmovupd:
+    case X86Inst::kIdVmovups:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+//! \internal
+//!
+//! Get whether the register operand `op` covers the whole virtual register.
+static ASMJIT_INLINE bool X86Cse_isWholeReg(X86CseContext& ctx, const Operand_& op) noexcept {
+  if (!op.isReg() || !Operand::isPackedId(op.getId()))
+    return false;
+
+  uint32_t index = Operand::unpackId(op.getId());
+  if (index >= ctx.vregCount)
+    return false;
+
+  VirtReg* vreg = ctx.cc->getVirtRegById(op.getId());
+  uint32_t kind = static_cast<const X86Reg&>(op).getKind();
+  return !vreg->isFixed() && vreg->getKind() == kind && op.getSize() == vreg->getSize() &&
+         (kind == X86Reg::kKindGp || kind == X86Reg::kKindVec);
+}
+
+//! \internal
+//!
+//! Get whether `node` copies a whole virtual register to another one.
+static bool X86Cse_isCopy(X86CseContext& ctx, const CBInst* node) noexcept {
+  if (!X86Cse_isMoveInst(node->getInstId()) || node->getOpCount() != 2 || node->hasExtraReg())
+    return false;
+
+  const Operand* opArray = node->getOpArray();
+  return X86Cse_isWholeReg(ctx, opArray[0]) &&
+         X86Cse_isWholeReg(ctx, opArray[1]) &&
+         opArray[0].getSignature() == opArray[1].getSignature();
+}
+
+//! \internal
+//!
+//! Get whether the instruction `node` is pure - its only effect is writing the
+//! first operand, which must be a whole virtual register, and flags.
+static bool X86Cse_isPure(X86CseContext& ctx, const CBInst* node) noexcept {
+  const X86Inst& inst = X86Inst::getInst(node->getInstId());
+  const X86Inst::CommonData& commonData = inst.getCommonData();
+  const X86Inst::OperationData& operationData = inst.getOperationData();
+
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  if (!opCount || !(commonData.isUseW() || commonData.isUseX()) || node->hasExtraReg())
+    return false;
+
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagUseXX | X86Inst::kFlagFixedMem | X86Inst::kFlagVsib))
+    return false;
+
+  // Instructions like SHL and IMUL use a fixed register in some forms, but
+  // never in 'reg, imm' form.
+  if (commonData.hasFixedReg() && (opCount != 2 || !opArray[1].isImm()))
+    return false;
+
+  if (commonData.isFpu() || commonData.isMmx())
+    return false;
+
+  if (operationData.isVolatile() || operationData.isBarrier() || operationData.isPrefetch() || operationData.isPrivileged())
+    return false;
+
+  // Flags can be written (checked by the caller), but not read.
+  if (operationData.getSpecialRegsR() || (operationData.getSpecialRegsW() & ~X86Cse_kArithFlags))
+    return false;
+
+  if (node->getOptions() & (X86Inst::kOptionLock | X86Inst::kOptionRep | X86Inst::kOptionRepnz))
+    return false;
+
+  // A write of a 32-bit GP register zero extends, other writes must cover
+  // the whole register as the rest of it would be merged.
+  const Operand_& dst = opArray[0];
+  if (!dst.isReg() || !Operand::isPackedId(dst.getId()))
+    return false;
+
+  uint32_t dstIndex = Operand::unpackId(dst.getId());
+  if (dstIndex >= ctx.vregCount)
+    return false;
+
+  if (!X86Cse_isWholeReg(ctx, dst)) {
+    VirtReg* vreg = ctx.cc->getVirtRegById(dst.getId());
+    if (vreg->isFixed() || !X86Reg::isGpd(dst) || vreg->getKind() != X86Reg::kKindGp)
+      return false;
+  }
+
+  // Instructions like MOVSS, SQRTSD, and CVTSI2SS write only a part of the
+  // destination vector and keep the rest, which is not part of the key.
+  if (X86Reg::isVec(dst) && commonData.getWriteSize() != 0) {
+    if (commonData.getWriteIndex() != 0 || commonData.getWriteSize() < dst.getSize())
+      return false;
+  }
+
+  for (uint32_t i = 1; i < opCount; i++) {
+    const Operand_& op = opArray[i];
+    if (op.isReg()) {
+      if (!Operand::isPackedId(op.getId()))
+        return false;
+    }
+    else if (op.isMem()) {
+      const X86Mem& m = static_cast<const X86Mem&>(op);
+      if (m.isRegHome())
+        return false;
+      if (m.hasBaseReg() && !Operand::isPackedId(m.getBaseId()))
+        return false;
+      if (m.hasIndexReg() && !Operand::isPackedId(m.getIndexId()))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+//! \internal
+//!
+//! Get whether the flags written by `node` are overwritten before they are
+//! read by the code that follows it. Only the current block is checked.
+static bool X86Cse_areFlagsDead(const CBNode* node, uint32_t flags) noexcept {
+  for (uint32_t i = 0; i < 32; i++) {
+    node = node->getNext();
+    if (!node) return false;
+
+    switch (node->getType()) {
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+      case CBNode::kNodeHint:
+        continue;
+
+      // Flags are not preserved across function calls and returns.
+      case CBNode::kNodeFuncCall:
+      case CBNode::kNodeFuncExit:
+        return true;
+
+      case CBNode::kNodeInst: {
+        if (node->isJmpOrJcc())
+          return false;
+
+        const X86Inst::OperationData& operationData =
+          X86Inst::getInst(static_cast<const CBInst*>(node)->getInstId()).getOperationData();
+
+        if (operationData.getSpecialRegsR() & flags)
+          return false;
+
+        flags &= ~operationData.getSpecialRegsW();
+        if (!flags)
+          return true;
+        continue;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  return false;
+}
+
+// ============================================================================
+// [asmjit::X86Cse - Expression]
+// ============================================================================
+
+//! \internal
+//!
+//! Initialize the expression `e` computed by a pure instruction `node`.
+static void X86Cse_initEntry(X86CseContext& ctx, X86CseEntry& e, const CBInst* node, bool singleReg) noexcept {
+  const X86Inst::CommonData& commonData = X86Inst::getInst(node->getInstId()).getCommonData();
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  e.next = nullptr;
+  e.instId = node->getInstId();
+  e.options = node->getOptions();
+  e.opCount = opCount;
+  e.memEpoch = 0;
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    Operand_& op = e.opArray[i];
+    op.copyFrom(opArray[i]);
+
+    if (op.isReg()) {
+      // The destination is an input only if it's not write-only. Registers
+      // of 'REG ^ REG' and similar instructions are not inputs at all.
+      bool isInput = i != 0 || commonData.isUseX();
+      op._reg.id = isInput && !singleReg ? X86Cse_getValue(ctx, op.getId()) : 0;
+    }
+    else if (op.isMem()) {
+      X86Mem& m = static_cast<X86Mem&>(op);
+      if (m.hasBaseReg()) m._mem.base = X86Cse_getValue(ctx, m.getBaseId());
+      if (m.hasIndexReg()) m._mem.index = X86Cse_getValue(ctx, m.getIndexId());
+
+      // LEA only computes the address.
+      if (e.instId != X86Inst::kIdLea)
+        e.memEpoch = ctx.memEpoch;
+    }
+  }
+
+  uint32_t hVal = e.instId ^ (e.options * 33) ^ (e.memEpoch << 7);
+  for (uint32_t i = 0; i < opCount; i++) {
+    const Operand_& op = e.opArray[i];
+    hVal = Utils::hashRound(hVal, op.getSignature());
+    hVal = Utils::hashRound(hVal, op._any.id);
+    hVal = Utils::hashRound(hVal, op._any.reserved8_4);
+    hVal = Utils::hashRound(hVal, op._any.reserved12_4);
+  }
+  e.hVal = hVal;
+}
+
+//! \internal
+static bool X86Cse_entryEquals(const X86CseEntry& a, const X86CseEntry& b) noexcept {
+  if (a.hVal != b.hVal || a.instId != b.instId || a.options != b.options || a.opCount != b.opCount || a.memEpoch != b.memEpoch)
+    return false;
+
+  for (uint32_t i = 0; i < a.opCount; i++)
+    if (!a.opArray[i].isEqual(b.opArray[i]))
+      return false;
+  return true;
+}
+
+//! \internal
+static ASMJIT_INLINE X86CseEntry* X86Cse_find(X86CseContext& ctx, const X86CseEntry& key) noexcept {
+  X86CseEntry* e = ctx.buckets[key.hVal % X86CseContext::kBucketCount];
+  while (e && !X86Cse_entryEquals(*e, key))
+    e = e->next;
+  return e;
+}
+
+//! \internal
+static ASMJIT_INLINE X86CseEntry* X86Cse_insert(X86CseContext& ctx, const X86CseEntry& key) noexcept {
+  X86CseEntry* e = ctx.zone->allocT<X86CseEntry>();
+  if (ASMJIT_UNLIKELY(!e)) return nullptr;
+
+  ::memcpy(e, &key, sizeof(X86CseEntry));
+
+  uint32_t bucket = key.hVal % X86CseContext::kBucketCount;
+  e->next = ctx.buckets[bucket];
+  ctx.buckets[bucket] = e;
+  ctx.entryCount++;
+  return e;
+}
+
+// ============================================================================
+// [asmjit::X86CsePass - Construction / Destruction]
+// ============================================================================
+
+X86CsePass::X86CsePass() noexcept
+  : CBPass("Cse"),
+    _replacedCount(0),
+    _removedCount(0) {}
+X86CsePass::~X86CsePass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86CsePass - Interface]
+// ============================================================================
+
+Error X86CsePass::process(Zone* zone) noexcept {
+  X86Compiler* cc = static_cast<X86Compiler*>(_cb);
+  _replacedCount = 0;
+  _removedCount = 0;
+
+  X86CseContext ctx;
+  ctx.cc = cc;
+  ctx.zone = zone;
+  ctx.block = 0;
+  ctx.valueCount = 0;
+  ctx.memEpoch = 0;
+  ctx.entryCount = 0;
+  ctx.vregCount = static_cast<uint32_t>(cc->getVirtRegArray().getLength());
+  ::memset(ctx.buckets, 0, sizeof(ctx.buckets));
+
+  ctx.vregStamp = zone->allocZeroedT<uint32_t>((ctx.vregCount * 2 + 1) * sizeof(uint32_t));
+  if (ASMJIT_UNLIKELY(!ctx.vregStamp))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+  ctx.vregValue = ctx.vregStamp + ctx.vregCount;
+
+  X86Cse_newBlock(ctx);
+
+  CBNode* node = cc->getFirstNode();
+  while (node) {
+    CBNode* next = node->getNext();
+
+    switch (node->getType()) {
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+        break;
+
+      case CBNode::kNodeHint:
+        X86Cse_newValue(ctx, static_cast<CCHint*>(node)->getVReg()->getId());
+        break;
+
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+
+        if (inst->isJmpOrJcc()) {
+          X86Cse_newBlock(ctx);
+          break;
+        }
+
+        if (X86Cse_writesMem(inst))
+          ctx.memEpoch++;
+
+        if (X86Cse_isCopy(ctx, inst)) {
+          const Operand* opArray = inst->getOpArray();
+          X86Cse_setValue(ctx, opArray[0].getId(), X86Cse_getValue(ctx, opArray[1].getId()));
+          break;
+        }
+
+        if (!X86Cse_isPure(ctx, inst)) {
+          X86Cse_killWrites(ctx, inst);
+          break;
+        }
+
+        const X86Inst& instInfo = X86Inst::getInst(inst->getInstId());
+        const Operand* opArray = inst->getOpArray();
+        uint32_t opCount = inst->getOpCount();
+        uint32_t dstId = opArray[0].getId();
+
+        // 'REG ^ REG' and similar instructions don't depend on the register.
+        bool singleReg = false;
+        if (opCount >= 2 && instInfo.getCommonData().getSingleRegCase() == X86Inst::kSingleRegWO) {
+          uint32_t i = 1;
+          while (i < opCount && opArray[i].isReg() && opArray[i].getId() == dstId)
+            i++;
+          singleReg = i == opCount;
+        }
+
+        // Moves of immediates and zero idioms are not replaced by copies.
+        bool isCheap = singleReg || (inst->getInstId() == X86Inst::kIdMov && opArray[1].isImm());
+
+        X86CseEntry key;
+        X86Cse_initEntry(ctx, key, inst, singleReg);
+
+        X86CseEntry* e = X86Cse_find(ctx, key);
+        if (!e) {
+          X86Cse_newValue(ctx, dstId);
+          key.value = X86Cse_getValue(ctx, dstId);
+          key.holderId = dstId;
+
+          if (ASMJIT_UNLIKELY(!X86Cse_insert(ctx, key)))
+            return DebugUtils::errored(kErrorNoHeapMemory);
+          break;
+        }
+
+        // The register that received the value may have been overwritten, the
+        // value is the same, but this instruction has to compute it again.
+        if (X86Cse_getValue(ctx, e->holderId) != e->value) {
+          X86Cse_setValue(ctx, dstId, e->value);
+          e->holderId = dstId;
+          break;
+        }
+
+        uint32_t flags = instInfo.getOperationData().getSpecialRegsW();
+        bool canRewrite = !isCheap && (!flags || X86Cse_areFlagsDead(inst, flags));
+
+        if (canRewrite && e->holderId == dstId) {
+          cc->removeNode(inst);
+          _removedCount++;
+        }
+        else if (canRewrite) {
+          const X86Reg& dst = static_cast<const X86Reg&>(opArray[0]);
+          X86Reg src(dst, e->holderId);
+
+          uint32_t copyId = X86Inst::kIdMov;
+          if (dst.isVec())
+            copyId = instInfo.getCommonData().isVexOrEvex() ? X86Inst::kIdVmovaps : X86Inst::kIdMovaps;
+
+          CBNode* prevCursor = cc->setCursor(inst->getPrev());
+          Error err = cc->emit(copyId, dst, src);
+          cc->setCursor(prevCursor);
+
+          ASMJIT_PROPAGATE(err);
+          cc->removeNode(inst);
+          _replacedCount++;
+        }
+
+        X86Cse_setValue(ctx, dstId, e->value);
+        break;
+      }
+
+      default:
+        // Labels, function calls, returns, embedded data, and unknown nodes.
+        X86Cse_newBlock(ctx);
+        break;
+    }
+
+    node = next;
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86CsePass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_cse) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+  ci.setStackAlignment(16);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  X86CsePass* pass = cc.newPassT<X86CsePass>();
+
+  EXPECT(pass != nullptr);
+  EXPECT(cc.insertPass(0, pass) == kErrorOk);
+
+  cc.addFunc(FuncSignature3<void, int*, int*, int>(CallConv::kIdX86SysV64));
+
+  X86Gp dst = cc.newIntPtr("dst");
+  X86Gp src = cc.newIntPtr("src");
+  X86Gp idx = cc.newInt32("idx");
+  X86Gp a = cc.newInt32("a");
+  X86Gp b = cc.newInt32("b");
+  X86Gp c = cc.newInt32("c");
+  X86Gp d = cc.newInt32("d");
+  X86Gp e = cc.newInt32("e");
+  X86Gp f = cc.newInt32("f");
+  X86Gp g = cc.newInt32("g");
+  X86Gp t = cc.newInt32("t");
+  X86Gp x = cc.newInt32("x");
+  X86Gp y = cc.newInt32("y");
+  Label L_Next = cc.newLabel();
+
+  cc.setArg(0, dst);
+  cc.setArg(1, src);
+  cc.setArg(2, idx);
+
+  cc.mov(a, idx);
+  cc.shl(a, 3);                          // Flags dead (overwritten by 'and').
+  cc.and_(a, 0xFF);                      // Flags dead (overwritten by 'shl').
+  cc.mov(b, idx);
+  cc.shl(b, 3);                          // Not replaced, 'a' was overwritten.
+  cc.and_(b, 0xFF);                      // Replaced by 'mov b, a'.
+  cc.lea(c, x86::ptr(src, idx, 2));
+  cc.lea(d, x86::ptr(src, idx, 2));      // Replaced by 'mov d, c'.
+  cc.mov(x, x86::dword_ptr(src));
+  cc.mov(y, x86::dword_ptr(src));        // Replaced by 'mov y, x'.
+  cc.mov(x86::dword_ptr(dst), a);
+  cc.mov(e, x86::dword_ptr(src));        // Not replaced, memory was written.
+  cc.mov(t, 7);
+  cc.xchg(t, x86::dword_ptr(src));
+  cc.mov(g, x86::dword_ptr(src));        // Not replaced, 'xchg' wrote memory.
+  cc.add(e, b);
+  cc.add(e, c);
+  cc.add(e, d);
+  cc.add(e, x);
+  cc.add(e, y);
+  cc.add(e, t);
+  cc.add(e, g);
+  cc.mov(f, idx);
+  cc.shl(f, 3);
+  cc.and_(f, 0xFF);                      // Not replaced, flags are read by 'jz'.
+  cc.jz(L_Next);
+  cc.mov(x86::dword_ptr(dst, 4), e);
+  cc.bind(L_Next);
+  cc.mov(a, idx);
+  cc.shl(a, 3);                          // Not replaced, new block.
+  cc.mov(x86::dword_ptr(dst, 8), a);
+  cc.mov(x86::dword_ptr(dst, 12), f);
+  cc.endFunc();
+
+  INFO("Checking X86CsePass replaces only redundant instructions");
+  EXPECT(cc.finalize() == kErrorOk);
+  EXPECT(pass->getReplacedCount() == 3,
+    "X86CsePass replaced %u instructions, expected 3", pass->getReplacedCount());
+  EXPECT(pass->getRemovedCount() == 0,
+    "X86CsePass removed %u instructions, expected 0", pass->getRemovedCount());
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
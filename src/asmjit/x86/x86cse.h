@@ -0,0 +1,104 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86CSE_H
+#define _ASMJIT_X86_X86CSE_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codecompiler.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::X86CsePass]
+// ============================================================================
+
+//! Common subexpression elimination, \ref CBPass that replaces instructions
+//! computing a value already held by another virtual register by copies.
+//!
+//! The pass uses local value numbering - each basic block (code between
+//! labels, jumps, and function calls) is processed separately. A value number
+//! is assigned to each virtual register when it's written and register copies
+//! share the value number of their source, so `mov t, a` + `shl t, 3` is
+//! recognized as the same expression when it's repeated with another register.
+//!
+//! An instruction is considered only if the instruction database describes it
+//! as pure - it writes only its first operand, which is a virtual register
+//! written as a whole, has no implicit operands, doesn't read flags, and has
+//! no side effects. In addition:
+//!
+//!   - an instruction that writes flags is replaced only if the flags are
+//!     overwritten before they are read by code that follows it,
+//!   - a load is matched only if no memory was written since the first one,
+//!   - moves of immediates and zero idioms are kept as is (they are as cheap
+//!     as copies), but their results are still numbered.
+//!
+//! Copies are later removed by register allocation if the registers can be
+//! coalesced. The pass is not added by default, it has to run before register
+//! allocation:
+//!
+//! ~~~
+//! X86Compiler cc(&code);
+//! cc.insertPass(0, cc.newPassT<X86CsePass>());
+//! ~~~
+class ASMJIT_VIRTAPI X86CsePass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86CsePass)
+  typedef CBPass Base;
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API X86CsePass() noexcept;
+  ASMJIT_API virtual ~X86CsePass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get how many instructions were replaced by copies by the last `process()`.
+  ASMJIT_INLINE uint32_t getReplacedCount() const noexcept { return _replacedCount; }
+  //! Get how many instructions were removed by the last `process()`.
+  //!
+  //! An instruction is removed if it computes a value its destination already
+  //! holds.
+  ASMJIT_INLINE uint32_t getRemovedCount() const noexcept { return _removedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _replacedCount;               //!< Number of instructions replaced by the last `process()`.
+  uint32_t _removedCount;                //!< Number of instructions removed by the last `process()`.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86CSE_H
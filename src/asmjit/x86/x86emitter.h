@@ -329,6 +329,8 @@ struct X86EmitterExplicitT {
   ASMJIT_INLINE Error dxmm(const Data128& x) { return static_cast<This*>(this)->embed(&x, sizeof(Data128)); }
   //! Add YMM data to the instruction stream.
   ASMJIT_INLINE Error dymm(const Data256& x) { return static_cast<This*>(this)->embed(&x, sizeof(Data256)); }
+  //! Add ZMM data to the instruction stream.
+  ASMJIT_INLINE Error dzmm(const Data512& x) { return static_cast<This*>(this)->embed(&x, sizeof(Data512)); }
 
   //! Add data in a given structure instance to the instruction stream.
   template<typename T>
@@ -401,6 +403,11 @@ public:
   //! Force 4-byte EVEX prefix (AVX512+).
   ASMJIT_INLINE This& evex() noexcept { return _addOptions(X86Inst::kOptionEvex); }
 
+  //! Use masking {k} by the given `kreg` (AVX512+).
+  ASMJIT_INLINE This& k(const X86KReg& kreg) noexcept {
+    static_cast<This*>(this)->_extraReg.init(kreg);
+    return *static_cast<This*>(this);
+  }
   //! Use zeroing instead of merging (AVX512+).
   ASMJIT_INLINE This& z() noexcept { return _addOptions(X86Inst::kOptionZMask); }
   //! Broadcast one element to all other elements (AVX512+).
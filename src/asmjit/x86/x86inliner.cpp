@@ -0,0 +1,602 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../x86/x86compiler.h"
+#include "../x86/x86inliner.h"
+#include "../x86/x86internal_p.h"
+#include "../x86/x86operand.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86InlinerContext]
+// ============================================================================
+
+//! \internal
+//!
+//! State of the inliner shared by all call sites.
+//!
+//! Virtual registers and labels are remapped through arrays indexed by their
+//! unpacked ids. Each entry is valid only if its stamp matches the current
+//! `site`, so the arrays don't have to be cleared between call sites.
+struct X86InlinerContext {
+  X86Compiler* cc;                       //!< Compiler.
+  uint32_t site;                         //!< Current call site (stamp).
+
+  uint32_t vregCount;                    //!< Number of virtual registers that can be remapped.
+  uint32_t* vregStamp;                   //!< Virtual register stamps.
+  uint32_t* vregMap;                     //!< Virtual register ids of clones.
+
+  uint32_t labelCount;                   //!< Number of labels that can be remapped.
+  uint32_t* labelStamp;                  //!< Label stamps, set for labels bound in the body.
+  uint32_t* labelMap;                    //!< Label ids of clones.
+
+  CBLabel* exitNode;                     //!< Exit node of the inlined function.
+  uint32_t contId;                       //!< Continuation label id (replaces the exit node).
+  bool contUsed;                         //!< Continuation label is referenced.
+};
+
+// ============================================================================
+// [asmjit::X86Inliner - Utils]
+// ============================================================================
+
+//! \internal
+//!
+//! Get whether the virtual register `id` can be cloned.
+static ASMJIT_INLINE bool X86Inliner_isClonableVReg(X86InlinerContext& ctx, uint32_t id) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  return index < ctx.vregCount && !ctx.cc->getVirtRegById(id)->isStack();
+}
+
+//! \internal
+//!
+//! Get whether virtual registers used by `op` can be cloned.
+static bool X86Inliner_isClonableOp(X86InlinerContext& ctx, const Operand_& op) noexcept {
+  if (op.isReg())
+    return !Operand::isPackedId(op.getId()) || X86Inliner_isClonableVReg(ctx, op.getId());
+
+  if (op.isMem()) {
+    const X86Mem& m = static_cast<const X86Mem&>(op);
+    if (m.hasBaseReg() && Operand::isPackedId(m.getBaseId()) && !X86Inliner_isClonableVReg(ctx, m.getBaseId()))
+      return false;
+    if (m.hasIndexReg() && Operand::isPackedId(m.getIndexId()) && !X86Inliner_isClonableVReg(ctx, m.getIndexId()))
+      return false;
+  }
+
+  return true;
+}
+
+//! \internal
+//!
+//! Get whether a value can be copied from `src` to the register `dst`.
+static bool X86Inliner_isCopyable(const Operand_& dst, const Operand_& src) noexcept {
+  if (src.isNone())
+    return true;
+
+  const X86Reg& dReg = static_cast<const X86Reg&>(dst);
+  if (src.isImm())
+    return dReg.isGp();
+
+  if (!src.isReg())
+    return false;
+
+  const X86Reg& sReg = static_cast<const X86Reg&>(src);
+  return dReg.isGp() ? sReg.isGp() : dReg.getType() == sReg.getType();
+}
+
+//! \internal
+//!
+//! Get the id of the clone of the virtual register `id`, creates the clone if
+//! it doesn't exist yet at the current call site.
+static uint32_t X86Inliner_mapVReg(X86InlinerContext& ctx, uint32_t id) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  ASMJIT_ASSERT(index < ctx.vregCount);
+
+  if (ctx.vregStamp[index] != ctx.site) {
+    VirtReg* vreg = ctx.cc->getVirtRegById(id);
+    VirtReg* clone = ctx.cc->newVirtReg(vreg->getTypeId(), vreg->getSignature(), vreg->getName());
+    if (ASMJIT_UNLIKELY(!clone)) return 0;
+
+    ctx.vregStamp[index] = ctx.site;
+    ctx.vregMap[index] = clone->getId();
+  }
+
+  return ctx.vregMap[index];
+}
+
+//! \internal
+//!
+//! Get the id of the label that replaces the label `id` at the current call
+//! site. Labels not bound in the body (except its exit) are kept as is.
+static uint32_t X86Inliner_mapLabel(X86InlinerContext& ctx, uint32_t id) noexcept {
+  if (id == ctx.exitNode->getId()) {
+    ctx.contUsed = true;
+    return ctx.contId;
+  }
+
+  uint32_t index = Operand::unpackId(id);
+  if (index < ctx.labelCount && ctx.labelStamp[index] == ctx.site)
+    return ctx.labelMap[index];
+
+  return id;
+}
+
+//! \internal
+//!
+//! Remap virtual registers and labels used by `op`.
+static Error X86Inliner_remapOp(X86InlinerContext& ctx, Operand_& op) noexcept {
+  if (op.isReg()) {
+    if (Operand::isPackedId(op.getId())) {
+      uint32_t id = X86Inliner_mapVReg(ctx, op.getId());
+      if (ASMJIT_UNLIKELY(!id)) return DebugUtils::errored(kErrorNoHeapMemory);
+      op._reg.id = id;
+    }
+  }
+  else if (op.isMem()) {
+    X86Mem& m = static_cast<X86Mem&>(op);
+    if (m.hasBaseLabel()) {
+      m._mem.base = X86Inliner_mapLabel(ctx, m.getBaseId());
+    }
+    else if (m.hasBaseReg() && Operand::isPackedId(m.getBaseId())) {
+      uint32_t id = X86Inliner_mapVReg(ctx, m.getBaseId());
+      if (ASMJIT_UNLIKELY(!id)) return DebugUtils::errored(kErrorNoHeapMemory);
+      m._mem.base = id;
+    }
+
+    if (m.hasIndexReg() && Operand::isPackedId(m.getIndexId())) {
+      uint32_t id = X86Inliner_mapVReg(ctx, m.getIndexId());
+      if (ASMJIT_UNLIKELY(!id)) return DebugUtils::errored(kErrorNoHeapMemory);
+      m._mem.index = id;
+    }
+  }
+  else if (op.isLabel()) {
+    op._label.id = X86Inliner_mapLabel(ctx, op.getId());
+  }
+
+  return kErrorOk;
+}
+
+//! \internal
+//!
+//! Emit a copy of `src` (register or immediate) to the register `dst`.
+static Error X86Inliner_emitCopy(X86Compiler* cc, const Operand_& dst, const Operand_& src, uint32_t typeId) noexcept {
+  const X86Reg& dReg = static_cast<const X86Reg&>(dst);
+
+  if (src.isImm())
+    return cc->emit(X86Inst::kIdMov, dReg, src);
+
+  X86Reg sReg(static_cast<const X86Reg&>(src));
+  if (sReg.getId() == dReg.getId())
+    return kErrorOk;
+
+  // GP registers of different sizes are copied as the size of destination.
+  if (dReg.isGp())
+    sReg.setSignature(dReg.getSignature());
+
+  return X86Internal::emitRegMove(cc->asEmitter(), dReg, sReg, typeId, false, nullptr);
+}
+
+// ============================================================================
+// [asmjit::X86Inliner - Candidate]
+// ============================================================================
+
+//! \internal
+//!
+//! Get the function called by `call` if it can be inlined into `caller`.
+//!
+//! Marks labels bound in the body of the function with the current stamp.
+static CCFunc* X86Inliner_getCandidate(X86InlinerContext& ctx, CCFuncCall* call, CCFunc* caller, uint32_t maxSize) noexcept {
+  X86Compiler* cc = ctx.cc;
+  const Operand& target = call->getTarget();
+
+  if (!target.isLabel())
+    return nullptr;
+
+  CBLabel* targetNode;
+  if (cc->getCBLabel(&targetNode, target.getId()) != kErrorOk || targetNode->getType() != CBNode::kNodeFunc)
+    return nullptr;
+
+  CCFunc* func = static_cast<CCFunc*>(targetNode);
+  CBLabel* exitNode = func->getExitNode();
+
+  if (func == caller || !exitNode)
+    return nullptr;
+
+  // The function has to follow the call's signature.
+  const FuncDetail& fd = func->getDetail();
+  const FuncDetail& cd = call->getDetail();
+  uint32_t i;
+
+  if (fd.getArgCount() != cd.getArgCount() || fd.getRetCount() != cd.getRetCount())
+    return nullptr;
+
+  for (i = 0; i < fd.getArgCount(); i++) {
+    VirtReg* arg = func->getArg(i);
+    if (!arg) continue;
+
+    if (!X86Inliner_isClonableVReg(ctx, arg->getId()) ||
+        !X86Inliner_isCopyable(X86Reg::fromSignature(arg->getSignature(), arg->getId()), call->getArg(i)))
+      return nullptr;
+  }
+
+  for (i = 0; i < 2; i++) {
+    const Operand& ret = call->getRet(i);
+    if (!ret.isNone() && !ret.isVirtReg())
+      return nullptr;
+  }
+
+  // Check the body and mark its labels.
+  uint32_t size = 0;
+  CBNode* node = func->getNext();
+
+  while (node != exitNode) {
+    if (!node) return nullptr;
+
+    switch (node->getType()) {
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        uint32_t instId = inst->getInstId();
+
+        if (instId == X86Inst::kIdCall || instId == X86Inst::kIdRet)
+          return nullptr;
+
+        if (inst->isJmpOrJcc() && !static_cast<CBJump*>(inst)->getTarget())
+          return nullptr;
+
+        const Operand* opArray = inst->getOpArray();
+        uint32_t opCount = inst->getOpCount();
+
+        for (i = 0; i < opCount; i++)
+          if (!X86Inliner_isClonableOp(ctx, opArray[i]))
+            return nullptr;
+
+        const RegOnly& extraReg = inst->getExtraReg();
+        if (extraReg.isValid() && extraReg.isVirtReg() && !X86Inliner_isClonableVReg(ctx, extraReg.getId()))
+          return nullptr;
+
+        size++;
+        break;
+      }
+
+      case CBNode::kNodeFuncExit: {
+        CCFuncRet* ret = static_cast<CCFuncRet*>(node);
+        for (i = 0; i < 2; i++) {
+          const Operand_& src = ret->_ret[i];
+          const Operand& dst = call->getRet(i);
+
+          if (dst.isNone() || src.isNone()) continue;
+          if (!X86Inliner_isClonableOp(ctx, src) || !X86Inliner_isCopyable(dst, src))
+            return nullptr;
+        }
+
+        size++;
+        break;
+      }
+
+      case CBNode::kNodeLabel: {
+        uint32_t index = Operand::unpackId(static_cast<CBLabel*>(node)->getId());
+        if (index >= ctx.labelCount)
+          return nullptr;
+
+        ctx.labelStamp[index] = ctx.site;
+        break;
+      }
+
+      case CBNode::kNodeComment:
+      case CBNode::kNodeHint:
+        break;
+
+      default:
+        return nullptr;
+    }
+
+    if (size > maxSize)
+      return nullptr;
+
+    node = node->getNext();
+  }
+
+  // Jumps can only target labels of the body or its exit.
+  for (node = func->getNext(); node != exitNode; node = node->getNext()) {
+    if (node->getType() != CBNode::kNodeInst || !node->isJmpOrJcc())
+      continue;
+
+    CBLabel* jTarget = static_cast<CBJump*>(node)->getTarget();
+    uint32_t index = Operand::unpackId(jTarget->getId());
+
+    if (jTarget != exitNode && (index >= ctx.labelCount || ctx.labelStamp[index] != ctx.site))
+      return nullptr;
+  }
+
+  return func;
+}
+
+// ============================================================================
+// [asmjit::X86Inliner - Inline]
+// ============================================================================
+
+//! \internal
+//!
+//! Replace `call` by a copy of the body of `func`.
+static Error X86Inliner_inline(X86InlinerContext& ctx, CCFuncCall* call, CCFunc* func) noexcept {
+  X86Compiler* cc = ctx.cc;
+  CBLabel* exitNode = func->getExitNode();
+
+  CBNode* node;
+  uint32_t i;
+
+  // Create labels that replace labels of the body.
+  for (node = func->getNext(); node != exitNode; node = node->getNext()) {
+    if (node->getType() != CBNode::kNodeLabel) continue;
+
+    Label label = cc->newLabel();
+    if (ASMJIT_UNLIKELY(!label.isValid()))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+    ctx.labelMap[Operand::unpackId(static_cast<CBLabel*>(node)->getId())] = label.getId();
+  }
+
+  Label cont = cc->newLabel();
+  if (ASMJIT_UNLIKELY(!cont.isValid()))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  ctx.exitNode = exitNode;
+  ctx.contId = cont.getId();
+  ctx.contUsed = false;
+
+  CBNode* prevCursor = cc->setCursor(call->getPrev());
+
+  // Copy arguments to clones of the function's arguments.
+  for (i = 0; i < func->getDetail().getArgCount(); i++) {
+    VirtReg* arg = func->getArg(i);
+    const Operand& src = call->getArg(i);
+    if (!arg || src.isNone()) continue;
+
+    uint32_t id = X86Inliner_mapVReg(ctx, arg->getId());
+    if (ASMJIT_UNLIKELY(!id))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    X86Reg dst = X86Reg::fromSignature(arg->getSignature(), id);
+    ASMJIT_PROPAGATE(X86Inliner_emitCopy(cc, dst, src, arg->getTypeId()));
+  }
+
+  // Copy the body.
+  for (node = func->getNext(); node != exitNode; node = node->getNext()) {
+    switch (node->getType()) {
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        uint32_t opCount = inst->getOpCount();
+
+        Operand opArray[6];
+        for (i = 0; i < opCount; i++) {
+          opArray[i].copyFrom(inst->getOpArray()[i]);
+          ASMJIT_PROPAGATE(X86Inliner_remapOp(ctx, opArray[i]));
+        }
+
+        RegOnly extraReg(inst->getExtraReg());
+        if (extraReg.isValid() && extraReg.isVirtReg()) {
+          uint32_t id = X86Inliner_mapVReg(ctx, extraReg.getId());
+          if (ASMJIT_UNLIKELY(!id))
+            return DebugUtils::errored(kErrorNoHeapMemory);
+          extraReg.init(extraReg.getSignature(), id);
+        }
+
+        cc->setOptions(inst->getOptions());
+        if (extraReg.isValid())
+          cc->setExtraReg(extraReg);
+        cc->setInlineComment(inst->getInlineComment());
+        ASMJIT_PROPAGATE(cc->_emitOpArray(inst->getInstId(), opArray, opCount));
+        break;
+      }
+
+      case CBNode::kNodeFuncExit: {
+        CCFuncRet* ret = static_cast<CCFuncRet*>(node);
+
+        for (i = 0; i < 2; i++) {
+          const Operand& dst = call->getRet(i);
+          Operand src(ret->_ret[i]);
+          if (dst.isNone() || src.isNone()) continue;
+
+          ASMJIT_PROPAGATE(X86Inliner_remapOp(ctx, src));
+          ASMJIT_PROPAGATE(X86Inliner_emitCopy(cc, dst, src, cc->getVirtRegById(dst.getId())->getTypeId()));
+        }
+
+        // The last return falls through to the continuation.
+        if (node->getNext() != exitNode) {
+          ctx.contUsed = true;
+          ASMJIT_PROPAGATE(cc->jmp(cont));
+        }
+        break;
+      }
+
+      case CBNode::kNodeLabel: {
+        Label label(X86Inliner_mapLabel(ctx, static_cast<CBLabel*>(node)->getId()));
+        ASMJIT_PROPAGATE(cc->bind(label));
+        break;
+      }
+
+      case CBNode::kNodeComment:
+        ASMJIT_PROPAGATE(cc->comment(node->getInlineComment()));
+        break;
+
+      default:
+        // Hints are specific to the function's register allocation.
+        break;
+    }
+  }
+
+  if (ctx.contUsed)
+    ASMJIT_PROPAGATE(cc->bind(cont));
+
+  cc->setCursor(prevCursor);
+  cc->removeNode(call);
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86InlinerPass - Construction / Destruction]
+// ============================================================================
+
+X86InlinerPass::X86InlinerPass(uint32_t maxSize) noexcept
+  : CBPass("Inliner"),
+    _maxSize(maxSize),
+    _inlinedCount(0) {}
+X86InlinerPass::~X86InlinerPass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86InlinerPass - Interface]
+// ============================================================================
+
+Error X86InlinerPass::process(Zone* zone) noexcept {
+  X86Compiler* cc = static_cast<X86Compiler*>(_cb);
+  _inlinedCount = 0;
+
+  // Only virtual registers and labels that exist before the pass runs can be
+  // remapped - functions that use newer ones (created by inlining into them)
+  // are not inlined.
+  X86InlinerContext ctx;
+  ctx.cc = cc;
+  ctx.site = 0;
+  ctx.vregCount = static_cast<uint32_t>(cc->getVirtRegArray().getLength());
+  ctx.labelCount = static_cast<uint32_t>(cc->getCode()->getLabelsCount());
+  ctx.exitNode = nullptr;
+  ctx.contId = 0;
+  ctx.contUsed = false;
+
+  ctx.vregStamp = zone->allocZeroedT<uint32_t>((ctx.vregCount * 2 + 1) * sizeof(uint32_t));
+  ctx.labelStamp = zone->allocZeroedT<uint32_t>((ctx.labelCount * 2 + 1) * sizeof(uint32_t));
+
+  if (ASMJIT_UNLIKELY(!ctx.vregStamp || !ctx.labelStamp))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  ctx.vregMap = ctx.vregStamp + ctx.vregCount;
+  ctx.labelMap = ctx.labelStamp + ctx.labelCount;
+
+  CCFunc* caller = nullptr;
+  CBNode* node = cc->getFirstNode();
+
+  while (node) {
+    CBNode* next = node->getNext();
+
+    if (node->getType() == CBNode::kNodeFunc) {
+      caller = static_cast<CCFunc*>(node);
+    }
+    else if (node->getType() == CBNode::kNodeFuncCall) {
+      CCFuncCall* call = static_cast<CCFuncCall*>(node);
+
+      ctx.site++;
+      CCFunc* func = X86Inliner_getCandidate(ctx, call, caller, _maxSize);
+
+      if (func) {
+        ASMJIT_PROPAGATE(X86Inliner_inline(ctx, call, func));
+        _inlinedCount++;
+      }
+    }
+
+    node = next;
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86InlinerPass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_inliner) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+  ci.setStackAlignment(16);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  X86InlinerPass* pass = cc.newPassT<X86InlinerPass>(5);
+
+  EXPECT(pass != nullptr);
+  EXPECT(cc.insertPass(0, pass) == kErrorOk);
+
+  CCFunc* small = cc.newFunc(FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+  CCFunc* large = cc.newFunc(FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+
+  // Caller - calls the small function twice and the large function once.
+  cc.addFunc(FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+
+  X86Gp a = cc.newInt32("a");
+  X86Gp b = cc.newInt32("b");
+  cc.setArg(0, a);
+
+  CCFuncCall* call;
+  call = cc.call(small->getLabel(), FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+  call->setArg(0, a);
+  call->setRet(0, b);
+
+  call = cc.call(small->getLabel(), FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+  call->setArg(0, b);
+  call->setRet(0, b);
+
+  call = cc.call(large->getLabel(), FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+  call->setArg(0, b);
+  call->setRet(0, b);
+
+  cc.ret(b);
+  cc.endFunc();
+
+  // Small function - 'x < 0 ? 0 : x', 5 instructions including returns.
+  cc.addFunc(small);
+
+  X86Gp x = cc.newInt32("x");
+  X86Gp z = cc.newInt32("z");
+  Label L_Neg = cc.newLabel();
+
+  cc.setArg(0, x);
+  cc.test(x, x);
+  cc.js(L_Neg);
+  cc.ret(x);
+  cc.bind(L_Neg);
+  cc.xor_(z, z);
+  cc.ret(z);
+  cc.endFunc();
+
+  // Large function - 6 instructions including return.
+  cc.addFunc(large);
+
+  X86Gp y = cc.newInt32("y");
+  cc.setArg(0, y);
+  cc.add(y, 1);
+  cc.add(y, 2);
+  cc.add(y, 3);
+  cc.add(y, 4);
+  cc.add(y, 5);
+  cc.ret(y);
+  cc.endFunc();
+
+  INFO("Checking X86InlinerPass inlines only functions within the size threshold");
+  EXPECT(cc.finalize() == kErrorOk);
+  EXPECT(pass->getInlinedCount() == 2,
+    "X86InlinerPass inlined %u calls, expected 2", pass->getInlinedCount());
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
@@ -0,0 +1,104 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86INLINER_H
+#define _ASMJIT_X86_X86INLINER_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codecompiler.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::X86InlinerPass]
+// ============================================================================
+
+//! Inliner, \ref CBPass that replaces calls of small functions created by the
+//! same `X86Compiler` by copies of their bodies.
+//!
+//! A call is inlined if its target is a label of a function (`CCFunc`) other
+//! than the calling one, and the body of the function:
+//!
+//!   - has at most `maxSize` instructions (returns included),
+//!   - contains only instructions, jumps within the body, labels, comments,
+//!     hints and returns (no calls, no embedded data and no stack variables).
+//!
+//! Virtual registers and labels of the body are cloned for each call site,
+//! arguments and return values are copied from / to the registers used by the
+//! call and returns become jumps to the end of the inlined code. The function
+//! itself is kept, so it can still be called from outside.
+//!
+//! The pass is not added by default, it has to run before register allocation:
+//!
+//! ~~~
+//! X86Compiler cc(&code);
+//! cc.insertPass(0, cc.newPassT<X86InlinerPass>(16));
+//! ~~~
+class ASMJIT_VIRTAPI X86InlinerPass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86InlinerPass)
+  typedef CBPass Base;
+
+  enum {
+    //! Default maximum number of instructions of an inlined function.
+    kDefaultMaxSize = 16
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `X86InlinerPass` that inlines functions having at most
+  //! `maxSize` instructions.
+  ASMJIT_API X86InlinerPass(uint32_t maxSize = kDefaultMaxSize) noexcept;
+  ASMJIT_API virtual ~X86InlinerPass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the maximum number of instructions of an inlined function.
+  ASMJIT_INLINE uint32_t getMaxSize() const noexcept { return _maxSize; }
+  //! Set the maximum number of instructions of an inlined function.
+  ASMJIT_INLINE void setMaxSize(uint32_t maxSize) noexcept { _maxSize = maxSize; }
+
+  //! Get how many calls were inlined by the last `process()`.
+  ASMJIT_INLINE uint32_t getInlinedCount() const noexcept { return _inlinedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _maxSize;                     //!< Maximum number of instructions of an inlined function.
+  uint32_t _inlinedCount;                //!< Number of calls inlined by the last `process()`.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86INLINER_H
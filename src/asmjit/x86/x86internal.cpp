@@ -37,6 +37,11 @@ static ASMJIT_INLINE uint32_t x86VecTypeIdToRegType(uint32_t typeId) noexcept {
                                          X86Reg::kRegZmm ;
 }
 
+// Registers 16-31 can be only moved by EVEX instructions ('vmovdqa' is VEX only).
+static ASMJIT_INLINE bool x86IsVecHiMove(const Operand& dst, const Operand& src) noexcept {
+  return (dst.isReg() && dst.getId() >= 16) || (src.isReg() && src.getId() >= 16);
+}
+
 // ============================================================================
 // [asmjit::X86FuncArgsContext]
 // ============================================================================
@@ -797,7 +802,7 @@ ASMJIT_FAVOR_SIZE Error X86Internal::emitRegMove(X86Emitter* emitter,
         instId = avxEnabled ? X86Inst::kIdVmovaps : X86Inst::kIdMovaps;
       else if (elementTypeId == TypeId::kF64)
         instId = avxEnabled ? X86Inst::kIdVmovapd : X86Inst::kIdMovapd;
-      else if (typeId <= TypeId::_kVec256End)
+      else if (typeId <= TypeId::_kVec256End && !x86IsVecHiMove(dst, src))
         instId = avxEnabled ? X86Inst::kIdVmovdqa : X86Inst::kIdMovdqa;
       else if (elementTypeId <= TypeId::kU32)
         instId = X86Inst::kIdVmovdqa32;
@@ -1093,6 +1098,18 @@ ASMJIT_FAVOR_SIZE Error X86Internal::emitProlog(X86Emitter* emitter, const FuncF
 }
 
 ASMJIT_FAVOR_SIZE Error X86Internal::emitEpilog(X86Emitter* emitter, const FuncFrameLayout& layout) {
+  ASMJIT_PROPAGATE(emitFrameTeardown(emitter, layout));
+
+  // Emit 'ret' or 'ret x'.
+  if (layout.hasCalleeStackCleanup())
+    ASMJIT_PROPAGATE(emitter->emit(X86Inst::kIdRet, static_cast<int>(layout.getCalleeStackCleanup())));
+  else
+    ASMJIT_PROPAGATE(emitter->emit(X86Inst::kIdRet));
+
+  return kErrorOk;
+}
+
+ASMJIT_FAVOR_SIZE Error X86Internal::emitFrameTeardown(X86Emitter* emitter, const FuncFrameLayout& layout) {
   uint32_t i;
   uint32_t regId;
 
@@ -1167,12 +1184,6 @@ ASMJIT_FAVOR_SIZE Error X86Internal::emitEpilog(X86Emitter* emitter, const FuncF
   // Emit 'pop zbp'.
   if (layout.hasPreservedFP()) ASMJIT_PROPAGATE(emitter->pop(zbp));
 
-  // Emit 'ret' or 'ret x'.
-  if (layout.hasCalleeStackCleanup())
-    ASMJIT_PROPAGATE(emitter->emit(X86Inst::kIdRet, static_cast<int>(layout.getCalleeStackCleanup())));
-  else
-    ASMJIT_PROPAGATE(emitter->emit(X86Inst::kIdRet));
-
   return kErrorOk;
 }
 
@@ -48,6 +48,10 @@ struct X86Internal {
   //! Emit function epilog.
   static Error emitEpilog(X86Emitter* emitter, const FuncFrameLayout& layout);
 
+  //! Emit function epilog without the final 'ret' - restores saved registers
+  //! and the stack pointer (used by epilog and tail calls).
+  static Error emitFrameTeardown(X86Emitter* emitter, const FuncFrameLayout& layout);
+
   //! Emit a pure move operation between two registers or the same type or
   //! between a register and its home slot. This function does not handle
   //! register conversion.
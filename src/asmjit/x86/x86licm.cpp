@@ -0,0 +1,556 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../x86/x86compiler.h"
+#include "../x86/x86licm.h"
+#include "../x86/x86operand.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86LicmContext]
+// ============================================================================
+
+//! \internal
+//!
+//! State of the LICM pass shared by all loops.
+//!
+//! Per-loop information is kept in arrays indexed by unpacked ids of virtual
+//! registers and labels. Each entry is valid only if its stamp matches the
+//! current `loop`, so the arrays don't have to be cleared between loops.
+struct X86LicmContext {
+  X86Compiler* cc;                       //!< Compiler.
+  uint32_t func;                         //!< Current function (stamp).
+  uint32_t loop;                         //!< Current loop (stamp).
+
+  uint32_t vregCount;                    //!< Number of virtual registers.
+  uint32_t* vregStamp;                   //!< Virtual register stamps.
+  uint32_t* vregWrites;                  //!< Number of writes in the loop.
+  uint32_t* vregRead;                    //!< Read in the loop, before the current instruction (stamp).
+
+  uint32_t labelCount;                   //!< Number of labels.
+  uint32_t* labelBound;                  //!< Label bound in the current function (stamp).
+  uint32_t* labelInLoop;                 //!< Label bound in the current loop (stamp).
+
+  bool writesMem;                        //!< The loop writes memory or calls a function.
+};
+
+// ============================================================================
+// [asmjit::X86Licm - Utils]
+// ============================================================================
+
+//! \internal
+static ASMJIT_INLINE uint32_t X86Licm_getWrites(X86LicmContext& ctx, uint32_t id) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  return index < ctx.vregCount && ctx.vregStamp[index] == ctx.loop ? ctx.vregWrites[index] : 0;
+}
+
+//! \internal
+static ASMJIT_INLINE void X86Licm_addWrite(X86LicmContext& ctx, uint32_t id) noexcept {
+  if (!Operand::isPackedId(id)) return;
+
+  uint32_t index = Operand::unpackId(id);
+  if (index >= ctx.vregCount) return;
+
+  if (ctx.vregStamp[index] != ctx.loop) {
+    ctx.vregStamp[index] = ctx.loop;
+    ctx.vregWrites[index] = 0;
+  }
+  ctx.vregWrites[index]++;
+}
+
+//! \internal
+static ASMJIT_INLINE void X86Licm_addRead(X86LicmContext& ctx, uint32_t id) noexcept {
+  uint32_t index = Operand::unpackId(id);
+  if (Operand::isPackedId(id) && index < ctx.vregCount)
+    ctx.vregRead[index] = ctx.loop;
+}
+
+//! \internal
+//!
+//! Get whether the instruction `node` writes memory or has side effects that
+//! prevent moving loads across it.
+static bool X86Licm_writesMem(const CBInst* node) noexcept {
+  const X86Inst& inst = X86Inst::getInst(node->getInstId());
+  const X86Inst::CommonData& commonData = inst.getCommonData();
+
+  if (commonData.hasFixedMem() || inst.getOperationData().isVolatile())
+    return true;
+
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  // XCHG and XADD write both operands, the memory operand can be the second.
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagUseXX)) {
+    for (uint32_t i = 0; i < opCount; i++)
+      if (opArray[i].isMem())
+        return true;
+    return false;
+  }
+
+  return opCount != 0 && opArray[0].isMem() && !commonData.isUseR();
+}
+
+//! \internal
+//!
+//! Count writes of virtual registers done by the instruction `node`.
+//!
+//! The first operand is written if the instruction is not read-only. All
+//! register operands are considered written if the use information is not
+//! precise (implicit operands, VSIB masks, and instructions like XCHG).
+static void X86Licm_addWrites(X86LicmContext& ctx, const CBInst* node) noexcept {
+  const X86Inst::CommonData& commonData = X86Inst::getInst(node->getInstId()).getCommonData();
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagUseXX | X86Inst::kFlagFixedReg | X86Inst::kFlagVsib)) {
+    for (uint32_t i = 0; i < opCount; i++)
+      if (opArray[i].isReg())
+        X86Licm_addWrite(ctx, opArray[i].getId());
+  }
+  else if (opCount && opArray[0].isReg() && !commonData.isUseR()) {
+    X86Licm_addWrite(ctx, opArray[0].getId());
+  }
+}
+
+//! \internal
+//!
+//! Get whether the operand `op` of an instruction being hoisted reads only
+//! values that don't change in the loop. Memory operand is only an address if
+//! `isLoad` is false (LEA).
+static bool X86Licm_isInvariantOp(X86LicmContext& ctx, const Operand_& op, bool isLoad) noexcept {
+  if (op.isReg())
+    return Operand::isPackedId(op.getId()) && X86Licm_getWrites(ctx, op.getId()) == 0;
+
+  if (op.isMem()) {
+    const X86Mem& m = static_cast<const X86Mem&>(op);
+    if ((isLoad && ctx.writesMem) || m.isRegHome())
+      return false;
+
+    if (m.hasBaseReg() && (!Operand::isPackedId(m.getBaseId()) || X86Licm_getWrites(ctx, m.getBaseId()) != 0))
+      return false;
+
+    if (m.hasIndexReg() && (!Operand::isPackedId(m.getIndexId()) || X86Licm_getWrites(ctx, m.getIndexId()) != 0))
+      return false;
+  }
+
+  return true;
+}
+
+//! \internal
+//!
+//! Get whether the instruction `node` can be moved in front of the loop.
+static bool X86Licm_isHoistable(X86LicmContext& ctx, const CBInst* node) noexcept {
+  uint32_t instId = node->getInstId();
+  const X86Inst& inst = X86Inst::getInst(instId);
+  const X86Inst::CommonData& commonData = inst.getCommonData();
+  const X86Inst::OperationData& operationData = inst.getOperationData();
+
+  const Operand* opArray = node->getOpArray();
+  uint32_t opCount = node->getOpCount();
+
+  if (!opCount || !opArray[0].isReg() || !Operand::isPackedId(opArray[0].getId()))
+    return false;
+
+  uint32_t dstId = opArray[0].getId();
+  uint32_t dstIndex = Operand::unpackId(dstId);
+
+  // 'REG ^ REG' and similar instructions don't read the register.
+  bool singleReg = false;
+  if (opCount >= 2 && commonData.getSingleRegCase() == X86Inst::kSingleRegWO) {
+    uint32_t i = 1;
+    while (i < opCount && opArray[i].isReg() && opArray[i].getId() == dstId)
+      i++;
+    singleReg = i == opCount;
+  }
+
+  // The instruction must be pure - write only its first operand, have no
+  // implicit operands, side effects, prefixes, and no AVX-512 {k} selector.
+  if (!(commonData.isUseW() || (singleReg && commonData.isUseX())))
+    return false;
+
+  if (commonData.hasFlag(X86Inst::kFlagUseA | X86Inst::kFlagFixedRM | X86Inst::kFlagVsib))
+    return false;
+
+  if (commonData.isFpu() || commonData.isMmx() || node->hasExtraReg())
+    return false;
+
+  if (operationData.isVolatile() || operationData.isBarrier() || operationData.isPrefetch() || operationData.isPrivileged())
+    return false;
+
+  // Flags are neither read (dependency on code in the loop) nor written (the
+  // code in the loop may depend on them).
+  if (operationData.getSpecialRegsR() | operationData.getSpecialRegsW())
+    return false;
+
+  if (node->getOptions() & (X86Inst::kOptionLock | X86Inst::kOptionRep | X86Inst::kOptionRepnz))
+    return false;
+
+  // The destination is defined only by this instruction and not read before.
+  if (dstIndex >= ctx.vregCount || X86Licm_getWrites(ctx, dstId) != 1 || ctx.vregRead[dstIndex] == ctx.loop)
+    return false;
+
+  VirtReg* dst = ctx.cc->getVirtRegById(dstId);
+  if (dst->isFixed())
+    return false;
+
+  // Writes to 8-bit and 16-bit parts of GP registers merge with the rest.
+  const X86Reg& dstReg = static_cast<const X86Reg&>(opArray[0]);
+  if (dstReg.isGp() && dstReg.getSize() < 4 && dstReg.getSize() < dst->getSize())
+    return false;
+
+  if (singleReg)
+    return true;
+
+  for (uint32_t i = 1; i < opCount; i++)
+    if (!X86Licm_isInvariantOp(ctx, opArray[i], instId != X86Inst::kIdLea))
+      return false;
+
+  return true;
+}
+
+// ============================================================================
+// [asmjit::X86Licm - Loop]
+// ============================================================================
+
+//! \internal
+//!
+//! Analyze the loop formed by `header` and the backward jump `latch` and move
+//! its invariant instructions in front of `header`.
+static uint32_t X86Licm_processLoop(X86LicmContext& ctx, CBLabel* header, CBJump* latch) noexcept {
+  X86Compiler* cc = ctx.cc;
+  CBNode* stop = latch->getNext();
+  CBNode* node;
+
+  ctx.loop++;
+  ctx.writesMem = false;
+
+  // Collect labels bound in the loop.
+  for (node = header; node != stop; node = node->getNext()) {
+    if (node->getType() == CBNode::kNodeLabel) {
+      uint32_t index = Operand::unpackId(static_cast<CBLabel*>(node)->getId());
+      if (index < ctx.labelCount)
+        ctx.labelInLoop[index] = ctx.loop;
+    }
+  }
+
+  // Count jumps to these labels and writes done in the loop.
+  uint32_t numRefs = 0;
+  uint32_t loopRefs = 0;
+
+  for (node = header; node != stop; node = node->getNext()) {
+    switch (node->getType()) {
+      case CBNode::kNodeLabel:
+        numRefs += static_cast<CBLabel*>(node)->getNumRefs();
+        break;
+
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+
+        if (inst->isJmpOrJcc()) {
+          CBLabel* target = static_cast<CBJump*>(inst)->getTarget();
+          if (!target)
+            return 0;
+
+          uint32_t index = Operand::unpackId(target->getId());
+          if (index < ctx.labelCount && ctx.labelInLoop[index] == ctx.loop)
+            loopRefs++;
+        }
+        else {
+          // Jumps are volatile, but they don't write memory.
+          ctx.writesMem |= X86Licm_writesMem(inst);
+        }
+
+        X86Licm_addWrites(ctx, inst);
+        break;
+      }
+
+      case CBNode::kNodeFuncCall: {
+        CCFuncCall* call = static_cast<CCFuncCall*>(node);
+        for (uint32_t i = 0; i < 2; i++)
+          if (call->getRet(i).isReg())
+            X86Licm_addWrite(ctx, call->getRet(i).getId());
+        ctx.writesMem = true;
+        break;
+      }
+
+      case CBNode::kNodeHint:
+        X86Licm_addWrite(ctx, static_cast<CCHint*>(node)->getVReg()->getId());
+        break;
+
+      case CBNode::kNodeComment:
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeFuncExit:
+        break;
+
+      default:
+        // Embedded data, sentinels, and unknown nodes.
+        return 0;
+    }
+  }
+
+  // The loop can be entered only by falling through to `header`.
+  if (numRefs != loopRefs)
+    return 0;
+
+  // Hoisted instructions are inserted before alignment of the loop.
+  CBNode* preheader = header;
+  while (preheader->getPrev() && preheader->getPrev()->getType() == CBNode::kNodeAlign)
+    preheader = preheader->getPrev();
+
+  uint32_t hoisted = 0;
+  node = header->getNext();
+
+  while (node != stop) {
+    CBNode* next = node->getNext();
+
+    if (node->getType() == CBNode::kNodeComment) {
+      node = next;
+      continue;
+    }
+
+    // Only instructions executed in each iteration can be moved.
+    if (node->getType() != CBNode::kNodeInst || static_cast<CBInst*>(node)->isJmpOrJcc())
+      break;
+
+    CBInst* inst = static_cast<CBInst*>(node);
+    if (X86Licm_isHoistable(ctx, inst)) {
+      uint32_t index = Operand::unpackId(inst->getOpArray()[0].getId());
+      ctx.vregWrites[index] = 0;
+
+      cc->removeNode(inst);
+      cc->addBefore(inst, preheader);
+      hoisted++;
+    }
+    else {
+      const Operand* opArray = inst->getOpArray();
+      uint32_t opCount = inst->getOpCount();
+
+      for (uint32_t i = 0; i < opCount; i++) {
+        const Operand& op = opArray[i];
+        if (op.isReg()) {
+          X86Licm_addRead(ctx, op.getId());
+        }
+        else if (op.isMem()) {
+          const X86Mem& m = static_cast<const X86Mem&>(op);
+          if (m.hasBaseReg()) X86Licm_addRead(ctx, m.getBaseId());
+          if (m.hasIndexReg()) X86Licm_addRead(ctx, m.getIndexId());
+        }
+      }
+
+      if (inst->hasExtraReg())
+        X86Licm_addRead(ctx, inst->getExtraReg().getId());
+    }
+
+    node = next;
+  }
+
+  return hoisted;
+}
+
+// ============================================================================
+// [asmjit::X86LicmPass - Construction / Destruction]
+// ============================================================================
+
+X86LicmPass::X86LicmPass() noexcept
+  : CBPass("Licm"),
+    _loopCount(0),
+    _hoistedCount(0) {}
+X86LicmPass::~X86LicmPass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86LicmPass - Interface]
+// ============================================================================
+
+Error X86LicmPass::process(Zone* zone) noexcept {
+  X86Compiler* cc = static_cast<X86Compiler*>(_cb);
+  _loopCount = 0;
+  _hoistedCount = 0;
+
+  X86LicmContext ctx;
+  ctx.cc = cc;
+  ctx.func = 0;
+  ctx.loop = 0;
+  ctx.vregCount = static_cast<uint32_t>(cc->getVirtRegArray().getLength());
+  ctx.labelCount = static_cast<uint32_t>(cc->getCode()->getLabelsCount());
+  ctx.writesMem = false;
+
+  ctx.vregStamp = zone->allocZeroedT<uint32_t>((ctx.vregCount * 3 + 1) * sizeof(uint32_t));
+  ctx.labelBound = zone->allocZeroedT<uint32_t>((ctx.labelCount * 2 + 1) * sizeof(uint32_t));
+
+  if (ASMJIT_UNLIKELY(!ctx.vregStamp || !ctx.labelBound))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  ctx.vregWrites = ctx.vregStamp + ctx.vregCount;
+  ctx.vregRead = ctx.vregWrites + ctx.vregCount;
+  ctx.labelInLoop = ctx.labelBound + ctx.labelCount;
+
+  CBNode* node = cc->getFirstNode();
+  while (node) {
+    CBNode* next = node->getNext();
+
+    switch (node->getType()) {
+      case CBNode::kNodeFunc:
+        ctx.func++;
+        break;
+
+      case CBNode::kNodeLabel: {
+        uint32_t index = Operand::unpackId(static_cast<CBLabel*>(node)->getId());
+        if (index < ctx.labelCount)
+          ctx.labelBound[index] = ctx.func;
+        break;
+      }
+
+      case CBNode::kNodeInst: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        if (!ctx.func || !inst->isJmpOrJcc())
+          break;
+
+        // A jump to a label already bound in this function closes a loop.
+        CBLabel* target = static_cast<CBJump*>(inst)->getTarget();
+        if (!target || target->getType() != CBNode::kNodeLabel)
+          break;
+
+        uint32_t index = Operand::unpackId(target->getId());
+        if (index < ctx.labelCount && ctx.labelBound[index] == ctx.func) {
+          _loopCount++;
+          _hoistedCount += X86Licm_processLoop(ctx, target, static_cast<CBJump*>(inst));
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    node = next;
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86LicmPass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_licm) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+  ci.setStackAlignment(16);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  X86LicmPass* pass = cc.newPassT<X86LicmPass>();
+
+  EXPECT(pass != nullptr);
+  EXPECT(cc.insertPass(0, pass) == kErrorOk);
+
+  cc.addFunc(FuncSignature3<void, int*, const int*, int>(CallConv::kIdX86SysV64));
+
+  X86Gp dst = cc.newIntPtr("dst");
+  X86Gp src = cc.newIntPtr("src");
+  X86Gp cnt = cc.newInt32("cnt");
+  X86Gp k = cc.newInt32("k");
+  X86Gp t = cc.newInt32("t");
+  X86Gp x = cc.newInt32("x");
+  X86Xmm z = cc.newXmm("z");
+  Label L_Loop = cc.newLabel();
+
+  cc.setArg(0, dst);
+  cc.setArg(1, src);
+  cc.setArg(2, cnt);
+
+  cc.bind(L_Loop);
+  cc.mov(k, 100);                        // Invariant.
+  cc.lea(t, x86::ptr(k, k));             // Invariant (depends on hoisted 'k').
+  cc.xorps(z, z);                        // Invariant ('REG ^ REG').
+  cc.mov(x, x86::dword_ptr(src));        // Not invariant, 'src' is written.
+  cc.add(x, t);                          // Not invariant, writes flags.
+  cc.movd(x86::dword_ptr(dst), z);
+  cc.mov(x86::dword_ptr(dst, 4), x);
+  cc.add(src, 4);
+  cc.add(dst, 8);
+  cc.dec(cnt);
+  cc.jnz(L_Loop);
+
+  cc.endFunc();
+
+  INFO("Checking X86LicmPass hoists only invariant instructions");
+  EXPECT(cc.finalize() == kErrorOk);
+  EXPECT(pass->getLoopCount() == 1,
+    "X86LicmPass found %u loops, expected 1", pass->getLoopCount());
+  EXPECT(pass->getHoistedCount() == 3,
+    "X86LicmPass hoisted %u instructions, expected 3", pass->getHoistedCount());
+
+  // Loads are hoisted only if the loop doesn't write memory, XCHG writes its
+  // memory operand even if it's the second one.
+  for (uint32_t i = 0; i < 2; i++) {
+    CodeHolder code;
+    code.init(ci);
+
+    X86Compiler cc(&code);
+    X86LicmPass* pass = cc.newPassT<X86LicmPass>();
+
+    EXPECT(pass != nullptr);
+    EXPECT(cc.insertPass(0, pass) == kErrorOk);
+
+    cc.addFunc(FuncSignature2<int, int*, int>(CallConv::kIdX86SysV64));
+
+    X86Gp p = cc.newIntPtr("p");
+    X86Gp cnt = cc.newInt32("cnt");
+    X86Gp acc = cc.newInt32("acc");
+    X86Gp x = cc.newInt32("x");
+    X86Gp t = cc.newInt32("t");
+    Label L_Loop = cc.newLabel();
+
+    cc.setArg(0, p);
+    cc.setArg(1, cnt);
+    cc.xor_(acc, acc);
+    cc.mov(t, 7);
+
+    cc.bind(L_Loop);
+    cc.mov(x, x86::dword_ptr(p));        // Invariant if the loop doesn't store.
+    if (i == 1)
+      cc.xchg(t, x86::dword_ptr(p));
+    cc.add(acc, x);
+    cc.dec(cnt);
+    cc.jnz(L_Loop);
+
+    cc.ret(acc);
+    cc.endFunc();
+
+    uint32_t expected = i == 0 ? 1 : 0;
+    INFO("Checking X86LicmPass hoists loads only from loops without stores (%s)", i == 0 ? "no store" : "xchg");
+    EXPECT(cc.finalize() == kErrorOk);
+    EXPECT(pass->getLoopCount() == 1,
+      "X86LicmPass found %u loops, expected 1", pass->getLoopCount());
+    EXPECT(pass->getHoistedCount() == expected,
+      "X86LicmPass hoisted %u instructions, expected %u", pass->getHoistedCount(), expected);
+  }
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
@@ -0,0 +1,99 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86LICM_H
+#define _ASMJIT_X86_X86LICM_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codecompiler.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::X86LicmPass]
+// ============================================================================
+
+//! Loop-invariant code motion, \ref CBPass that moves instructions that
+//! compute the same value in each iteration of a loop in front of the loop.
+//!
+//! A loop is formed by a label and a jump back to it (a backward `CBJump`)
+//! and it's considered only if all jumps to labels bound inside the loop come
+//! from the loop itself - the loop is entered only by falling through to its
+//! first label, which acts as a preheader insertion point.
+//!
+//! Only instructions that are executed in each iteration before any branch
+//! (between the first label of the loop and the first jump or label that
+//! follows it) can be moved. The instruction database is used to check that
+//! the instruction:
+//!
+//!   - writes only its first operand, which is a virtual register not written
+//!     by any other instruction in the loop and not read before it,
+//!   - has no implicit operands, doesn't read or write flags, and is not
+//!     volatile (no side effects),
+//!   - reads only virtual registers not written in the loop, immediates, and
+//!     memory, if the loop doesn't write memory and doesn't call functions.
+//!
+//! The pass is not added by default, it has to run before register allocation:
+//!
+//! ~~~
+//! X86Compiler cc(&code);
+//! cc.insertPass(0, cc.newPassT<X86LicmPass>());
+//! ~~~
+class ASMJIT_VIRTAPI X86LicmPass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86LicmPass)
+  typedef CBPass Base;
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API X86LicmPass() noexcept;
+  ASMJIT_API virtual ~X86LicmPass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get how many loops were found by the last `process()`.
+  ASMJIT_INLINE uint32_t getLoopCount() const noexcept { return _loopCount; }
+  //! Get how many instructions were hoisted by the last `process()`.
+  ASMJIT_INLINE uint32_t getHoistedCount() const noexcept { return _hoistedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _loopCount;                   //!< Number of loops found by the last `process()`.
+  uint32_t _hoistedCount;                //!< Number of instructions hoisted by the last `process()`.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86LICM_H
@@ -1007,6 +1007,12 @@ static ASMJIT_INLINE X86Mem ptr(const X86Rip& rip_, int32_t offset = 0, uint32_t
 static ASMJIT_INLINE X86Mem ptr(uint64_t base, uint32_t size = 0) noexcept {
   return X86Mem(base, size);
 }
+//! Create an `[base]` memory operand that is addressed relative to RIP in
+//! 64-bit mode (even if the base address of the code is not known yet, the
+//! displacement is calculated by the relocator then).
+static ASMJIT_INLINE X86Mem ptr_rel(uint64_t base, uint32_t size = 0) noexcept {
+  return X86Mem(base, size, Mem::kSignatureMemRel);
+}
 //! Create an `[abs + (index.reg << shift)]` absolute memory operand.
 static ASMJIT_INLINE X86Mem ptr(uint64_t base, const X86Reg& index, uint32_t shift = 0, uint32_t size = 0) noexcept {
   return X86Mem(base, index, shift, size);
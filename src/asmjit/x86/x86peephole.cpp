@@ -0,0 +1,580 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/utils.h"
+#include "../x86/x86compiler.h"
+#include "../x86/x86operand.h"
+#include "../x86/x86peephole.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86Peephole - Utils]
+// ============================================================================
+
+//! \internal
+//!
+//! Get whether `instId` overwrites all arithmetic flags without reading them.
+static ASMJIT_INLINE bool X86Peephole_writesAllFlags(uint32_t instId) noexcept {
+  switch (instId) {
+    case X86Inst::kIdAdd:
+    case X86Inst::kIdAnd:
+    case X86Inst::kIdCmp:
+    case X86Inst::kIdNeg:
+    case X86Inst::kIdOr:
+    case X86Inst::kIdSub:
+    case X86Inst::kIdTest:
+    case X86Inst::kIdXor:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+//! \internal
+//!
+//! Get whether `instId` neither reads nor writes flags.
+static ASMJIT_INLINE bool X86Peephole_ignoresFlags(uint32_t instId) noexcept {
+  switch (instId) {
+    case X86Inst::kIdBswap:
+    case X86Inst::kIdLea:
+    case X86Inst::kIdMov:
+    case X86Inst::kIdMovsx:
+    case X86Inst::kIdMovsxd:
+    case X86Inst::kIdMovzx:
+    case X86Inst::kIdNop:
+    case X86Inst::kIdNot:
+    case X86Inst::kIdPop:
+    case X86Inst::kIdPush:
+      return true;
+
+    default:
+      // SIMD instructions never read flags (some write them, which is fine).
+      return X86Inst::getInst(instId).getCommonData().isVec();
+  }
+}
+
+//! \internal
+//!
+//! Get whether `instId` is a full-width register or memory move that can also
+//! copy a register of the same kind (used by `mov` and legacy SSE moves).
+static ASMJIT_INLINE bool X86Peephole_isVecMove(uint32_t instId) noexcept {
+  switch (instId) {
+    case X86Inst::kIdMovapd:
+    case X86Inst::kIdMovaps:
+    case X86Inst::kIdMovdqa:
+    case X86Inst::kIdMovdqu:
+    case X86Inst::kIdMovupd:
+    case X86Inst::kIdMovups:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+//! \internal
+static ASMJIT_INLINE bool X86Peephole_isGpdOrGpq(const Operand_& op) noexcept {
+  return X86Reg::isGpd(op) || X86Reg::isGpq(op);
+}
+
+//! \internal
+//!
+//! Get whether `op` is a 32-bit view of a 32-bit virtual register, which has
+//! no upper half that could be observed.
+static ASMJIT_INLINE bool X86Peephole_is32BitVirtReg(X86PeepholePass* self, const Operand_& op) noexcept {
+  if (self->getPhase() != X86PeepholePass::kPhaseVirtual || !op.isVirtReg())
+    return false;
+
+  CodeCompiler* cc = static_cast<CodeCompiler*>(self->getBuilder());
+  return cc->isVirtRegValid(op.getId()) && cc->getVirtRegById(op.getId())->getSize() <= 4;
+}
+
+//! \internal
+//!
+//! Get whether the instruction `node` is a plain instruction having `opCount`
+//! operands, which can be freely rewritten.
+static ASMJIT_INLINE bool X86Peephole_isPlain(const CBInst* node, uint32_t opCount) noexcept {
+  return node->getOpCount() == opCount && !node->hasExtraReg();
+}
+
+//! \internal
+//!
+//! Get the label `label` jumps to by an unconditional jump that immediately
+//! follows it, or null if there is no such jump.
+static CBLabel* X86Peephole_getJmpTargetAt(CBLabel* label) noexcept {
+  CBNode* node = label->getNext();
+  while (node && (node->getType() == CBNode::kNodeLabel ||
+                  node->getType() == CBNode::kNodeComment ||
+                  node->getType() == CBNode::kNodeAlign))
+    node = node->getNext();
+
+  if (!node || !node->isJmp())
+    return nullptr;
+
+  CBJump* jump = static_cast<CBJump*>(node);
+  if (jump->getInstId() != X86Inst::kIdJmp || (jump->getOptions() & CodeEmitter::kOptionUnfollow))
+    return nullptr;
+
+  return jump->getTarget();
+}
+
+// ============================================================================
+// [asmjit::X86Peephole - Rules]
+// ============================================================================
+
+//! \internal
+//!
+//! `mov r, 0` -> `xor r, r`.
+static bool ASMJIT_CDECL X86Peephole_movZero(X86PeepholePass* self, CBInst* node) noexcept {
+  if (!X86Peephole_isPlain(node, 2)) return false;
+
+  Operand* opArray = node->getOpArray();
+  if (!X86Peephole_isGpdOrGpq(opArray[0]) || !self->isPhaseReg(opArray[0])) return false;
+  if (!opArray[1].isImm() || opArray[1].as<Imm>().getInt64() != 0) return false;
+  if (!self->areFlagsDead(node)) return false;
+
+  // Writing a 32-bit register zero extends, so `xor r32, r32` is enough.
+  X86Gpd r = X86Gpd(opArray[0].getId());
+  node->setInstId(X86Inst::kIdXor);
+  opArray[0].copyFrom(r);
+  opArray[1].copyFrom(r);
+  return true;
+}
+
+//! \internal
+//!
+//! `add|sub r, i0` + `add|sub r, i1` -> `add r, i0 + i1`.
+static bool ASMJIT_CDECL X86Peephole_addChain(X86PeepholePass* self, CBInst* node) noexcept {
+  if (!X86Peephole_isPlain(node, 2)) return false;
+
+  Operand* opArray = node->getOpArray();
+  if (!X86Peephole_isGpdOrGpq(opArray[0]) || !self->isPhaseReg(opArray[0]) || !opArray[1].isImm()) return false;
+
+  CBInst* next = self->getNextInst(node);
+  if (!next || !X86Peephole_isPlain(next, 2)) return false;
+  if (next->getInstId() != X86Inst::kIdAdd && next->getInstId() != X86Inst::kIdSub) return false;
+
+  Operand* nextArray = next->getOpArray();
+  if (!nextArray[0].isEqual(opArray[0]) || !nextArray[1].isImm()) return false;
+  if (!self->areFlagsDead(next)) return false;
+
+  int64_t a = opArray[1].as<Imm>().getInt64();
+  int64_t b = nextArray[1].as<Imm>().getInt64();
+
+  if (node->getInstId() == X86Inst::kIdSub) a = -a;
+  if (next->getInstId() == X86Inst::kIdSub) b = -b;
+
+  int64_t sum;
+  if (X86Reg::isGpd(opArray[0])) {
+    // 32-bit arithmetic wraps, the result must be the same.
+    sum = static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+  }
+  else {
+    if (!Utils::isInt32(a) || !Utils::isInt32(b)) return false;
+    sum = a + b;
+    if (!Utils::isInt32(sum)) return false;
+  }
+
+  CodeBuilder* cb = self->getBuilder();
+  cb->removeNode(next);
+
+  if (sum != 0) {
+    node->setInstId(X86Inst::kIdAdd);
+    opArray[1].copyFrom(imm(sum));
+  }
+  else if (X86Reg::isGpd(opArray[0]) && !X86Peephole_is32BitVirtReg(self, opArray[0])) {
+    // Writing a 32-bit register zero extends, the upper half of a 64-bit
+    // register must be cleared even if the sum is zero.
+    node->setInstId(X86Inst::kIdMov);
+    opArray[1].copyFrom(opArray[0]);
+  }
+  else {
+    cb->removeNode(node);
+  }
+  return true;
+}
+
+//! \internal
+//!
+//! `shl r, 1..3` + `add r, s` -> `lea r, [s + r * 2..8]`.
+static bool ASMJIT_CDECL X86Peephole_shlAdd(X86PeepholePass* self, CBInst* node) noexcept {
+  if (!X86Peephole_isPlain(node, 2)) return false;
+
+  Operand* opArray = node->getOpArray();
+  if (!X86Peephole_isGpdOrGpq(opArray[0]) || !self->isPhaseReg(opArray[0]) || !opArray[1].isImm()) return false;
+
+  // Only registers of the native size can be used as base and index.
+  if (opArray[0].getSize() != self->getBuilder()->getArchInfo().getGpSize()) return false;
+
+  int64_t shift = opArray[1].as<Imm>().getInt64();
+  if (shift < 1 || shift > 3) return false;
+
+  CBInst* next = self->getNextInst(node);
+  if (!next || next->getInstId() != X86Inst::kIdAdd || !X86Peephole_isPlain(next, 2)) return false;
+
+  Operand* nextArray = next->getOpArray();
+  if (!nextArray[0].isEqual(opArray[0])) return false;
+  if (!nextArray[1].isReg() || nextArray[1].getSignature() != opArray[0].getSignature()) return false;
+  if (nextArray[1].getId() == opArray[0].getId() || !self->isPhaseReg(nextArray[1])) return false;
+  if (!self->areFlagsDead(next)) return false;
+
+  X86Gp r = opArray[0].as<X86Gp>();
+  X86Gp s = nextArray[1].as<X86Gp>();
+
+  next->setInstId(X86Inst::kIdLea);
+  nextArray[1].copyFrom(x86::ptr(s, r, static_cast<uint32_t>(shift)));
+  next->_updateMemOp();
+
+  self->getBuilder()->removeNode(node);
+  return true;
+}
+
+//! \internal
+//!
+//! `mov a, [m]` + `mov b, [m]` -> `mov a, [m]` + `mov b, a`.
+static bool ASMJIT_CDECL X86Peephole_reload(X86PeepholePass* self, CBInst* node) noexcept {
+  uint32_t instId = node->getInstId();
+  if (!X86Peephole_isPlain(node, 2)) return false;
+
+  // The destination must be write-only, otherwise the result of the second
+  // load would depend on the previous content of its destination.
+  const X86Inst::CommonData& commonData = X86Inst::getInst(instId).getCommonData();
+  if (!commonData.isUseW()) return false;
+
+  Operand* opArray = node->getOpArray();
+  if (!opArray[0].isReg() || !self->isPhaseReg(opArray[0]) || !opArray[1].isMem()) return false;
+
+  // The address must not depend on the register being loaded.
+  const X86Mem& m = opArray[1].as<X86Mem>();
+  uint32_t dstId = opArray[0].getId();
+  if ((m.hasBaseReg() && m.getBaseId() == dstId) || (m.hasIndexReg() && m.getIndexId() == dstId)) return false;
+
+  CBInst* next = self->getNextInst(node);
+  if (!next || next->getInstId() != instId || !X86Peephole_isPlain(next, 2)) return false;
+
+  Operand* nextArray = next->getOpArray();
+  if (!nextArray[1].isEqual(opArray[1])) return false;
+  if (!nextArray[0].isReg() || nextArray[0].getSignature() != opArray[0].getSignature()) return false;
+  if (!self->isPhaseReg(nextArray[0])) return false;
+
+  if (nextArray[0].getId() == dstId) {
+    self->getBuilder()->removeNode(next);
+    return true;
+  }
+
+  if (opArray[0].as<X86Reg>().isGp()) {
+    next->setInstId(X86Inst::kIdMov);
+  }
+  else if (!X86Peephole_isVecMove(instId)) {
+    return false;
+  }
+
+  nextArray[1].copyFrom(opArray[0]);
+  next->_updateMemOp();
+  return true;
+}
+
+//! \internal
+//!
+//! `mov r, r` -> removed.
+static bool ASMJIT_CDECL X86Peephole_selfMove(X86PeepholePass* self, CBInst* node) noexcept {
+  if (!X86Peephole_isPlain(node, 2)) return false;
+
+  Operand* opArray = node->getOpArray();
+  if (!opArray[0].isReg() || !opArray[0].isEqual(opArray[1]) || !self->isPhaseReg(opArray[0])) return false;
+
+  // 32-bit moves zero the upper half of the 64-bit register, they are not
+  // no-ops. Legacy SSE moves never change the upper part of YMM|ZMM.
+  if (node->getInstId() == X86Inst::kIdMov) {
+    if (!X86Reg::isGpq(opArray[0])) return false;
+  }
+  else if (!X86Peephole_isVecMove(node->getInstId())) {
+    return false;
+  }
+
+  self->getBuilder()->removeNode(node);
+  return true;
+}
+
+//! \internal
+//!
+//! `jmp|jcc L0` where `L0: jmp L1` -> `jmp|jcc L1`.
+static bool ASMJIT_CDECL X86Peephole_jumpThreading(X86PeepholePass* self, CBInst* node_) noexcept {
+  if (!node_->isJmpOrJcc()) return false;
+
+  CBJump* node = static_cast<CBJump*>(node_);
+  CBLabel* target = node->getTarget();
+  if (!target || (node->getOptions() & CodeEmitter::kOptionUnfollow)) return false;
+
+  // Follow the chain of jumps, bail if it's too long or if it's a cycle.
+  CBLabel* label = target;
+  uint32_t i;
+
+  for (i = 0; i < 8; i++) {
+    CBLabel* next = X86Peephole_getJmpTargetAt(label);
+    if (!next) break;
+    if (next == target || next == label) return false;
+    label = next;
+  }
+
+  if (i == 0 || i == 8) return false;
+
+  self->retarget(node, label);
+  return true;
+}
+
+//! \internal
+static const X86PeepholeRule x86PeepholeDefaultRules[] = {
+  { X86Inst::kIdMov    , X86PeepholePass::kPhaseAll, X86Peephole_movZero      , "MovZero"       },
+  { X86Inst::kIdAdd    , X86PeepholePass::kPhaseAll, X86Peephole_addChain     , "AddChain"      },
+  { X86Inst::kIdSub    , X86PeepholePass::kPhaseAll, X86Peephole_addChain     , "AddChain"      },
+  { X86Inst::kIdShl    , X86PeepholePass::kPhaseAll, X86Peephole_shlAdd       , "ShlAdd"        },
+  { X86Inst::kIdNone   , X86PeepholePass::kPhaseAll, X86Peephole_reload       , "Reload"        },
+  { X86Inst::kIdNone   , X86PeepholePass::kPhaseAll, X86Peephole_selfMove     , "SelfMove"      },
+  { X86Inst::kIdNone   , X86PeepholePass::kPhaseAll, X86Peephole_jumpThreading, "JumpThreading" }
+};
+
+// ============================================================================
+// [asmjit::X86PeepholePass - Construction / Destruction]
+// ============================================================================
+
+X86PeepholePass::X86PeepholePass(uint32_t phase) noexcept
+  : CBPass(phase == kPhasePhysical ? "PeepholePhys" : "PeepholeVirt"),
+    _phase(phase),
+    _ruleCount(0),
+    _appliedCount(0) {
+
+  for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(x86PeepholeDefaultRules); i++)
+    _rules[_ruleCount++] = x86PeepholeDefaultRules[i];
+}
+X86PeepholePass::~X86PeepholePass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86PeepholePass - Interface]
+// ============================================================================
+
+Error X86PeepholePass::process(Zone* zone) noexcept {
+  ASMJIT_UNUSED(zone);
+
+  CodeBuilder* cb = _cb;
+  CBNode* node = cb->getFirstNode();
+
+  _appliedCount = 0;
+  while (node) {
+    if (node->getType() == CBNode::kNodeInst) {
+      CBInst* inst = static_cast<CBInst*>(node);
+      CBNode* prev = node->getPrev();
+
+      uint32_t instId = inst->getInstId();
+      uint32_t i;
+
+      for (i = 0; i < _ruleCount; i++) {
+        const X86PeepholeRule& rule = _rules[i];
+        if ((rule.phases & _phase) == 0 || (rule.instId != X86Inst::kIdNone && rule.instId != instId))
+          continue;
+
+        if (rule.func(this, inst))
+          break;
+      }
+
+      // Restart at the previous node if the code was changed, so a rule that
+      // matches the result (or a sequence that ends by it) is applied as well.
+      if (i < _ruleCount) {
+        _appliedCount++;
+        node = prev ? prev : cb->getFirstNode();
+        continue;
+      }
+    }
+
+    node = node->getNext();
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86PeepholePass - Rules]
+// ============================================================================
+
+Error X86PeepholePass::addRule(const X86PeepholeRule& rule) noexcept {
+  if (ASMJIT_UNLIKELY(!rule.func))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (ASMJIT_UNLIKELY(_ruleCount >= kMaxRules))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  _rules[_ruleCount++] = rule;
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86PeepholePass - Helpers]
+// ============================================================================
+
+bool X86PeepholePass::isPhaseReg(const Operand_& op) const noexcept {
+  if (!op.isReg()) return false;
+  return _phase == kPhasePhysical ? op.as<Reg>().isPhysReg() : op.as<Reg>().isVirtReg();
+}
+
+bool X86PeepholePass::areFlagsDead(CBNode* node) const noexcept {
+  // Only look a few instructions ahead, it's not a liveness analysis.
+  for (uint32_t i = 0; i < 16; i++) {
+    node = node->getNext();
+    if (!node) return false;
+
+    switch (node->getType()) {
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+      case CBNode::kNodeLabel:
+        continue;
+
+      // Flags are not preserved across function calls and returns.
+      case CBNode::kNodeFuncCall:
+      case CBNode::kNodeFuncExit:
+        return true;
+
+      case CBNode::kNodeInst: {
+        uint32_t instId = static_cast<CBInst*>(node)->getInstId();
+
+        // Conditional jumps read flags and we don't follow jumps.
+        if (node->isJmpOrJcc()) return false;
+
+        if (X86Peephole_writesAllFlags(instId)) return true;
+        if (X86Peephole_ignoresFlags(instId)) continue;
+        return false;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  return false;
+}
+
+CBInst* X86PeepholePass::getNextInst(CBNode* node) const noexcept {
+  do {
+    node = node->getNext();
+  } while (node && node->getType() == CBNode::kNodeComment);
+
+  if (!node || node->getType() != CBNode::kNodeInst)
+    return nullptr;
+  return static_cast<CBInst*>(node);
+}
+
+void X86PeepholePass::retarget(CBJump* node, CBLabel* label) noexcept {
+  CBLabel* old = node->getTarget();
+
+  // Disconnect from the old target.
+  if (old) {
+    CBJump** pPrev = &old->_from;
+    while (*pPrev) {
+      if (*pPrev == node) {
+        *pPrev = node->_jumpNext;
+        break;
+      }
+      pPrev = &(*pPrev)->_jumpNext;
+    }
+    old->subNumRefs();
+  }
+
+  // Connect to the new target.
+  node->_target = label;
+  node->_jumpNext = label->_from;
+  label->_from = node;
+  label->addNumRefs();
+
+  node->getOpArray()[0].copyFrom(Label(label->getId()));
+}
+
+// ============================================================================
+// [asmjit::X86PeepholePass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_peephole) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+
+  CodeHolder code;
+  code.init(ci);
+
+  X86Compiler cc(&code);
+  X86PeepholePass* pass = cc.newPassT<X86PeepholePass>(X86PeepholePass::kPhaseVirtual);
+  EXPECT(cc.insertPass(0, pass) == kErrorOk);
+  EXPECT(cc.getPasses()[0] == pass);
+
+  cc.addFunc(FuncSignature2<int, int*, int>(CallConv::kIdX86SysV64));
+
+  X86Gp p = cc.newIntPtr("p");
+  X86Gp c = cc.newIntPtr("c");
+  X86Gp a = cc.newInt32("a");
+  X86Gp b = cc.newInt32("b");
+  X86Gp x = cc.newInt32("x");
+  X86Gp y = cc.newInt32("y");
+
+  Label L1 = cc.newLabel();
+  Label L2 = cc.newLabel();
+
+  cc.setArg(0, p);
+  cc.setArg(1, a);
+
+  cc.mov(b, 0);                          // MovZero.
+  cc.add(b, a);
+
+  cc.add(a, 1);                          // AddChain (twice).
+  cc.add(a, 2);
+  cc.sub(a, 1);
+  cc.add(b, a);
+
+  cc.mov(x, x86::dword_ptr(p));          // Reload.
+  cc.mov(y, x86::dword_ptr(p));
+
+  cc.mov(c, p);
+  cc.shl(c, 2);                          // ShlAdd.
+  cc.add(c, p);
+
+  cc.add(b, x);
+  cc.add(b, y);
+  cc.mov(x86::dword_ptr(c), b);
+
+  cc.test(a, a);
+  cc.jz(L1);                             // JumpThreading.
+  cc.inc(b);
+  cc.bind(L1);
+  cc.jmp(L2);
+  cc.bind(L2);
+
+  cc.ret(b);
+  cc.endFunc();
+
+  INFO("Checking X86PeepholePass default rules");
+  EXPECT(cc.finalize() == kErrorOk);
+  EXPECT(pass->getAppliedCount() == 6,
+    "X86PeepholePass applied %u rules, expected 6", pass->getAppliedCount());
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
@@ -0,0 +1,176 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86PEEPHOLE_H
+#define _ASMJIT_X86_X86PEEPHOLE_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codebuilder.h"
+#include "../x86/x86inst.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [Forward Declarations]
+// ============================================================================
+
+class X86PeepholePass;
+
+// ============================================================================
+// [asmjit::X86PeepholeRule]
+// ============================================================================
+
+//! Peephole rule used by \ref X86PeepholePass.
+struct X86PeepholeRule {
+  //! Rule function, called for each `CBInst` matching `instId`.
+  //!
+  //! Returns true if the code has been changed. The function can modify the
+  //! `node` and nodes that follow it, or remove them, the pass restarts the
+  //! matching at the node that precedes `node` afterwards.
+  typedef bool (ASMJIT_CDECL* Func)(X86PeepholePass* pass, CBInst* node);
+
+  uint32_t instId;                       //!< Instruction id, `X86Inst::kIdNone` matches all.
+  uint32_t phases;                       //!< Phases the rule applies to, see \ref X86PeepholePass::Phase.
+  Func func;                             //!< Rule function.
+  const char* name;                      //!< Rule name.
+};
+
+// ============================================================================
+// [asmjit::X86PeepholePass]
+// ============================================================================
+
+//! Peephole optimizer, \ref CBPass that rewrites short sequences of X86/X64
+//! instructions by using a table of \ref X86PeepholeRule rules.
+//!
+//! The pass is not added by default. To run it on virtual registers (before
+//! register allocation) insert it before the passes added by `X86Compiler`,
+//! to run it on physical registers add it after them:
+//!
+//! ~~~
+//! X86Compiler cc(&code);
+//!
+//! cc.insertPass(0, cc.newPassT<X86PeepholePass>(X86PeepholePass::kPhaseVirtual));
+//! cc.addPassT<X86PeepholePass>(X86PeepholePass::kPhasePhysical);
+//! ~~~
+//!
+//! The default rules:
+//!
+//!   - `mov r, 0` -> `xor r, r` (if flags are not used).
+//!   - `add|sub r, i0` + `add|sub r, i1` -> `add r, i0 + i1`.
+//!   - `shl r, 1..3` + `add r, s` -> `lea r, [s + r * 2..8]`.
+//!   - `mov a, [m]` + `mov b, [m]` -> `mov a, [m]` + `mov b, a`.
+//!   - `mov r, r` -> removed (64-bit and vector registers only).
+//!   - `jmp|jcc L0` where `L0: jmp L1` -> `jmp|jcc L1`.
+//!
+//! Custom rules can be added by `addRule()`.
+class ASMJIT_VIRTAPI X86PeepholePass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86PeepholePass)
+  typedef CBPass Base;
+
+  //! Phase of the code the pass runs on.
+  ASMJIT_ENUM(Phase) {
+    kPhaseVirtual  = 0x01U,              //!< Before register allocation (virtual registers).
+    kPhasePhysical = 0x02U,              //!< After register allocation (physical registers).
+    kPhaseAll      = 0x03U               //!< All phases (used by rules).
+  };
+
+  enum {
+    //! Maximum number of rules (default rules included).
+    kMaxRules = 32
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `X86PeepholePass` running in the given `phase` with the
+  //! default rules.
+  ASMJIT_API X86PeepholePass(uint32_t phase = kPhaseVirtual) noexcept;
+  ASMJIT_API virtual ~X86PeepholePass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the phase of the pass, see \ref Phase.
+  ASMJIT_INLINE uint32_t getPhase() const noexcept { return _phase; }
+  //! Get the `CodeBuilder` the pass is assigned to.
+  ASMJIT_INLINE CodeBuilder* getBuilder() const noexcept { return _cb; }
+
+  //! Get the number of rules.
+  ASMJIT_INLINE uint32_t getRuleCount() const noexcept { return _ruleCount; }
+  //! Get rules.
+  ASMJIT_INLINE const X86PeepholeRule* getRules() const noexcept { return _rules; }
+  //! Get how many times the rules were applied by the last `process()`.
+  ASMJIT_INLINE uint32_t getAppliedCount() const noexcept { return _appliedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Rules]
+  // --------------------------------------------------------------------------
+
+  //! Add a custom `rule`, rules are matched in order they were added.
+  ASMJIT_API Error addRule(const X86PeepholeRule& rule) noexcept;
+  //! Remove all rules, including the default ones.
+  ASMJIT_INLINE void resetRules() noexcept { _ruleCount = 0; }
+
+  // --------------------------------------------------------------------------
+  // [Helpers]
+  // --------------------------------------------------------------------------
+
+  //! Get whether the operand `op` can be processed in the current phase -
+  //! registers have to be virtual in `kPhaseVirtual` and physical in
+  //! `kPhasePhysical`.
+  ASMJIT_API bool isPhaseReg(const Operand_& op) const noexcept;
+
+  //! Get whether the flags written by an instruction replacing `node` would
+  //! be dead - they are overwritten before any instruction that follows
+  //! `node` reads them.
+  ASMJIT_API bool areFlagsDead(CBNode* node) const noexcept;
+
+  //! Get the next instruction after `node`, skips comments, returns null if
+  //! the next node is not `CBInst`.
+  ASMJIT_API CBInst* getNextInst(CBNode* node) const noexcept;
+
+  //! Change the target of the jump `node` to `label`.
+  ASMJIT_API void retarget(CBJump* node, CBLabel* label) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _phase;                       //!< Phase of the pass.
+  uint32_t _ruleCount;                   //!< Number of rules.
+  uint32_t _appliedCount;                //!< Number of rules applied by the last `process()`.
+  X86PeepholeRule _rules[kMaxRules];     //!< Rules.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86PEEPHOLE_H
@@ -0,0 +1,764 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Guard]
+#include "../asmjit_build.h"
+#if defined(ASMJIT_BUILD_X86) && !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../x86/x86compiler.h"
+#include "../x86/x86operand.h"
+#include "../x86/x86profile.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::X86ProfileRegion]
+// ============================================================================
+
+//! \internal
+//!
+//! Code selected to be moved to the end of a function.
+struct X86ProfileRegion {
+  X86ProfileRegion* next;                //!< Next region (in code order).
+  CBNode* first;                         //!< Cold label or conditional jump.
+  bool isJcc;                            //!< `first` is a conditional jump that skips the region.
+};
+
+// ============================================================================
+// [asmjit::X86Profile - Utils]
+// ============================================================================
+
+//! \internal
+static const uint32_t X86Profile_kArithFlags =
+  x86::kSpecialReg_FLAGS_CF | x86::kSpecialReg_FLAGS_PF | x86::kSpecialReg_FLAGS_AF |
+  x86::kSpecialReg_FLAGS_ZF | x86::kSpecialReg_FLAGS_SF | x86::kSpecialReg_FLAGS_OF;
+
+//! \internal
+//!
+//! Get the counter of `label`, returns false if the label has no counter.
+static ASMJIT_INLINE bool X86Profile_getCount(const X86ProfilePass* self, const CBLabel* label, uint64_t& count) noexcept {
+  uint32_t index = Operand::unpackId(label->getId());
+  if (index >= self->getCounterCount())
+    return false;
+
+  count = self->getCounters()[index];
+  return true;
+}
+
+//! \internal
+//!
+//! Get the condition code of a conditional jump `instId`, or `x86::kCondCount`
+//! if `instId` is not a conditional jump like JECXZ.
+static uint32_t X86Profile_jccToCond(uint32_t instId) noexcept {
+  switch (instId) {
+    case X86Inst::kIdJo:   return x86::kCondO;
+    case X86Inst::kIdJno:  return x86::kCondNO;
+    case X86Inst::kIdJb:   return x86::kCondB;
+    case X86Inst::kIdJc:   return x86::kCondC;
+    case X86Inst::kIdJnae: return x86::kCondNAE;
+    case X86Inst::kIdJae:  return x86::kCondAE;
+    case X86Inst::kIdJnb:  return x86::kCondNB;
+    case X86Inst::kIdJnc:  return x86::kCondNC;
+    case X86Inst::kIdJe:   return x86::kCondE;
+    case X86Inst::kIdJz:   return x86::kCondZ;
+    case X86Inst::kIdJne:  return x86::kCondNE;
+    case X86Inst::kIdJnz:  return x86::kCondNZ;
+    case X86Inst::kIdJbe:  return x86::kCondBE;
+    case X86Inst::kIdJna:  return x86::kCondNA;
+    case X86Inst::kIdJa:   return x86::kCondA;
+    case X86Inst::kIdJnbe: return x86::kCondNBE;
+    case X86Inst::kIdJs:   return x86::kCondS;
+    case X86Inst::kIdJns:  return x86::kCondNS;
+    case X86Inst::kIdJp:   return x86::kCondP;
+    case X86Inst::kIdJpe:  return x86::kCondPE;
+    case X86Inst::kIdJpo:  return x86::kCondPO;
+    case X86Inst::kIdJnp:  return x86::kCondNP;
+    case X86Inst::kIdJl:   return x86::kCondL;
+    case X86Inst::kIdJnge: return x86::kCondNGE;
+    case X86Inst::kIdJge:  return x86::kCondGE;
+    case X86Inst::kIdJnl:  return x86::kCondNL;
+    case X86Inst::kIdJle:  return x86::kCondLE;
+    case X86Inst::kIdJng:  return x86::kCondNG;
+    case X86Inst::kIdJg:   return x86::kCondG;
+    case X86Inst::kIdJnle: return x86::kCondNLE;
+    default:               return x86::kCondCount;
+  }
+}
+
+//! \internal
+//!
+//! Get whether the code never continues after `node` (unconditional jump or
+//! function return).
+static ASMJIT_INLINE bool X86Profile_isUnconditional(const CBNode* node) noexcept {
+  if (node->getType() == CBNode::kNodeFuncExit)
+    return true;
+  return node->isJmp() && static_cast<const CBInst*>(node)->getInstId() == X86Inst::kIdJmp;
+}
+
+//! \internal
+//!
+//! Get the node that precedes `node`, skipping nodes that don't emit code.
+static ASMJIT_INLINE CBNode* X86Profile_getPrevCode(CBNode* node) noexcept {
+  do {
+    node = node->getPrev();
+  } while (node && (node->getType() == CBNode::kNodeComment || node->getType() == CBNode::kNodeAlign));
+  return node;
+}
+
+//! \internal
+//!
+//! Get whether arithmetic flags are overwritten before they are read by the
+//! code that follows `node`. Only a few nodes of the current block are checked.
+static bool X86Profile_areFlagsDead(const CBNode* node) noexcept {
+  uint32_t flags = X86Profile_kArithFlags;
+
+  for (uint32_t i = 0; i < 32; i++) {
+    node = node->getNext();
+    if (!node) return false;
+
+    switch (node->getType()) {
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+      case CBNode::kNodeHint:
+      case CBNode::kNodeLabel:
+        continue;
+
+      // Flags are not preserved across function calls and returns.
+      case CBNode::kNodeFuncCall:
+      case CBNode::kNodeFuncExit:
+        return true;
+
+      case CBNode::kNodeInst: {
+        if (node->isJmpOrJcc())
+          return false;
+
+        const X86Inst::OperationData& operationData =
+          X86Inst::getInst(static_cast<const CBInst*>(node)->getInstId()).getOperationData();
+
+        if (operationData.getSpecialRegsR() & flags)
+          return false;
+
+        flags &= ~operationData.getSpecialRegsW();
+        if (!flags)
+          return true;
+        continue;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  return false;
+}
+
+//! \internal
+//!
+//! Get the end of a region that starts at `first` - the first label that
+//! follows it. Returns null if the region contains a node that can't be moved.
+static CBNode* X86Profile_getRegionEnd(CBNode* first) noexcept {
+  CBNode* node = first;
+  while (node) {
+    switch (node->getType()) {
+      case CBNode::kNodeLabel:
+        if (node != first)
+          return node;
+        break;
+
+      case CBNode::kNodeInst:
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+      case CBNode::kNodeFuncExit:
+      case CBNode::kNodeFuncCall:
+      case CBNode::kNodePushArg:
+      case CBNode::kNodeHint:
+        break;
+
+      default:
+        return nullptr;
+    }
+    node = node->getNext();
+  }
+  return nullptr;
+}
+
+//! \internal
+//!
+//! Move nodes `first` to `last` (inclusive) before `ref`.
+//!
+//! Unlike `CodeBuilder::removeNode()` + `addBefore()` this keeps jumps linked
+//! with their labels.
+static void X86Profile_moveNodes(CBNode* first, CBNode* last, CBNode* ref) noexcept {
+  CBNode* prev = first->_prev;
+  CBNode* next = last->_next;
+
+  // Regions are always inside of a function, never at the beginning or end.
+  ASMJIT_ASSERT(prev != nullptr && next != nullptr && ref->_prev != nullptr);
+
+  prev->_next = next;
+  next->_prev = prev;
+
+  first->_prev = ref->_prev;
+  last->_next = ref;
+  ref->_prev->_next = first;
+  ref->_prev = last;
+}
+
+//! \internal
+//!
+//! Make the jump `node` jump to `label`.
+static void X86Profile_retarget(CBJump* node, CBLabel* label) noexcept {
+  CBLabel* old = node->getTarget();
+
+  // Disconnect from the old target.
+  if (old) {
+    CBJump** pPrev = &old->_from;
+    while (*pPrev) {
+      if (*pPrev == node) {
+        *pPrev = node->_jumpNext;
+        break;
+      }
+      pPrev = &(*pPrev)->_jumpNext;
+    }
+    old->subNumRefs();
+  }
+
+  // Connect to the new target.
+  node->_target = label;
+  node->_jumpNext = label->_from;
+  label->_from = node;
+  label->addNumRefs();
+
+  node->getOpArray()[0].copyFrom(Label(label->getId()));
+}
+
+//! \internal
+//!
+//! Emit a jump to `label` after `node`.
+static Error X86Profile_emitJmpAfter(X86Compiler* cc, CBNode* node, CBLabel* label) noexcept {
+  CBNode* prevCursor = cc->setCursor(node);
+  Error err = cc->jmp(label->getLabel());
+  cc->setCursor(prevCursor);
+  return err;
+}
+
+// ============================================================================
+// [asmjit::X86Profile - Instrument]
+// ============================================================================
+
+//! \internal
+//!
+//! Insert an increment of the `counter` after `node`.
+static Error X86Profile_emitCounter(X86Compiler* cc, CBNode* node, uint64_t* counter) noexcept {
+  bool flagsDead = X86Profile_areFlagsDead(node);
+  CBNode* prevCursor = cc->setCursor(node);
+
+  X86Gp p = cc->newIntPtr("counter");
+  ASMJIT_PROPAGATE(cc->mov(p, imm_ptr(counter)));
+
+  if (cc->is64Bit()) {
+    if (flagsDead) {
+      ASMJIT_PROPAGATE(cc->inc(x86::qword_ptr(p)));
+    }
+    else {
+      X86Gp x = cc->newUInt64("count");
+      ASMJIT_PROPAGATE(cc->mov(x, x86::qword_ptr(p)));
+      ASMJIT_PROPAGATE(cc->lea(x, x86::ptr(x, 1)));
+      ASMJIT_PROPAGATE(cc->mov(x86::qword_ptr(p), x));
+    }
+  }
+  else {
+    if (flagsDead) {
+      ASMJIT_PROPAGATE(cc->add(x86::dword_ptr(p), 1));
+      ASMJIT_PROPAGATE(cc->adc(x86::dword_ptr(p, 4), 0));
+    }
+    else {
+      // There is no way to propagate the carry without touching flags, only
+      // the low 32 bits of the counter are incremented.
+      X86Gp x = cc->newUInt32("count");
+      ASMJIT_PROPAGATE(cc->mov(x, x86::dword_ptr(p)));
+      ASMJIT_PROPAGATE(cc->lea(x, x86::ptr(x, 1)));
+      ASMJIT_PROPAGATE(cc->mov(x86::dword_ptr(p), x));
+    }
+  }
+
+  cc->setCursor(prevCursor);
+  return kErrorOk;
+}
+
+//! \internal
+static Error X86Profile_instrumentFunc(X86ProfilePass* self, X86Compiler* cc, CCFunc* func) noexcept {
+  CBNode* stop = func->getExitNode();
+  CBNode* node = func;
+
+  while (node && node != stop) {
+    CBNode* next = node->getNext();
+
+    if (node->getType() == CBNode::kNodeFunc || node->getType() == CBNode::kNodeLabel) {
+      uint32_t index = Operand::unpackId(static_cast<CBLabel*>(node)->getId());
+      if (index < self->getCounterCount()) {
+        ASMJIT_PROPAGATE(X86Profile_emitCounter(cc, node, self->getCounters() + index));
+        self->_instrumentedCount++;
+      }
+    }
+
+    node = next;
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86Profile - Layout]
+// ============================================================================
+
+//! \internal
+//!
+//! Record the execution `count` of a block that uses `op`.
+static ASMJIT_INLINE void X86Profile_useOp(X86Compiler* cc, uint64_t* vregMax, uint32_t vregCount, const Operand_& op, uint64_t count) noexcept {
+  uint32_t ids[2];
+  uint32_t n = 0;
+
+  if (op.isReg()) {
+    ids[n++] = op.getId();
+  }
+  else if (op.isMem()) {
+    const X86Mem& m = static_cast<const X86Mem&>(op);
+    if (m.hasBaseReg()) ids[n++] = m.getBaseId();
+    if (m.hasIndexReg()) ids[n++] = m.getIndexId();
+  }
+
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t index = Operand::unpackId(ids[i]);
+    if (!Operand::isPackedId(ids[i]) || index >= vregCount)
+      continue;
+
+    // Zero means the register is not used in a block having a counter.
+    uint64_t value = count + 1;
+    if (vregMax[index] < value)
+      vregMax[index] = value;
+  }
+
+  ASMJIT_UNUSED(cc);
+}
+
+//! \internal
+static Error X86Profile_layoutFunc(X86ProfilePass* self, X86Compiler* cc, CCFunc* func, Zone* zone, uint64_t* vregMax, uint32_t vregCount) noexcept {
+  CBLabel* exitNode = func->getExitNode();
+  uint64_t entryCount = 0;
+
+  if (!X86Profile_getCount(self, func, entryCount))
+    return kErrorOk;
+
+  X86ProfileRegion* first = nullptr;
+  X86ProfileRegion** pNext = &first;
+
+  // Block state - count of the block (if known), whether the current node is
+  // reached only from the block's label, and whether the block is moved.
+  uint64_t count = entryCount;
+  bool countKnown = true;
+  bool straight = true;
+  bool isCold = false;
+
+  CBNode* node = func;
+  while (node != exitNode) {
+    switch (node->getType()) {
+      case CBNode::kNodeLabel: {
+        CBLabel* label = static_cast<CBLabel*>(node);
+        countKnown = X86Profile_getCount(self, label, count);
+        straight = true;
+        isCold = false;
+
+        // Cold block entered only by jumps.
+        if (countKnown && entryCount != 0 && count * X86ProfilePass::kColdRatio < entryCount) {
+          CBNode* prev = X86Profile_getPrevCode(label);
+          if (prev && X86Profile_isUnconditional(prev) && X86Profile_getRegionEnd(label)) {
+            X86ProfileRegion* region = zone->allocT<X86ProfileRegion>();
+            if (ASMJIT_UNLIKELY(!region))
+              return DebugUtils::errored(kErrorNoHeapMemory);
+
+            region->next = nullptr;
+            region->first = label;
+            region->isJcc = false;
+
+            *pNext = region;
+            pNext = &region->next;
+            isCold = true;
+          }
+        }
+        break;
+      }
+
+      case CBNode::kNodeInst:
+      case CBNode::kNodeFuncCall: {
+        CBInst* inst = static_cast<CBInst*>(node);
+        const Operand* opArray = inst->getOpArray();
+        uint32_t opCount = inst->getOpCount();
+
+        if (countKnown) {
+          for (uint32_t i = 0; i < opCount; i++)
+            X86Profile_useOp(cc, vregMax, vregCount, opArray[i], count);
+
+          if (node->getType() == CBNode::kNodeFuncCall) {
+            CCFuncCall* call = static_cast<CCFuncCall*>(node);
+            uint32_t argCount = call->getDetail().getArgCount();
+
+            for (uint32_t i = 0; i < argCount; i++)
+              X86Profile_useOp(cc, vregMax, vregCount, call->getArg(i), count);
+
+            X86Profile_useOp(cc, vregMax, vregCount, call->getRet(0), count);
+            X86Profile_useOp(cc, vregMax, vregCount, call->getRet(1), count);
+          }
+        }
+
+        if (!node->isJmpOrJcc())
+          break;
+
+        CBJump* jump = static_cast<CBJump*>(node);
+        CBLabel* target = jump->getTarget();
+        uint32_t cond = X86Profile_jccToCond(jump->getInstId());
+
+        // The target must be entered only by this jump to know how many times
+        // the jump was taken, and the jump must be reached only from the label
+        // of its block to know how many times it was executed.
+        uint64_t taken;
+        if (countKnown && straight && !isCold && opCount == 1 && cond != x86::kCondCount &&
+            target && target->getNumRefs() == 1 && X86Profile_getCount(self, target, taken)) {
+          CBNode* prev = X86Profile_getPrevCode(target);
+          uint64_t fall = count > taken ? count - taken : 0;
+
+          if (prev && X86Profile_isUnconditional(prev) && taken > fall) {
+            X86ProfileRegion* region = zone->allocT<X86ProfileRegion>();
+            if (ASMJIT_UNLIKELY(!region))
+              return DebugUtils::errored(kErrorNoHeapMemory);
+
+            region->next = nullptr;
+            region->first = jump;
+            region->isJcc = true;
+
+            *pNext = region;
+            pNext = &region->next;
+          }
+        }
+
+        straight = false;
+        break;
+      }
+
+      case CBNode::kNodeFuncExit: {
+        if (countKnown) {
+          CCFuncRet* ret = static_cast<CCFuncRet*>(node);
+          X86Profile_useOp(cc, vregMax, vregCount, ret->getFirst(), count);
+          X86Profile_useOp(cc, vregMax, vregCount, ret->getSecond(), count);
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    node = node->getNext();
+  }
+
+  if (!first)
+    return kErrorOk;
+
+  // The code moved to the end of the function must not be entered by falling
+  // through from the last block of the function.
+  CBNode* last = X86Profile_getPrevCode(exitNode);
+  if (last && !X86Profile_isUnconditional(last))
+    ASMJIT_PROPAGATE(X86Profile_emitJmpAfter(cc, last, exitNode));
+
+  for (X86ProfileRegion* region = first; region; region = region->next) {
+    if (region->isJcc) {
+      CBJump* jump = static_cast<CBJump*>(region->first);
+      CBNode* start = jump->getNext();
+      CBNode* end = X86Profile_getRegionEnd(start);
+
+      if (start == end)
+        continue;
+
+      // The skipped code must end at the jump's target and by an unconditional
+      // jump or return, which is what makes the target a block entered only
+      // by the jump. Otherwise the inverted jump would fall into other code.
+      CBNode* endCode = end ? X86Profile_getPrevCode(end) : nullptr;
+      if (end != jump->getTarget() || !endCode || endCode == jump || !X86Profile_isUnconditional(endCode)) {
+        jump->orFlags(CBNode::kFlagIsTaken);
+        continue;
+      }
+
+      CBLabel* label = cc->newLabelNode();
+      if (ASMJIT_UNLIKELY(!label))
+        return DebugUtils::errored(kErrorNoHeapMemory);
+
+      cc->addBefore(label, exitNode);
+      X86Profile_moveNodes(start, end->getPrev(), exitNode);
+
+      uint32_t cond = X86Profile_jccToCond(jump->getInstId());
+      jump->setInstId(X86Inst::condToJcc(X86Inst::negateCond(cond)));
+      X86Profile_retarget(jump, label);
+
+      self->_invertedCount++;
+    }
+    else {
+      CBNode* start = region->first;
+      CBNode* end = X86Profile_getRegionEnd(start);
+      if (!end)
+        continue;
+
+      CBNode* endCode = X86Profile_getPrevCode(end);
+      CBNode* moveLast = end->getPrev();
+
+      X86Profile_moveNodes(start, moveLast, exitNode);
+      if (!X86Profile_isUnconditional(endCode))
+        ASMJIT_PROPAGATE(X86Profile_emitJmpAfter(cc, moveLast, static_cast<CBLabel*>(end)));
+
+      self->_movedCount++;
+    }
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86ProfilePass - Construction / Destruction]
+// ============================================================================
+
+X86ProfilePass::X86ProfilePass(uint32_t mode, uint64_t* counters, uint32_t counterCount) noexcept
+  : CBPass("Profile"),
+    _mode(mode),
+    _counterCount(counters ? counterCount : 0),
+    _counters(counters),
+    _instrumentedCount(0),
+    _movedCount(0),
+    _invertedCount(0) {}
+X86ProfilePass::~X86ProfilePass() noexcept {}
+
+// ============================================================================
+// [asmjit::X86ProfilePass - Interface]
+// ============================================================================
+
+Error X86ProfilePass::process(Zone* zone) noexcept {
+  X86Compiler* cc = static_cast<X86Compiler*>(_cb);
+
+  _instrumentedCount = 0;
+  _movedCount = 0;
+  _invertedCount = 0;
+
+  uint32_t vregCount = static_cast<uint32_t>(cc->getVirtRegArray().getLength());
+  uint64_t* vregMax = nullptr;
+
+  if (_mode == kModeLayout) {
+    vregMax = zone->allocZeroedT<uint64_t>((vregCount + 1) * sizeof(uint64_t));
+    if (ASMJIT_UNLIKELY(!vregMax))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+  }
+
+  CBNode* node = cc->getFirstNode();
+  while (node) {
+    if (node->getType() == CBNode::kNodeFunc) {
+      CCFunc* func = static_cast<CCFunc*>(node);
+
+      if (_mode == kModeInstrument)
+        ASMJIT_PROPAGATE(X86Profile_instrumentFunc(this, cc, func));
+      else
+        ASMJIT_PROPAGATE(X86Profile_layoutFunc(this, cc, func, zone, vregMax, vregCount));
+
+      node = func->getEnd();
+    }
+
+    node = node->getNext();
+  }
+
+  // Priority of a register is based on the number of bits needed to store the
+  // count of the hottest block it's used in, which is 1 for registers used
+  // only by code that never executed. Registers used only in blocks without
+  // a counter keep the default priority.
+  if (_mode == kModeLayout) {
+    for (uint32_t i = 0; i < vregCount; i++) {
+      uint64_t value = vregMax[i];
+      if (!value)
+        continue;
+
+      uint32_t priority = 0;
+      while (value) {
+        priority++;
+        value >>= 1;
+      }
+      cc->getVirtRegArray()[i]->setPriority(priority);
+    }
+  }
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::X86ProfilePass - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+//! \internal
+//!
+//! Compile a function that sums an array of 16 integers and counts negative
+//! elements of it, by using the given `pass`.
+static void X86Profile_compileTest(X86Compiler& cc, X86ProfilePass* pass) noexcept {
+  cc.insertPass(0, pass);
+  cc.addFunc(FuncSignature2<int, const int*, int*>(CallConv::kIdX86SysV64));
+
+  X86Gp src = cc.newIntPtr("src");
+  X86Gp neg = cc.newIntPtr("neg");
+  X86Gp i = cc.newInt32("i");
+  X86Gp x = cc.newInt32("x");
+  X86Gp sum = cc.newInt32("sum");
+
+  Label L_Null = cc.newLabel();
+  Label L_Start = cc.newLabel();
+  Label L_Loop = cc.newLabel();
+  Label L_Pos = cc.newLabel();
+  Label L_Next = cc.newLabel();
+
+  cc.setArg(0, src);
+  cc.setArg(1, neg);
+  cc.test(src, src);
+  cc.jz(L_Null);
+  cc.jmp(L_Start);
+
+  cc.bind(L_Null);                       // Cold, moved to the end.
+  cc.mov(sum, -1);
+  cc.ret(sum);
+
+  cc.bind(L_Start);
+  cc.xor_(sum, sum);
+  cc.mov(i, 16);
+
+  cc.bind(L_Loop);
+  cc.mov(x, x86::dword_ptr(src));
+  cc.add(sum, x);
+  cc.test(x, x);
+  cc.jns(L_Pos);                         // Mostly taken, inverted.
+  cc.inc(x86::dword_ptr(neg));
+  cc.jmp(L_Next);
+
+  cc.bind(L_Pos);
+  cc.bind(L_Next);
+  cc.add(src, 4);
+  cc.dec(i);
+  cc.jnz(L_Loop);
+  cc.ret(sum);
+
+  cc.endFunc();
+}
+
+UNIT(x86_profile) {
+  CodeInfo ci(ArchInfo::kTypeX64);
+  ci.setCdeclCallConv(CallConv::kIdX86SysV64);
+  ci.setStackAlignment(16);
+
+  uint64_t counters[8] = { 0 };
+
+  {
+    CodeHolder code;
+    code.init(ci);
+
+    X86Compiler cc(&code);
+    X86ProfilePass* pass = cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeInstrument, counters, 8);
+    EXPECT(pass != nullptr);
+
+    X86Profile_compileTest(cc, pass);
+
+    INFO("Checking X86ProfilePass instruments all labels except the exit label");
+    EXPECT(cc.finalize() == kErrorOk);
+    EXPECT(pass->getInstrumentedCount() == 6,
+      "X86ProfilePass inserted %u counters, expected 6", pass->getInstrumentedCount());
+  }
+
+  // Counters of the function and its labels as if it was called 100 times
+  // for arrays having 5 negative elements in total.
+  counters[0] = 100;                     // Function.
+  counters[2] = 0;                       // L_Null.
+  counters[3] = 100;                     // L_Start.
+  counters[4] = 1600;                    // L_Loop.
+  counters[5] = 1595;                    // L_Pos.
+  counters[6] = 1600;                    // L_Next.
+
+  {
+    CodeHolder code;
+    code.init(ci);
+
+    X86Compiler cc(&code);
+    X86ProfilePass* pass = cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeLayout, counters, 8);
+    EXPECT(pass != nullptr);
+
+    X86Profile_compileTest(cc, pass);
+
+    INFO("Checking X86ProfilePass moves cold code out of line");
+    EXPECT(cc.finalize() == kErrorOk);
+    EXPECT(pass->getMovedCount() == 1,
+      "X86ProfilePass moved %u blocks, expected 1", pass->getMovedCount());
+    EXPECT(pass->getInvertedCount() == 1,
+      "X86ProfilePass inverted %u jumps, expected 1", pass->getInvertedCount());
+  }
+
+  // Conditional jumps having more names (JZ is JE, JNZ is JNE) are inverted
+  // regardless of the name used.
+  static const uint32_t jccIds[] = { X86Inst::kIdJz, X86Inst::kIdJnz, X86Inst::kIdJe, X86Inst::kIdJne };
+
+  counters[0] = 100;                     // Function.
+  counters[2] = 90;                      // L_Taken.
+  counters[3] = 100;                     // L_Done.
+
+  for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(jccIds); i++) {
+    CodeHolder code;
+    code.init(ci);
+
+    X86Compiler cc(&code);
+    X86ProfilePass* pass = cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeLayout, counters, 4);
+    EXPECT(pass != nullptr);
+
+    cc.insertPass(0, pass);
+    cc.addFunc(FuncSignature1<int, int>(CallConv::kIdX86SysV64));
+
+    X86Gp x = cc.newInt32("x");
+    X86Gp r = cc.newInt32("r");
+    Label L_Taken = cc.newLabel();
+    Label L_Done = cc.newLabel();
+
+    cc.setArg(0, x);
+    cc.test(x, x);
+    cc.emit(jccIds[i], L_Taken);         // Mostly taken, inverted.
+    cc.mov(r, 1);
+    cc.jmp(L_Done);
+
+    cc.bind(L_Taken);
+    cc.mov(r, 2);
+
+    cc.bind(L_Done);
+    cc.ret(r);
+    cc.endFunc();
+
+    INFO("Checking X86ProfilePass inverts '%s'", X86Inst::getInst(jccIds[i]).getName());
+    EXPECT(cc.finalize() == kErrorOk);
+    EXPECT(pass->getInvertedCount() == 1,
+      "X86ProfilePass inverted %u jumps, expected 1", pass->getInvertedCount());
+  }
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // ASMJIT_BUILD_X86 && !ASMJIT_DISABLE_COMPILER
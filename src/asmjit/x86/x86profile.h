@@ -0,0 +1,143 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_X86_X86PROFILE_H
+#define _ASMJIT_X86_X86PROFILE_H
+
+#include "../asmjit_build.h"
+#if !defined(ASMJIT_DISABLE_COMPILER)
+
+// [Dependencies]
+#include "../base/codecompiler.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_x86
+//! \{
+
+// ============================================================================
+// [asmjit::X86ProfilePass]
+// ============================================================================
+
+//! Profile-guided block layout, \ref CBPass that either instruments the code
+//! by block counters or uses the counters collected by the instrumented code
+//! to lay out the code when it's compiled again.
+//!
+//! The profile is a plain array of 64-bit counters indexed by label ids (see
+//! `Operand::unpackId()`), the counter of a `CCFunc` counts calls of the
+//! function. Labels must be created in the same order by both compilations,
+//! which is the case if the same code is generated and the pass runs before
+//! all other passes.
+//!
+//! In \ref kModeInstrument mode the pass inserts a counter increment after
+//! each label of a function (except its exit label). The increment is `inc`
+//! (or `add` + `adc` in 32-bit mode) if flags are overwritten by the code that
+//! follows the label, otherwise flags are preserved by using `lea`.
+//!
+//! In \ref kModeLayout mode the pass:
+//!
+//!   - moves cold blocks (entered only by jumps and executed less than once
+//!     per `kColdRatio` calls of the function) to the end of the function,
+//!   - inverts a conditional jump that is taken more often than not if the
+//!     code it skips ends by an unconditional jump or return, and moves that
+//!     code to the end of the function, so the hot path falls through,
+//!   - marks other conditional jumps that are mostly taken as taken, which
+//!     makes the register allocator keep the state of the taken path,
+//!   - sets priorities of virtual registers by the hottest block they are
+//!     used in, so registers used only by cold code are spilled first.
+//!
+//! The pass is not added by default, it has to run before register allocation:
+//!
+//! ~~~
+//! uint64_t counters[256] = { 0 };
+//!
+//! // Instrumented compilation.
+//! X86Compiler cc(&code);
+//! cc.insertPass(0, cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeInstrument, counters, 256));
+//!
+//! // ... generate the code, run it ...
+//!
+//! // Compilation that uses the profile.
+//! X86Compiler cc(&code);
+//! cc.insertPass(0, cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeLayout, counters, 256));
+//! ~~~
+class ASMJIT_VIRTAPI X86ProfilePass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(X86ProfilePass)
+  typedef CBPass Base;
+
+  //! Mode of the pass.
+  ASMJIT_ENUM(Mode) {
+    kModeInstrument       = 0,           //!< Insert block counters.
+    kModeLayout           = 1            //!< Use block counters to lay out the code.
+  };
+
+  enum {
+    //! A block executed less than once per `kColdRatio` calls is cold.
+    kColdRatio = 16
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `X86ProfilePass` working in `mode` with `counterCount`
+  //! `counters`. Labels that have no counter are not instrumented and their
+  //! blocks are not moved.
+  ASMJIT_API X86ProfilePass(uint32_t mode, uint64_t* counters, uint32_t counterCount) noexcept;
+  ASMJIT_API virtual ~X86ProfilePass() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the mode of the pass, see \ref Mode.
+  ASMJIT_INLINE uint32_t getMode() const noexcept { return _mode; }
+  //! Get counters.
+  ASMJIT_INLINE uint64_t* getCounters() const noexcept { return _counters; }
+  //! Get the number of counters.
+  ASMJIT_INLINE uint32_t getCounterCount() const noexcept { return _counterCount; }
+
+  //! Get how many counters were inserted by the last `process()`.
+  ASMJIT_INLINE uint32_t getInstrumentedCount() const noexcept { return _instrumentedCount; }
+  //! Get how many blocks were moved by the last `process()`.
+  ASMJIT_INLINE uint32_t getMovedCount() const noexcept { return _movedCount; }
+  //! Get how many conditional jumps were inverted by the last `process()`.
+  ASMJIT_INLINE uint32_t getInvertedCount() const noexcept { return _invertedCount; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _mode;                        //!< Mode of the pass.
+  uint32_t _counterCount;                //!< Number of counters.
+  uint64_t* _counters;                   //!< Counters indexed by label ids.
+
+  uint32_t _instrumentedCount;           //!< Number of counters inserted by the last `process()`.
+  uint32_t _movedCount;                  //!< Number of blocks moved by the last `process()`.
+  uint32_t _invertedCount;               //!< Number of jumps inverted by the last `process()`.
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // !ASMJIT_DISABLE_COMPILER
+#endif // _ASMJIT_X86_X86PROFILE_H
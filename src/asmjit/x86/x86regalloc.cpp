@@ -194,7 +194,7 @@ Error X86RAPass::prepare(CCFunc* func) noexcept {
   _regCount._gp  = archType == ArchInfo::kTypeX86 ? 8 : 16;
   _regCount._mm  = 8;
   _regCount._k   = 8;
-  _regCount._vec = archType == ArchInfo::kTypeX86 ? 8 : 16;
+  _regCount._vec = archType == ArchInfo::kTypeX86 ? 8 : func->getFrameInfo().isAvx512Enabled() ? 32 : 16;
   _zsp = cc()->zsp();
   _zbp = cc()->zbp();
 
@@ -612,6 +612,7 @@ static ASMJIT_INLINE void X86RAPass_checkStateVars(X86RAPass* self) {
 void X86RAPass::_checkState() {
   X86RAPass_checkStateVars<X86Reg::kKindGp >(this);
   X86RAPass_checkStateVars<X86Reg::kKindMm >(this);
+  X86RAPass_checkStateVars<X86Reg::kKindK  >(this);
   X86RAPass_checkStateVars<X86Reg::kKindVec>(this);
 }
 #else
@@ -654,6 +655,7 @@ void X86RAPass::loadState(RAState* src_) {
   // Load allocated variables.
   X86RAPass_loadStateVars<X86Reg::kKindGp >(this, src);
   X86RAPass_loadStateVars<X86Reg::kKindMm >(this, src);
+  X86RAPass_loadStateVars<X86Reg::kKindK  >(this, src);
   X86RAPass_loadStateVars<X86Reg::kKindVec>(this, src);
 
   // Load masks.
@@ -836,6 +838,7 @@ void X86RAPass::switchState(RAState* src_) {
   // Switch variables.
   X86RAPass_switchStateVars<X86Reg::kKindGp >(this, src);
   X86RAPass_switchStateVars<X86Reg::kKindMm >(this, src);
+  X86RAPass_switchStateVars<X86Reg::kKindK  >(this, src);
   X86RAPass_switchStateVars<X86Reg::kKindVec>(this, src);
 
   // Calculate changed state.
@@ -970,6 +973,7 @@ void X86RAPass::intersectStates(RAState* a_, RAState* b_) {
 
   X86RAPass_intersectStateVars<X86Reg::kKindGp >(this, a, b);
   X86RAPass_intersectStateVars<X86Reg::kKindMm >(this, a, b);
+  X86RAPass_intersectStateVars<X86Reg::kKindK  >(this, a, b);
   X86RAPass_intersectStateVars<X86Reg::kKindVec>(this, a, b);
 
   ASMJIT_X86_CHECK_STATE
@@ -1000,13 +1004,15 @@ static ASMJIT_INLINE CBNode* X86RAPass_getOppositeJccFlow(CBJump* jNode) {
 // ============================================================================
 
 //! \internal
-static void X86RAPass_prepareSingleVarInst(uint32_t instId, TiedReg* tr) {
+static void X86RAPass_prepareSingleVarInst(uint32_t instId, const Operand* opArray, uint32_t opCount, TiedReg* tr) {
   switch (instId) {
     // - andn     reg, reg ; Set all bits in reg to 0.
     // - xor/pxor reg, reg ; Set all bits in reg to 0.
     // - sub/psub reg, reg ; Set all bits in reg to 0.
     // - pcmpgt   reg, reg ; Set all bits in reg to 0.
     // - pcmpeq   reg, reg ; Set all bits in reg to 1.
+    //
+    // VEX|EVEX forms have the same meaning if all operands are the same.
     case X86Inst::kIdPandn     :
     case X86Inst::kIdXor       : case X86Inst::kIdXorpd     : case X86Inst::kIdXorps     : case X86Inst::kIdPxor      :
     case X86Inst::kIdSub:
@@ -1014,9 +1020,24 @@ static void X86RAPass_prepareSingleVarInst(uint32_t instId, TiedReg* tr) {
     case X86Inst::kIdPsubsb    : case X86Inst::kIdPsubsw    : case X86Inst::kIdPsubusb   : case X86Inst::kIdPsubusw   :
     case X86Inst::kIdPcmpeqb   : case X86Inst::kIdPcmpeqw   : case X86Inst::kIdPcmpeqd   : case X86Inst::kIdPcmpeqq   :
     case X86Inst::kIdPcmpgtb   : case X86Inst::kIdPcmpgtw   : case X86Inst::kIdPcmpgtd   : case X86Inst::kIdPcmpgtq   :
+    case X86Inst::kIdVpandn    : case X86Inst::kIdVpandnd   : case X86Inst::kIdVpandnq   :
+    case X86Inst::kIdVxorpd    : case X86Inst::kIdVxorps    : case X86Inst::kIdVpxor     : case X86Inst::kIdVpxord    : case X86Inst::kIdVpxorq    :
+    case X86Inst::kIdVpsubb    : case X86Inst::kIdVpsubw    : case X86Inst::kIdVpsubd    : case X86Inst::kIdVpsubq    :
+    case X86Inst::kIdVpcmpeqb  : case X86Inst::kIdVpcmpeqw  : case X86Inst::kIdVpcmpeqd  : case X86Inst::kIdVpcmpeqq  :
+    case X86Inst::kIdVpcmpgtb  : case X86Inst::kIdVpcmpgtw  : case X86Inst::kIdVpcmpgtd  : case X86Inst::kIdVpcmpgtq  :
       tr->flags &= ~TiedReg::kRReg;
       break;
 
+    // - vpternlog reg, reg, reg, 0x00 ; Set all bits in reg to 0.
+    // - vpternlog reg, reg, reg, 0xFF ; Set all bits in reg to 1.
+    case X86Inst::kIdVpternlogd: case X86Inst::kIdVpternlogq:
+      if (opCount == 4 && opArray[3].isImm()) {
+        uint32_t imm = static_cast<const Imm&>(opArray[3]).getUInt8();
+        if (imm == 0x00 || imm == 0xFF)
+          tr->flags &= ~TiedReg::kRReg;
+      }
+      break;
+
     // - and      reg, reg ; Nop.
     // - or       reg, reg ; Nop.
     // - xchg     reg, reg ; Nop.
@@ -1256,6 +1277,11 @@ Error X86RAPass::fetch() {
   // Allowed index registers (GP/XMM/YMM).
   const uint32_t indexMask = Utils::bits(_regCount.getGp()) & ~(Utils::mask(4));
 
+  // Allowed XMM|YMM registers, registers 16-31 can only be used by EVEX
+  // encoded instructions and XMM|YMM registers require AVX512-VL for that.
+  const uint32_t vecLoMask = Utils::bits(16);
+  const uint32_t vecNarrowMask = func->getFrameInfo().isAvx512VLEnabled() ? 0xFFFFFFFFU : vecLoMask;
+
   // --------------------------------------------------------------------------
   // [VI Macros]
   // --------------------------------------------------------------------------
@@ -1310,6 +1336,9 @@ Error X86RAPass::fetch() {
         else \
           tied->allocableRegs &= ~inRegs.get(_kind); \
         \
+        if (_kind == X86Reg::kKindVec && vreg->getSize() < 64) \
+          tied->allocableRegs &= vecNarrowMask; \
+        \
         vreg->_tied = nullptr; \
         raData->setTiedAt(_index, *tied); \
         \
@@ -1502,6 +1531,14 @@ _NextGroup:
           if (commonData.hasFixedRM() && (special = X86SpecialInst_get(instId, opArray, opCount)) != nullptr)
             flags |= CBNode::kFlagIsSpecial;
 
+          // Legacy SSE and VEX-only instructions cannot encode registers 16-31,
+          // XMM|YMM forms of AVX-512 instructions require also AVX512-VL.
+          uint32_t vecAllowedMask = commonData.isEvex() ? 0xFFFFFFFFU : vecLoMask;
+          uint32_t vecNarrowAllowedMask = vecAllowedMask;
+
+          if (inst.getOperationData().hasFeature(CpuInfo::kX86FeatureAVX512_VL))
+            vecNarrowAllowedMask &= vecNarrowMask;
+
           for (uint32_t i = 0; i < opCount; i++) {
             Operand* op = &opArray[i];
             VirtReg* vreg;
@@ -1512,6 +1549,9 @@ _NextGroup:
               if (vreg->isFixed()) continue;
 
               RA_MERGE(vreg, tied, 0, gaRegs[vreg->getKind()] & gpAllowedMask);
+              if (vreg->getKind() == X86Reg::kKindVec)
+                tied->allocableRegs &= op->getSize() < 64 ? vecNarrowAllowedMask : vecAllowedMask;
+
               if (static_cast<X86Reg*>(op)->isGpb()) {
                 tied->flags |= static_cast<X86Gp*>(op)->isGpbLo() ? TiedReg::kX86GpbLo : TiedReg::kX86GpbHi;
                 if (archType == ArchInfo::kTypeX86) {
@@ -1713,9 +1753,10 @@ _NextGroup:
           node->setFlags(flags);
           if (tiedTotal) {
             // Handle instructions which result in zeros/ones or nop if used with the
-            // same destination and source operand.
-            if (tiedTotal == 1 && opCount >= 2 && opArray[0].isVirtReg() && opArray[1].isVirtReg() && !node->hasMemOp())
-              X86RAPass_prepareSingleVarInst(instId, &agTmp[0]);
+            // same destination and source operand. Not if masked, merge-masking
+            // keeps the masked-out elements of the destination.
+            if (tiedTotal == 1 && opCount >= 2 && opArray[0].isVirtReg() && opArray[1].isVirtReg() && !node->hasMemOp() && !node->hasExtraReg())
+              X86RAPass_prepareSingleVarInst(instId, opArray, opCount, &agTmp[0]);
           }
 
           // Turn on AVX if the instruction operates on XMM|YMM|ZMM registers and uses VEX|EVEX prefix.
@@ -1736,6 +1777,18 @@ _NextGroup:
               tied->flags |= TiedReg::kXReg;
             }
             else {
+              // AVX-512 {k} selector - 'k0' means no masking, so it can't be used.
+              if (vreg->getKind() == X86Reg::kKindK) {
+                tied->allocableRegs &= ~Utils::mask(0);
+
+                // Merge-masking keeps the masked-out elements of the destination,
+                // so it's read even if the instruction only writes it otherwise.
+                if (!(options & X86Inst::kOptionZMask) && opCount && opArray[0].isVirtReg() && cc()->isVirtRegValid(opArray[0].getId())) {
+                  VirtReg* dst = cc()->getVirtRegById(opArray[0].getId());
+                  if (dst->getKind() == X86Reg::kKindVec && dst->_tied)
+                    dst->_tied->flags |= TiedReg::kRReg;
+                }
+              }
               tied->flags |= TiedReg::kRReg;
             }
           }
@@ -1959,6 +2012,13 @@ _NextGroup:
         uint32_t sArgCount = 0;
         uint32_t gpAllocableMask = gaRegs[X86Reg::kKindGp] & ~node->getDetail().getUsedRegs(X86Reg::kKindGp);
 
+        // Prefer registers that are not restored by the frame teardown that
+        // precedes the jump to the callee of a tail call.
+        if (node->hasAttribute(CCFuncCall::kAttrTailCall)) {
+          uint32_t tailMask = gpAllocableMask & ~func->getDetail().getPreservedRegs(X86Reg::kKindGp);
+          if (tailMask) gpAllocableMask = tailMask;
+        }
+
         VirtReg* vreg;
         TiedReg* tied;
 
@@ -2093,6 +2153,87 @@ NoMem:
   return DebugUtils::errored(kErrorNoHeapMemory);
 }
 
+// ============================================================================
+// [asmjit::X86RAPass - Coalesce]
+// ============================================================================
+
+bool X86RAPass::isCopyInst(CBNode* node_, VirtReg** dst, VirtReg** src) {
+  if (node_->getType() != CBNode::kNodeInst)
+    return false;
+
+  CBInst* node = static_cast<CBInst*>(node_);
+  if (node->getOpCount() != 2 || node->hasExtraReg() || node->isSpecial())
+    return false;
+
+  switch (node->getInstId()) {
+    case X86Inst::kIdMov:
+    case X86Inst::kIdMovaps:
+    case X86Inst::kIdMovapd:
+    case X86Inst::kIdMovdqa:
+    case X86Inst::kIdMovups:
+    case X86Inst::kIdMovupd:
+    case X86Inst::kIdMovdqu:
+    case X86Inst::kIdVmovaps:
+    case X86Inst::kIdVmovapd:
+    case X86Inst::kIdVmovdqa:
+    case X86Inst::kIdVmovups:
+    case X86Inst::kIdVmovupd:
+    case X86Inst::kIdVmovdqu:
+      break;
+
+    default:
+      return false;
+  }
+
+  Operand* opArray = node->getOpArray();
+  if (!opArray[0].isVirtReg() || !opArray[1].isVirtReg())
+    return false;
+
+  X86Compiler* cc = this->cc();
+  VirtReg* dReg = cc->getVirtRegById(opArray[0].getId());
+  VirtReg* sReg = cc->getVirtRegById(opArray[1].getId());
+
+  // Only full copies between registers of the same type can be coalesced,
+  // partial moves like `mov v2.r32(), v1.r32()` of 64-bit registers change
+  // the value.
+  uint32_t signature = dReg->getSignature();
+  if (opArray[0].getSignature() != signature ||
+      opArray[1].getSignature() != signature ||
+      sReg->getSignature() != signature ||
+      sReg->getTypeId() != dReg->getTypeId())
+    return false;
+
+  if (dReg->isFixed() || dReg->isStack() || sReg->isFixed() || sReg->isStack())
+    return false;
+
+  // The copy must not carry any register constraints.
+  X86RAData* raData = node->getPassData<X86RAData>();
+  if (raData->tiedTotal != 2 || !raData->inRegs.isEmpty() || !raData->outRegs.isEmpty())
+    return false;
+
+  // A copy that became `mov v1, v1` after a previous coalescing still has
+  // two `TiedReg`s, both referring to the same virtual register.
+  uint32_t allFlags = 0;
+  for (uint32_t i = 0; i < 2; i++) {
+    TiedReg* tied = raData->getTiedAt(i);
+    uint32_t flags = tied->flags & (TiedReg::kRAll | TiedReg::kWAll);
+
+    if (flags != (tied->vreg == dReg ? uint32_t(TiedReg::kWReg) : uint32_t(TiedReg::kRReg)) && dReg != sReg)
+      return false;
+
+    if (tied->inRegs != 0 || tied->outPhysId != Globals::kInvalidRegId)
+      return false;
+    allFlags |= flags;
+  }
+
+  if (allFlags != (TiedReg::kRReg | TiedReg::kWReg))
+    return false;
+
+  *dst = dReg;
+  *src = sReg;
+  return true;
+}
+
 // ============================================================================
 // [asmjit::X86RAPass - Annotate]
 // ============================================================================
@@ -2368,6 +2509,11 @@ protected:
   template<int C>
   ASMJIT_INLINE uint32_t guessSpill(VirtReg* vreg, uint32_t allocableRegs);
 
+  //! Get registers from `occupiedRegs` that hold virtual registers of the
+  //! lowest priority, which are spilled first (see `VirtReg::getPriority()`).
+  template<int C>
+  ASMJIT_INLINE uint32_t guessEvict(uint32_t occupiedRegs);
+
   // --------------------------------------------------------------------------
   // [Modified]
   // --------------------------------------------------------------------------
@@ -2399,22 +2545,26 @@ Error X86VarAlloc::run(CBNode* node_) {
     // Unuse overwritten variables.
     unuseBefore<X86Reg::kKindGp>();
     unuseBefore<X86Reg::kKindMm>();
+    unuseBefore<X86Reg::kKindK>();
     unuseBefore<X86Reg::kKindVec>();
 
     // Plan the allocation. Planner assigns input/output registers for each
     // variable and decides whether to allocate it in register or stack.
     plan<X86Reg::kKindGp>();
     plan<X86Reg::kKindMm>();
+    plan<X86Reg::kKindK>();
     plan<X86Reg::kKindVec>();
 
     // Spill all variables marked by plan().
     spill<X86Reg::kKindGp>();
     spill<X86Reg::kKindMm>();
+    spill<X86Reg::kKindK>();
     spill<X86Reg::kKindVec>();
 
     // Alloc all variables marked by plan().
     alloc<X86Reg::kKindGp>();
     alloc<X86Reg::kKindMm>();
+    alloc<X86Reg::kKindK>();
     alloc<X86Reg::kKindVec>();
 
     // Translate node operands.
@@ -2472,6 +2622,7 @@ Error X86VarAlloc::run(CBNode* node_) {
     // Mark variables as modified.
     modified<X86Reg::kKindGp>();
     modified<X86Reg::kKindMm>();
+    modified<X86Reg::kKindK>();
     modified<X86Reg::kKindVec>();
 
     // Cleanup; disconnect Vd->Va.
@@ -2488,6 +2639,7 @@ Error X86VarAlloc::run(CBNode* node_) {
   if (raData->tiedTotal != 0) {
     unuseAfter<X86Reg::kKindGp>();
     unuseAfter<X86Reg::kKindMm>();
+    unuseAfter<X86Reg::kKindK>();
     unuseAfter<X86Reg::kKindVec>();
   }
 
@@ -2676,6 +2828,7 @@ ASMJIT_INLINE void X86VarAlloc::plan() {
         candidateRegs = m & occupied & ~state->_modified.get(C);
         if (candidateRegs == 0)
           candidateRegs = m;
+        candidateRegs = guessEvict<C>(candidateRegs);
       }
       if (candidateRegs & homeMask) candidateRegs &= homeMask;
 
@@ -2935,6 +3088,34 @@ ASMJIT_INLINE uint32_t X86VarAlloc::guessSpill(VirtReg* vreg, uint32_t allocable
   return 0;
 }
 
+template<int C>
+ASMJIT_INLINE uint32_t X86VarAlloc::guessEvict(uint32_t occupiedRegs) {
+  VirtReg** vregs = getState()->getListByKind(C);
+
+  uint32_t m = occupiedRegs;
+  uint32_t lowestRegs = 0;
+  uint32_t lowestPriority = 0xFFFFFFFFU;
+
+  while (m) {
+    uint32_t physId = Utils::findFirstBit(m);
+    uint32_t regMask = Utils::mask(physId);
+    m ^= regMask;
+
+    VirtReg* vreg = vregs[physId];
+    uint32_t priority = vreg ? vreg->getPriority() : 0;
+
+    if (priority < lowestPriority) {
+      lowestPriority = priority;
+      lowestRegs = 0;
+    }
+
+    if (priority == lowestPriority)
+      lowestRegs |= regMask;
+  }
+
+  return lowestRegs;
+}
+
 // ============================================================================
 // [asmjit::X86VarAlloc - Modified]
 // ============================================================================
@@ -3075,22 +3256,26 @@ Error X86CallAlloc::run(CCFuncCall* node) {
   // variable. If any variable is used multiple times it will be handled later.
   plan<X86Reg::kKindGp >();
   plan<X86Reg::kKindMm >();
+  plan<X86Reg::kKindK  >();
   plan<X86Reg::kKindVec>();
 
   // Spill.
   spill<X86Reg::kKindGp >();
   spill<X86Reg::kKindMm >();
+  spill<X86Reg::kKindK  >();
   spill<X86Reg::kKindVec>();
 
   // Alloc.
   alloc<X86Reg::kKindGp >();
   alloc<X86Reg::kKindMm >();
+  alloc<X86Reg::kKindK  >();
   alloc<X86Reg::kKindVec>();
 
   // Unuse clobbered registers that are not used to pass function arguments and
   // save variables used to pass function arguments that will be reused later on.
   save<X86Reg::kKindGp >();
   save<X86Reg::kKindMm >();
+  save<X86Reg::kKindK  >();
   save<X86Reg::kKindVec>();
 
   // Allocate immediates in registers and on the stack.
@@ -3099,6 +3284,7 @@ Error X86CallAlloc::run(CCFuncCall* node) {
   // Duplicate.
   duplicate<X86Reg::kKindGp >();
   duplicate<X86Reg::kKindMm >();
+  duplicate<X86Reg::kKindK  >();
   duplicate<X86Reg::kKindVec>();
 
   // Translate call operand.
@@ -3115,6 +3301,7 @@ Error X86CallAlloc::run(CCFuncCall* node) {
   // Clobber.
   clobber<X86Reg::kKindGp >();
   clobber<X86Reg::kKindMm >();
+  clobber<X86Reg::kKindK  >();
   clobber<X86Reg::kKindVec>();
 
   // Return.
@@ -3123,6 +3310,7 @@ Error X86CallAlloc::run(CCFuncCall* node) {
   // Unuse.
   unuseAfter<X86Reg::kKindGp >();
   unuseAfter<X86Reg::kKindMm >();
+  unuseAfter<X86Reg::kKindK  >();
   unuseAfter<X86Reg::kKindVec>();
 
   // Cleanup; disconnect Vd->Va.
@@ -3640,7 +3828,12 @@ static Error X86RAPass_translateOperands(X86RAPass* self, Operand_* opArray, uin
         VirtReg* vreg = cc->getVirtRegById(m->getBaseId());
 
         if (m->isRegHome()) {
-          self->getVarCell(vreg);
+          // The home slot is addressed explicitly, its content can be used
+          // anywhere in the function, so it cannot be shared.
+          RACell* cell = self->getVarCell(vreg);
+          if (ASMJIT_UNLIKELY(!cell))
+            return DebugUtils::errored(kErrorNoHeapMemory);
+          cell->makeFixed();
         }
         else {
           ASMJIT_ASSERT(vreg->getPhysId() != Globals::kInvalidRegId);
@@ -3658,6 +3851,177 @@ static Error X86RAPass_translateOperands(X86RAPass* self, Operand_* opArray, uin
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::X86RAPass - PromoteToVex]
+// ============================================================================
+
+#if !defined(ASMJIT_DISABLE_TEXT) && !defined(ASMJIT_DISABLE_VALIDATION)
+//! \internal
+//!
+//! Get the VEX instruction that corresponds to the SSE instruction `instId`,
+//! it's the instruction having the same name prefixed by 'v'.
+static uint32_t X86RAPass_getVexInstId(uint32_t instId) noexcept {
+  const char* name = X86Inst::getNameById(instId);
+  size_t len = ::strlen(name);
+
+  char vexName[32];
+  if (len + 1 >= ASMJIT_ARRAY_SIZE(vexName))
+    return Inst::kIdNone;
+
+  vexName[0] = 'v';
+  ::memcpy(vexName + 1, name, len);
+
+  uint32_t vexId = X86Inst::getIdByName(vexName, len + 1);
+  if (vexId == Inst::kIdNone || !X86Inst::getInst(vexId).getCommonData().isVex())
+    return Inst::kIdNone;
+  return vexId;
+}
+
+//! \internal
+//!
+//! Get whether `node` is a full XMM register to register move.
+static ASMJIT_INLINE bool X86RAPass_isVexXmmMove(const CBNode* node_) noexcept {
+  if (node_->getType() != CBNode::kNodeInst)
+    return false;
+
+  const CBInst* node = static_cast<const CBInst*>(node_);
+  if (node->getOpCount() != 2 || node->hasExtraReg() || node->isSpecial())
+    return false;
+
+  switch (node->getInstId()) {
+    case X86Inst::kIdVmovaps:
+    case X86Inst::kIdVmovapd:
+    case X86Inst::kIdVmovdqa:
+    case X86Inst::kIdVmovups:
+    case X86Inst::kIdVmovupd:
+    case X86Inst::kIdVmovdqu:
+      return X86Reg::isXmm(node->getOpArray()[0]) && X86Reg::isXmm(node->getOpArray()[1]);
+
+    default:
+      return false;
+  }
+}
+
+//! \internal
+//!
+//! Validate VEX instruction `vexId` having operands `opArray`.
+static ASMJIT_INLINE bool X86RAPass_validateVex(uint32_t archType, uint32_t vexId, uint32_t options, const Operand* opArray, uint32_t opCount) noexcept {
+  Inst::Detail detail(vexId, options);
+  return Inst::validate(archType, detail, opArray, opCount) == kErrorOk;
+}
+
+//! \internal
+//!
+//! Get whether `node` uses a virtual register wider than XMM. VEX encoded
+//! XMM instructions zero bits 255:128 (or 511:128) of the register, which
+//! legacy SSE instructions preserve, so SSE instructions that access a view
+//! of a YMM|ZMM virtual register can't be promoted.
+static ASMJIT_INLINE bool X86RAPass_usesWideVec(const CBNode* node) noexcept {
+  if (!node->hasPassData())
+    return false;
+
+  const X86RAData* raData = node->getPassData<X86RAData>();
+  for (uint32_t i = 0; i < raData->tiedTotal; i++) {
+    const VirtReg* vreg = raData->getTiedAt(i)->vreg;
+    if (vreg->getKind() == X86Reg::kKindVec && vreg->getSize() > 16)
+      return true;
+  }
+  return false;
+}
+
+//! \internal
+//!
+//! Re-encode SSE instructions of `func` as their VEX equivalents. Destructive
+//! two-operand forms become non-destructive three-operand forms, and a copy
+//! that precedes such instruction is folded into it:
+//!
+//! ~~~
+//! movaps xmm1, xmm0    ->  vaddps xmm1, xmm0, xmm2
+//! addps xmm1, xmm2
+//! ~~~
+static Error X86RAPass_promoteToVex(X86RAPass* self, CCFunc* func, CBNode* stop) {
+  X86Compiler* cc = self->cc();
+  uint32_t archType = cc->getArchType();
+
+  // Maps SSE instruction id to VEX instruction id, `kIdNone` means the VEX
+  // id has not been resolved yet, `_kIdCount` that there is no VEX equivalent.
+  uint16_t* vexMap = self->_zone->allocZeroedT<uint16_t>(X86Inst::_kIdCount * sizeof(uint16_t));
+  if (ASMJIT_UNLIKELY(!vexMap))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  CBNode* node_ = func;
+  do {
+    if (node_->getType() != CBNode::kNodeInst)
+      continue;
+
+    CBInst* node = static_cast<CBInst*>(node_);
+    uint32_t instId = node->getInstId();
+
+    if (node->hasExtraReg() || node->isSpecial() || !X86Inst::getInst(instId).getCommonData().isSse())
+      continue;
+
+    if (X86RAPass_usesWideVec(node))
+      continue;
+
+    uint32_t vexId = vexMap[instId];
+    if (vexId == Inst::kIdNone) {
+      vexId = X86RAPass_getVexInstId(instId);
+      vexMap[instId] = static_cast<uint16_t>(vexId ? vexId : static_cast<uint32_t>(X86Inst::_kIdCount));
+    }
+
+    uint32_t opCount = node->getOpCount();
+    if (vexId == Inst::kIdNone || vexId == X86Inst::_kIdCount || opCount == 0 || opCount > 4)
+      continue;
+
+    uint32_t options = node->getOptions();
+    Operand* opArray = node->getOpArray();
+    Operand vexOps[5];
+    uint32_t i;
+
+    // Try the non-destructive form first, it's only valid for instructions
+    // that read their destination in SSE form (the destination is repeated).
+    if (opArray[0].isReg()) {
+      vexOps[0].copyFrom(opArray[0]);
+      for (i = 0; i < opCount; i++)
+        vexOps[i + 1].copyFrom(opArray[i]);
+
+      if (X86RAPass_validateVex(archType, vexId, options, vexOps, opCount + 1)) {
+        Operand* newArray = cc->_cbHeap.allocT<Operand>((opCount + 1) * sizeof(Operand));
+        if (ASMJIT_UNLIKELY(!newArray))
+          return DebugUtils::errored(kErrorNoHeapMemory);
+
+        // Fold a preceding copy to the destination.
+        CBNode* prev = node->getPrev();
+        if (X86RAPass_isVexXmmMove(prev) && !X86RAPass_usesWideVec(prev)) {
+          const Operand* moveOps = static_cast<CBInst*>(prev)->getOpArray();
+          if (moveOps[0].isEqual(vexOps[0])) {
+            for (i = 1; i <= opCount; i++)
+              if (vexOps[i].isEqual(moveOps[0]))
+                vexOps[i].copyFrom(moveOps[1]);
+            cc->removeNode(prev);
+          }
+        }
+
+        for (i = 0; i <= opCount; i++)
+          newArray[i].copyFrom(vexOps[i]);
+
+        node->setInstId(vexId);
+        node->_opArray = newArray;
+        node->_opCount = static_cast<uint8_t>(opCount + 1);
+        node->_updateMemOp();
+        continue;
+      }
+    }
+
+    // Same operands, only the encoding changes.
+    if (X86RAPass_validateVex(archType, vexId, options, opArray, opCount))
+      node->setInstId(vexId);
+  } while ((node_ = node_->getNext()) != stop);
+
+  return kErrorOk;
+}
+#endif // !ASMJIT_DISABLE_TEXT && !ASMJIT_DISABLE_VALIDATION
+
 // ============================================================================
 // [asmjit::X86RAPass - TranslatePrologEpilog]
 // ============================================================================
@@ -3828,6 +4192,87 @@ _EmitRet:
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::X86RAPass - Translate - TailCall]
+// ============================================================================
+
+//! \internal
+//!
+//! Get whether `call` is in a tail position of `func` - only the translated
+//! return (that didn't emit any instruction) followed by the exit node or a
+//! jump to it can follow the call.
+static bool X86RAPass_isTailPosition(CCFunc* func, CCFuncCall* call) {
+  CBLabel* exitNode = func->getExitNode();
+  CBNode* node = call->getNext();
+
+  while (node != exitNode) {
+    if (!node) return false;
+
+    switch (node->getType()) {
+      case CBNode::kNodeAlign:
+      case CBNode::kNodeComment:
+      case CBNode::kNodeHint:
+      case CBNode::kNodeLabel:
+      case CBNode::kNodeFuncExit:
+        break;
+
+      case CBNode::kNodeInst:
+        return node->isJmp() && static_cast<CBJump*>(node)->getTarget() == exitNode;
+
+      default:
+        return false;
+    }
+
+    node = node->getNext();
+  }
+
+  return true;
+}
+
+//! \internal
+//!
+//! Translate `call` marked by `CCFuncCall::kAttrTailCall` into a frame teardown
+//! followed by a jump to the callee. The call is kept if it's not possible.
+static Error X86RAPass_translateTailCall(X86RAPass* self, CCFunc* func, CCFuncCall* call, const FuncFrameLayout& layout) {
+  X86Compiler* cc = self->cc();
+  const FuncDetail& fd = call->getDetail();
+
+  // The callee would need its stack arguments in the caller's argument area
+  // and would have to release the same amount of stack as the caller.
+  if (fd.getArgStackSize() != 0 || layout.hasCalleeStackCleanup())
+    return kErrorOk;
+
+  // Arguments must not be passed in registers restored by the teardown.
+  if ((fd.getUsedRegs(X86Reg::kKindGp ) & layout.getSavedRegs(X86Reg::kKindGp )) != 0 ||
+      (fd.getUsedRegs(X86Reg::kKindVec) & layout.getSavedRegs(X86Reg::kKindVec)) != 0)
+    return kErrorOk;
+
+  // The target must be reachable after the teardown.
+  uint32_t unusableRegs = layout.getSavedRegs(X86Reg::kKindGp) | Utils::mask(X86Gp::kIdSp);
+  const Operand& target = call->getTarget();
+
+  if (target.isReg()) {
+    if ((unusableRegs & Utils::mask(target.getId())) != 0)
+      return kErrorOk;
+  }
+  else if (target.isMem()) {
+    const X86Mem& m = target.as<X86Mem>();
+    if ((m.hasBaseReg() && (unusableRegs & Utils::mask(m.getBaseId())) != 0) ||
+        (m.hasIndexReg() && (unusableRegs & Utils::mask(m.getIndexId())) != 0))
+      return kErrorOk;
+  }
+
+  if (!X86RAPass_isTailPosition(func, call))
+    return kErrorOk;
+
+  CBNode* prevCursor = cc->setCursor(call->getPrev());
+  ASMJIT_PROPAGATE(X86Internal::emitFrameTeardown(static_cast<X86Emitter*>(static_cast<CodeEmitter*>(cc)), layout));
+  cc->setCursor(prevCursor);
+
+  call->setInstId(X86Inst::kIdJmp);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::X86RAPass - Translate - Func]
 // ============================================================================
@@ -3852,6 +4297,7 @@ Error X86RAPass::translate() {
       // Switch state if we went to a node that is already translated.
       if (node_->getType() == CBNode::kNodeLabel) {
         CBLabel* node = static_cast<CBLabel*>(node_);
+        _flowPosition = node->getPosition();
         cc->_setCursor(node->getPrev());
         switchState(node->getPassData<RAData>()->state);
       }
@@ -3863,6 +4309,7 @@ _NextGroup:
       else {
         node_ = jLink->getValue();
         jLink = jLink->getNext();
+        _flowPosition = node_->getPosition();
 
         CBNode* jFlow = X86RAPass_getOppositeJccFlow(static_cast<CBJump*>(node_));
         loadState(node_->getPassData<RAData>()->state);
@@ -3884,6 +4331,7 @@ _NextGroup:
 
     next = node_->getNext();
     node_->_flags |= CBNode::kFlagIsTranslated;
+    _flowPosition = node_->getPosition();
 
     if (node_->hasPassData()) {
       switch (node_->getType()) {
@@ -4035,6 +4483,22 @@ _Done:
     ASMJIT_PROPAGATE(resolveCellOffsets());
     ASMJIT_PROPAGATE(X86RAPass_prepareFuncFrame(this, func));
 
+#if !defined(ASMJIT_DISABLE_TEXT) && !defined(ASMJIT_DISABLE_VALIDATION)
+    if (func->getFrameInfo().isVexPromotionEnabled())
+      ASMJIT_PROPAGATE(X86RAPass_promoteToVex(this, func, stop));
+#endif // !ASMJIT_DISABLE_TEXT && !ASMJIT_DISABLE_VALIDATION
+
+    if (_emitComments && _memVarShared < _memVarTotal) {
+      _stringBuilder.setFormat("[Frame] Spill area reduced from %u to %u bytes by sharing home slots",
+        static_cast<unsigned int>(_memVarTotal),
+        static_cast<unsigned int>(_memVarShared));
+
+      CBComment* comment = cc->newCommentNode(_stringBuilder.getData(), _stringBuilder.getLength());
+      if (ASMJIT_UNLIKELY(!comment))
+        return DebugUtils::errored(kErrorNoHeapMemory);
+      cc->addAfter(comment, func);
+    }
+
     FuncFrameLayout layout;
     ASMJIT_PROPAGATE(layout.init(func->getDetail(), func->getFrameInfo()));
 
@@ -4048,6 +4512,14 @@ _Done:
 
     cc->_setCursor(func->getExitNode());
     ASMJIT_PROPAGATE(FuncUtils::emitEpilog(this->cc(), layout));
+
+    for (node_ = func; node_ != stop; node_ = node_->getNext()) {
+      if (node_->getType() == CBNode::kNodeFuncCall) {
+        CCFuncCall* call = static_cast<CCFuncCall*>(node_);
+        if (call->hasAttribute(CCFuncCall::kAttrTailCall))
+          ASMJIT_PROPAGATE(X86RAPass_translateTailCall(this, func, call, layout));
+      }
+    }
   }
 
   return kErrorOk;
@@ -189,10 +189,15 @@ struct X86RAState : RAState {
     //! Count of Mm registers.
     kMmCount = 8,
 
+    //! Base index of K registers.
+    kKIndex = kMmIndex + kMmCount,
+    //! Count of K registers.
+    kKCount = 8,
+
     //! Base index of XMM registers.
-    kXmmIndex = kMmIndex + kMmCount,
-    //! Count of XMM registers.
-    kXmmCount = 16,
+    kXmmIndex = kKIndex + kKCount,
+    //! Count of XMM registers (32 if AVX-512 is enabled).
+    kXmmCount = 32,
 
     //! Count of all registers in `X86RAState`.
     kAllCount = kXmmIndex + kXmmCount
@@ -210,6 +215,7 @@ struct X86RAState : RAState {
     switch (kind) {
       case X86Reg::kKindGp : return _listGp;
       case X86Reg::kKindMm : return _listMm;
+      case X86Reg::kKindK  : return _listK;
       case X86Reg::kKindVec: return _listXmm;
 
       default:
@@ -240,6 +246,8 @@ struct X86RAState : RAState {
       VirtReg* _listGp[kGpCount];
       //! Allocated MMX registers.
       VirtReg* _listMm[kMmCount];
+      //! Allocated K registers.
+      VirtReg* _listK[kKCount];
       //! Allocated XMM registers.
       VirtReg* _listXmm[kXmmCount];
     };
@@ -651,6 +659,12 @@ public:
 
   virtual Error fetch() override;
 
+  // --------------------------------------------------------------------------
+  // [Coalesce]
+  // --------------------------------------------------------------------------
+
+  virtual bool isCopyInst(CBNode* node, VirtReg** dst, VirtReg** src) override;
+
   // --------------------------------------------------------------------------
   // [Annotate]
   // --------------------------------------------------------------------------
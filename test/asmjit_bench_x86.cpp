@@ -21,6 +21,53 @@ using namespace asmjit;
 
 static const uint32_t kNumRepeats = 10;
 static const uint32_t kNumIterations = 5000;
+static const uint32_t kNumConstants = 100000;
+static const uint32_t kNumVirtRegs = 5000;
+static const uint32_t kNumNamedLabels = 100000;
+
+// ============================================================================
+// [Malloc Counter]
+// ============================================================================
+
+// Count calls to `malloc()` and `realloc()` made by the benchmark and AsmJit
+// by interposing them, only possible with glibc.
+#if defined(__GLIBC__)
+# define ASMJIT_BENCH_MALLOC_COUNT
+static size_t mallocCount;
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+
+extern "C" void* malloc(size_t size) { mallocCount++; return __libc_malloc(size); }
+extern "C" void* realloc(void* p, size_t size) { mallocCount++; return __libc_realloc(p, size); }
+extern "C" void* calloc(size_t n, size_t size) { mallocCount++; return __libc_calloc(n, size); }
+#endif // __GLIBC__
+
+struct MallocCounter {
+  inline void start() { count = now(); }
+  inline void end() { count = now() - count; }
+
+  static inline size_t now() {
+#if defined(ASMJIT_BENCH_MALLOC_COUNT)
+    return mallocCount;
+#else
+    return 0;
+#endif
+  }
+
+  // Get the number of `malloc()` calls per `n` iterations as a string.
+  inline const char* perIteration(char* buf, uint32_t n) const {
+#if defined(ASMJIT_BENCH_MALLOC_COUNT)
+    sprintf(buf, "%.2f", static_cast<double>(count) / static_cast<double>(n));
+#else
+    sprintf(buf, "N/A");
+#endif
+    return buf;
+  }
+
+  size_t count;
+};
 
 // ============================================================================
 // [Performance]
@@ -57,14 +104,158 @@ static double mbps(uint32_t time, size_t outputSize) {
   return (bytesTotal * 1000) / (static_cast<double>(time) * 1024 * 1024);
 }
 
+// ============================================================================
+// [Bench - ConstPool]
+// ============================================================================
+
+static void benchConstPool() {
+  Zone zone(32768 - Zone::kZoneOverhead);
+  Performance perf;
+
+  uint32_t r, i;
+  size_t poolSize = 0;
+
+  // Constants of 4, 8, 16 and 32 bytes picked from `kNumConstants / 4`
+  // distinct values, so roughly 3 of 4 constants added are duplicates (like
+  // masks and coefficients that are used over and over by SIMD kernels).
+  uint32_t distinct = kNumConstants / 4;
+  Data256 data;
+
+  perf.reset();
+  for (r = 0; r < kNumRepeats; r++) {
+    ConstPool pool(&zone);
+    uint32_t seed = 0x12345678;
+
+    perf.start();
+    for (i = 0; i < kNumConstants; i++) {
+      seed = seed * 1103515245 + 12345;
+
+      uint32_t value = (seed >> 8) % distinct;
+      uint32_t size = 4U << (value & 3);
+
+      data.setU32(value * 0x9E3779B1U);
+      data.ud[0] = value;
+
+      size_t offset;
+      pool.add(&data, size, offset);
+    }
+    perf.end();
+
+    poolSize = pool.getSize();
+    zone.reset();
+  }
+
+  printf("%-12s (%s) | Time: %-6u [ms] | Size: %u [kB] | Constants: %u\n",
+    "ConstPool", "Any", perf.best, static_cast<unsigned int>(poolSize / 1024), kNumConstants);
+}
+
+// ============================================================================
+// [Bench - Named Labels]
+// ============================================================================
+
+static void benchNamedLabels() {
+  Performance perfNew;
+  Performance perfGet;
+
+  uint32_t r, i;
+  uint32_t found = 0;
+  char name[32];
+
+  perfNew.reset();
+  perfGet.reset();
+
+  for (r = 0; r < kNumRepeats; r++) {
+    CodeHolder code;
+    code.init(CodeInfo(ArchInfo::kTypeHost));
+
+    perfNew.start();
+    for (i = 0; i < kNumNamedLabels; i++) {
+      uint32_t id;
+      size_t nameLength = static_cast<size_t>(snprintf(name, ASMJIT_ARRAY_SIZE(name), "L_Block%u", i));
+      code.newNamedLabelId(id, name, nameLength, Label::kTypeGlobal, 0);
+    }
+    perfNew.end();
+
+    // Look up the labels in a different order than they were created.
+    found = 0;
+    perfGet.start();
+    for (i = 0; i < kNumNamedLabels; i++) {
+      uint32_t index = (i * 7919U) % kNumNamedLabels;
+      size_t nameLength = static_cast<size_t>(snprintf(name, ASMJIT_ARRAY_SIZE(name), "L_Block%u", index));
+      found += code.getLabelIdByName(name, nameLength) != 0;
+    }
+    perfGet.end();
+  }
+
+  printf("%-12s (%s) | Time: %-6u [ms] | Labels: %u | Op: New\n",
+    "NamedLabels", "Any", perfNew.best, kNumNamedLabels);
+  printf("%-12s (%s) | Time: %-6u [ms] | Labels: %u | Op: Get (Found %u)\n",
+    "NamedLabels", "Any", perfGet.best, kNumNamedLabels, found);
+}
+
 // ============================================================================
 // [Main]
 // ============================================================================
 
 #if defined(ASMJIT_BUILD_X86)
+// NOTE: Since we don't have JitRuntime we don't know anything about function
+// calling conventions, which is required by generateAlphaBlend. So we must
+// setup this manually.
+static CodeInfo makeCodeInfo(uint32_t archType) {
+  CodeInfo ci(archType);
+  ci.setCdeclCallConv(archType == ArchInfo::kTypeX86 ? CallConv::kIdX86CDecl : CallConv::kIdX86SysV64);
+  return ci;
+}
+
+// Generate a loop that defines `count` virtual registers, each one used by
+// the next one and by the one defined 16 registers later, with a conditional
+// block every 64 registers. Liveness of such function is expensive as its
+// bit arrays have `count / 64` words and the loop requires more passes.
+static void generateManyVRegs(X86Compiler& cc, uint32_t count) {
+  X86Gp acc = cc.newInt32("acc");
+  X86Gp n = cc.newInt32("n");
+  X86Gp* v = static_cast<X86Gp*>(::malloc(count * sizeof(X86Gp)));
+
+  Label L_Loop = cc.newLabel();
+
+  cc.addFunc(FuncSignature1<int, int>(cc.getCodeInfo().getCdeclCallConv()));
+  cc.setArg(0, acc);
+  cc.mov(n, 2);
+
+  cc.bind(L_Loop);
+  for (uint32_t i = 0; i < count; i++) {
+    v[i] = cc.newInt32();
+    if (i < 16) {
+      cc.mov(v[i], static_cast<int>(i));
+    }
+    else {
+      cc.mov(v[i], v[i - 1]);
+      cc.add(v[i], v[i - 16]);
+    }
+
+    if ((i & 63) == 63) {
+      Label L_Skip = cc.newLabel();
+      cc.test(v[i], 1);
+      cc.jz(L_Skip);
+      cc.add(acc, v[i]);
+      cc.bind(L_Skip);
+    }
+  }
+  cc.add(acc, v[count - 1]);
+  cc.dec(n);
+  cc.jnz(L_Loop);
+
+  cc.ret(acc);
+  cc.endFunc();
+
+  ::free(v);
+}
+
 static void benchX86(uint32_t archType) {
   CodeHolder code;
   Performance perf;
+  MallocCounter mc;
+  char mcBuf[32];
 
   X86Assembler a;
   X86Compiler cc;
@@ -83,6 +274,7 @@ static void benchX86(uint32_t archType) {
   for (r = 0; r < kNumRepeats; r++) {
     asmOutputSize = 0;
     perf.start();
+    mc.start();
     for (i = 0; i < kNumIterations; i++) {
       code.init(CodeInfo(archType));
       code.attach(&a);
@@ -92,11 +284,13 @@ static void benchX86(uint32_t archType) {
 
       code.reset(false); // Detaches `a`.
     }
+    mc.end();
     perf.end();
   }
 
-  printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s]\n",
-    "X86Assembler", archName, perf.best, mbps(perf.best, asmOutputSize));
+  printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s] | Malloc: %s\n",
+    "X86Assembler", archName, perf.best, mbps(perf.best, asmOutputSize),
+    mc.perIteration(mcBuf, kNumIterations));
 
   // --------------------------------------------------------------------------
   // [Bench - CodeBuilder]
@@ -112,14 +306,9 @@ static void benchX86(uint32_t archType) {
   for (r = 0; r < kNumRepeats; r++) {
     cmpOutputSize = 0;
     perf.start();
+    mc.start();
     for (i = 0; i < kNumIterations; i++) {
-      // NOTE: Since we don't have JitRuntime we don't know anything about
-      // function calling conventions, which is required by generateAlphaBlend.
-      // So we must setup this manually.
-      CodeInfo ci(archType);
-      ci.setCdeclCallConv(archType == ArchInfo::kTypeX86 ? CallConv::kIdX86CDecl : CallConv::kIdX86SysV64);
-
-      code.init(ci);
+      code.init(makeCodeInfo(archType));
       code.attach(&cc);
 
       asmtest::generateAlphaBlend(cc);
@@ -128,15 +317,82 @@ static void benchX86(uint32_t archType) {
 
       code.reset(false); // Detaches `cc`.
     }
+    mc.end();
     perf.end();
   }
 
-  printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s]\n",
-    "X86Compiler", archName, perf.best, mbps(perf.best, cmpOutputSize));
+  printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s] | Malloc: %s\n",
+    "X86Compiler", archName, perf.best, mbps(perf.best, cmpOutputSize),
+    mc.perIteration(mcBuf, kNumIterations));
+
+  // --------------------------------------------------------------------------
+  // [Bench - CodeCompiler (New CodeHolder and X86Compiler per Function)]
+  // --------------------------------------------------------------------------
+
+  for (uint32_t useCache = 0; useCache <= 1; useCache++) {
+    ZoneBlockCache cache;
+
+    perf.reset();
+    for (r = 0; r < kNumRepeats; r++) {
+      cmpOutputSize = 0;
+      perf.start();
+      mc.start();
+      for (i = 0; i < kNumIterations; i++) {
+        CodeHolder fnCode;
+        if (useCache)
+          fnCode.setBlockCache(&cache);
+        fnCode.init(makeCodeInfo(archType));
+
+        X86Compiler fnCC(&fnCode);
+        asmtest::generateAlphaBlend(fnCC);
+        fnCC.finalize();
+        cmpOutputSize += fnCode.getCodeSize();
+      }
+      mc.end();
+      perf.end();
+    }
+
+    printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s] | Malloc: %s | New Per Function, Cache: %s\n",
+      "X86Compiler", archName, perf.best, mbps(perf.best, cmpOutputSize),
+      mc.perIteration(mcBuf, kNumIterations),
+      useCache ? "On" : "Off");
+  }
+
+  // --------------------------------------------------------------------------
+  // [Bench - CodeCompiler (Many Virtual Registers)]
+  // --------------------------------------------------------------------------
+
+  uint32_t hostImpl = BitOps::getHostFuncs().impl;
+  for (uint32_t impl = 0; impl < BitOps::kImplCount; impl++) {
+    const BitOps::Funcs* funcs = BitOps::getFuncs(impl);
+    if (!funcs) continue;
+
+    BitOps::setHostImpl(impl);
+    perf.reset();
+    for (r = 0; r < kNumRepeats; r++) {
+      code.init(makeCodeInfo(archType));
+      code.attach(&cc);
+      generateManyVRegs(cc, kNumVirtRegs);
+
+      // Only `finalize()` is measured, it runs the register allocator.
+      perf.start();
+      cc.finalize();
+      perf.end();
+
+      code.reset(false); // Detaches `cc`.
+    }
+
+    printf("%-12s (%s) | Time: %-6u [ms] | VirtRegs: %u | BitOps: %s\n",
+      "X86Compiler", archName, perf.best, kNumVirtRegs, funcs->name);
+  }
+  BitOps::setHostImpl(hostImpl);
 }
 #endif
 
 int main(int argc, char* argv[]) {
+  benchConstPool();
+  benchNamedLabels();
+
 #if defined(ASMJIT_BUILD_X86)
   benchX86(ArchInfo::kTypeX86);
   benchX86(ArchInfo::kTypeX64);
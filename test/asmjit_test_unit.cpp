@@ -197,6 +197,7 @@ static void dumpSizeOf(void) {
   DUMP_TYPE(Zone);
   DUMP_TYPE(ZoneHeap);
   DUMP_TYPE(ZoneHash<ZoneHashNode>);
+  DUMP_TYPE(ZoneOpenHash<ZoneHashNode>);
   DUMP_TYPE(ZoneList<void*>);
   DUMP_TYPE(ZoneVector<void*>);
   INFO("");
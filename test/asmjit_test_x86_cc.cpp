@@ -132,6 +132,8 @@ int X86TestManager::run() {
 #endif // ASMJIT_DISABLE_LOGGING
 
     X86Compiler cc(&code);
+    cc.setPassStatsEnabled(_verbose);
+
     X86Test* test = _tests[i];
     test->compile(cc);
 
@@ -884,6 +886,171 @@ public:
   }
 };
 
+// ============================================================================
+// [X86Test_AllocMany3]
+// ============================================================================
+
+class X86Test_AllocMany3 : public X86Test {
+public:
+  X86Test_AllocMany3() : X86Test("[Alloc] Many #3"), _funcNode(NULL) {}
+
+  enum { kCount = 24, kGroupCount = 4 };
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocMany3());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    _funcNode = cc.addFunc(FuncSignature1<void, int*>(CallConv::kIdHost));
+
+    X86Gp a = cc.newIntPtr("a");
+    cc.setArg(0, a);
+
+    // Groups of variables that are never live at the same time, each group
+    // needs more registers than available so variables of all groups have to
+    // be spilled (and can share their home slots).
+    for (int group = 0; group < kGroupCount; group++) {
+      X86Gp var[kCount];
+      X86Gp v0 = cc.newInt32("v0");
+      Label L = cc.newLabel();
+
+      int i;
+      for (i = 0; i < kCount; i++) {
+        var[i] = cc.newInt32("var%d[%d]", group, i);
+        cc.mov(var[i], group * 1000 + i);
+      }
+
+      cc.mov(v0, 16);
+      cc.bind(L);
+
+      for (i = 0; i < kCount; i++) {
+        cc.add(var[i], i + group);
+      }
+
+      cc.dec(v0);
+      cc.jnz(L);
+
+      for (i = 0; i < kCount; i++) {
+        cc.mov(x86::dword_ptr(a, (group * kCount + i) * 4), var[i]);
+      }
+    }
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int i;
+    int resultBuf[kCount * kGroupCount];
+    int expectBuf[kCount * kGroupCount];
+
+    for (i = 0; i < kCount * kGroupCount; i++) {
+      int group = i / kCount;
+      int index = i % kCount;
+      expectBuf[i] = group * 1000 + index + (index + group) * 16;
+    }
+
+    bool success = true;
+    func(resultBuf);
+
+    for (i = 0; i < kCount * kGroupCount; i++) {
+      result.appendFormat("%d ", resultBuf[i]);
+      expect.appendFormat("%d ", expectBuf[i]);
+
+      success &= (resultBuf[i] == expectBuf[i]);
+    }
+
+    // Spilled variables of all groups must fit into home slots of a single
+    // group (its variables, `v0`, and `a`), unshared slots need more than
+    // twice that.
+    uint32_t frameSize = _funcNode->getFrameInfo().getStackFrameSize();
+    uint32_t frameLimit = (kCount + 1) * 4 + 8;
+
+    result.appendFormat("Frame=%u", frameSize);
+    expect.appendFormat("Frame<=%u", frameLimit);
+
+    success &= (frameSize <= frameLimit);
+    return success;
+  }
+
+  CCFunc* _funcNode;
+};
+
+// ============================================================================
+// [X86Test_AllocCopies]
+// ============================================================================
+
+class X86Test_AllocCopies : public X86Test {
+public:
+  X86Test_AllocCopies() : X86Test("[Alloc] Copies") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocCopies());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newInt32("b");
+
+    X86Gp x = cc.newInt32("x");
+    X86Gp y = cc.newInt32("y");
+    X86Gp z = cc.newInt32("z");
+    X86Gp t = cc.newInt32("t");
+
+    X86Gp i = cc.newInt32("i");
+    X86Gp acc = cc.newInt32("acc");
+    X86Gp tmp = cc.newInt32("tmp");
+
+    Label L_Loop = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.setArg(1, b);
+
+    // Copies that can be coalesced.
+    cc.mov(x, a);
+    cc.add(x, b);
+    cc.mov(y, x);
+    cc.imul(y, y, 3);
+    cc.mov(z, y);
+
+    // Copy that can't be coalesced as both `t` and `z` are alive after it.
+    cc.mov(t, z);
+    cc.add(z, 1);
+    cc.add(t, z);
+
+    // Copies inside of a loop.
+    cc.mov(i, 4);
+    cc.xor_(acc, acc);
+
+    cc.bind(L_Loop);
+    cc.mov(tmp, acc);
+    cc.add(tmp, t);
+    cc.mov(acc, tmp);
+    cc.dec(i);
+    cc.jnz(L_Loop);
+
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func(3, 4);
+    int expectRet = (((3 + 4) * 3) * 2 + 1) * 4;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
 // ============================================================================
 // [X86Test_AllocImul1]
 // ============================================================================
@@ -2189,6 +2356,296 @@ public:
   }
 };
 
+// ============================================================================
+// [X86Test_AllocKRegs]
+// ============================================================================
+
+class X86Test_AllocKRegs : public X86Test {
+public:
+  X86Test_AllocKRegs() : X86Test("[Alloc] KRegs") {}
+
+  enum { kMaskCount = 10 };
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocKRegs());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature3<void, int*, const int*, const int*>(CallConv::kIdHost));
+
+    X86Gp dst = cc.newIntPtr("dst");
+    X86Gp src0 = cc.newIntPtr("src0");
+    X86Gp src1 = cc.newIntPtr("src1");
+
+    cc.setArg(0, dst);
+    cc.setArg(1, src0);
+    cc.setArg(2, src1);
+
+    uint32_t i;
+
+    if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX512_F)) {
+      X86Gp t = cc.newInt32("t");
+      X86Xmm vt = cc.newXmm("vt");
+      X86Zmm a = cc.newZmm("a");
+      X86Zmm b = cc.newZmm("b");
+      X86Zmm v = cc.newZmm("v");
+      X86Zmm acc = cc.newZmm("acc");
+      X86KReg k[kMaskCount];
+
+      cc.vmovdqu32(a, x86::ptr(src0));
+      cc.vmovdqu32(b, x86::ptr(src1));
+      cc.vpxord(acc, acc, acc);
+
+      // More masks are live at the same time than there are K registers.
+      for (i = 0; i < kMaskCount; i++) {
+        k[i] = cc.newKw("m%u", i);
+        cc.mov(t, i);
+        cc.vmovd(vt, t);
+        cc.vpbroadcastd(v, vt);
+        cc.vpcmpd(k[i], a, v, 6);
+      }
+
+      for (i = 0; i < kMaskCount; i++)
+        cc.k(k[i]).vpaddd(acc, acc, b);
+
+      cc.vmovdqu32(x86::ptr(dst), acc);
+    }
+    else {
+      // The same computation by using GP registers.
+      X86Gp x = cc.newInt32("x");
+      X86Gp zero = cc.newInt32("zero");
+      X86Gp ten = cc.newInt32("ten");
+
+      cc.xor_(zero, zero);
+      cc.mov(ten, kMaskCount);
+
+      for (i = 0; i < 16; i++) {
+        cc.mov(x, x86::dword_ptr(src0, i * 4));
+        cc.cmp(x, zero);
+        cc.cmovl(x, zero);
+        cc.cmp(x, ten);
+        cc.cmovg(x, ten);
+        cc.imul(x, x86::dword_ptr(src1, i * 4));
+        cc.mov(x86::dword_ptr(dst, i * 4), x);
+      }
+    }
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(int*, const int*, const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int a[16];
+    int b[16];
+    int resultRet[16] = { 0 };
+    int expectRet[16];
+
+    for (int i = 0; i < 16; i++) {
+      a[i] = i - 3;
+      b[i] = i + 1;
+      expectRet[i] = b[i] * (a[i] < 0 ? 0 : a[i] > kMaskCount ? int(kMaskCount) : a[i]);
+    }
+
+    func(resultRet, a, b);
+
+    result.appendString("ret={");
+    expect.appendString("ret={");
+
+    for (int i = 0; i < 16; i++) {
+      result.appendFormat(i ? ", %d" : "%d", resultRet[i]);
+      expect.appendFormat(i ? ", %d" : "%d", expectRet[i]);
+    }
+
+    result.appendString("}");
+    expect.appendString("}");
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocKRegsMerge]
+// ============================================================================
+
+class X86Test_AllocKRegsMerge : public X86Test {
+public:
+  X86Test_AllocKRegsMerge() : X86Test("[Alloc] KRegsMerge") {}
+
+  enum { kPressure = 40 };
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocKRegsMerge());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature2<void, int*, const int*>(CallConv::kIdHost));
+
+    X86Gp dst = cc.newIntPtr("dst");
+    X86Gp src = cc.newIntPtr("src");
+
+    cc.setArg(0, dst);
+    cc.setArg(1, src);
+
+    uint32_t i;
+
+    if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX512_F)) {
+      X86Gp t = cc.newInt32("t");
+      X86KReg k = cc.newKw("k");
+      X86Zmm r = cc.newZmm("r");
+      X86Zmm b = cc.newZmm("b");
+      X86Zmm p[kPressure];
+
+      cc.vmovdqu32(r, x86::ptr(src));
+      cc.vmovdqu32(b, x86::ptr(src, 64));
+      cc.mov(t, 0x00FF);
+      cc.kmovw(k, t);
+
+      // More vectors are live than there are registers, 'r' is spilled.
+      for (i = 0; i < kPressure; i++) {
+        p[i] = cc.newZmm("p%u", i);
+        cc.vmovdqu32(p[i], x86::ptr(src, 128));
+      }
+
+      // Merge-masking reads 'r' even if it's not a source operand.
+      cc.k(k).vmovdqa32(r, b);
+
+      for (i = 0; i < kPressure; i++)
+        cc.vpaddd(r, r, p[i]);
+      cc.vmovdqu32(x86::ptr(dst), r);
+    }
+    else {
+      // The same computation by using GP registers.
+      X86Gp x = cc.newInt32("x");
+
+      for (i = 0; i < 16; i++) {
+        cc.mov(x, x86::dword_ptr(src, (i < 8 ? 64 : 0) + i * 4));
+        cc.mov(x86::dword_ptr(dst, i * 4), x);
+      }
+    }
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(int*, const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int src[48] = { 0 };
+    int resultRet[16] = { 0 };
+    int expectRet[16];
+
+    for (int i = 0; i < 16; i++) {
+      src[i] = i;
+      src[16 + i] = 100 + i;
+      expectRet[i] = i < 8 ? 100 + i : i;
+    }
+
+    func(resultRet, src);
+
+    result.appendString("ret={");
+    expect.appendString("ret={");
+
+    for (int i = 0; i < 16; i++) {
+      result.appendFormat(i ? ", %d" : "%d", resultRet[i]);
+      expect.appendFormat(i ? ", %d" : "%d", expectRet[i]);
+    }
+
+    result.appendString("}");
+    expect.appendString("}");
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_AllocHighVecRegs]
+// ============================================================================
+
+class X86Test_AllocHighVecRegs : public X86Test {
+public:
+  X86Test_AllocHighVecRegs() : X86Test("[Alloc] HighVecRegs") {}
+
+  enum { kVecCount = 24 };
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocHighVecRegs());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    const CpuInfo& cpu = CpuInfo::getHost();
+    CCFunc* func = cc.addFunc(FuncSignature1<int, const int*>(CallConv::kIdHost));
+
+    X86Gp src = cc.newIntPtr("src");
+    X86Gp ret = cc.newInt32("ret");
+    cc.setArg(0, src);
+
+    uint32_t i;
+
+    if (cpu.hasFeature(CpuInfo::kX86FeatureAVX512_F)) {
+      func->getFrameInfo().enableAvx512();
+      if (cpu.hasFeature(CpuInfo::kX86FeatureAVX512_VL))
+        func->getFrameInfo().enableAvx512VL();
+
+      X86Zmm v[kVecCount];
+      X86Zmm acc = cc.newZmm("acc");
+      X86Xmm t = cc.newXmm("t");
+
+      // More ZMM registers are live at the same time than XMM0-15.
+      for (i = 0; i < kVecCount; i++) {
+        v[i] = cc.newZmm("v%u", i);
+        cc.vpbroadcastd(v[i], x86::dword_ptr(src, i * 4));
+      }
+
+      // 'vpxor' has only VEX form, 'vpaddd xmm' requires AVX512-VL to use XMM16-31.
+      cc.vpxor(t, t, t);
+      cc.vpaddd(t, t, v[kVecCount - 1].xmm());
+
+      cc.vmovdqa32(acc, v[0]);
+      for (i = 1; i < kVecCount; i++)
+        cc.vpaddd(acc, acc, v[i]);
+
+      cc.vpaddd(acc.xmm(), acc.xmm(), t);
+      cc.vmovd(ret, acc.xmm());
+    }
+    else {
+      // The same computation by using GP registers.
+      X86Gp x = cc.newInt32("x");
+      cc.mov(ret, x86::dword_ptr(src, (kVecCount - 1) * 4));
+
+      for (i = 0; i < kVecCount; i++) {
+        cc.mov(x, x86::dword_ptr(src, i * 4));
+        cc.add(ret, x);
+      }
+    }
+
+    cc.ret(ret);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(const int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int src[kVecCount];
+    int expectRet = 0;
+
+    for (int i = 0; i < kVecCount; i++) {
+      src[i] = (i + 1) * 3;
+      expectRet += src[i];
+    }
+    expectRet += src[kVecCount - 1];
+
+    int resultRet = func(src);
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
 // ============================================================================
 // [X86Test_CallBase]
 // ============================================================================
@@ -3136,40 +3593,1278 @@ public:
 };
 
 // ============================================================================
-// [X86Test_MiscConstPool]
+// [X86Test_CallTailCall1]
 // ============================================================================
 
-class X86Test_MiscConstPool : public X86Test {
+class X86Test_CallTailCall1 : public X86Test {
 public:
-  X86Test_MiscConstPool() : X86Test("[Misc] ConstPool #1") {}
+  X86Test_CallTailCall1() : X86Test("[Call] TailCall #1") {}
 
   static void add(X86TestManager& mgr) {
-    mgr.add(new X86Test_MiscConstPool());
+    mgr.add(new X86Test_CallTailCall1());
   }
 
   virtual void compile(X86Compiler& cc) {
-    cc.addFunc(FuncSignature0<int>(CallConv::kIdHost));
+    CCFunc* func = cc.addFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
 
-    X86Gp v0 = cc.newInt32("v0");
-    X86Gp v1 = cc.newInt32("v1");
+    X86Gp n = cc.newInt32("n");
+    X86Gp acc = cc.newInt32("acc");
+    X86Gp t = cc.newInt32("t");
+    Label L_Done = cc.newLabel();
 
-    X86Mem c0 = cc.newInt32Const(kConstScopeLocal, 200);
-    X86Mem c1 = cc.newInt32Const(kConstScopeLocal, 33);
+    cc.setArg(0, n);
+    cc.setArg(1, acc);
 
-    cc.mov(v0, c0);
-    cc.mov(v1, c1);
-    cc.add(v0, v1);
+    cc.test(n, n);
+    cc.jz(L_Done);
 
-    cc.ret(v0);
+    cc.mov(t, n);
+    cc.and_(t, 7);
+    cc.add(acc, t);
+    cc.dec(n);
+
+    // Recursion in a tail position, doesn't grow the stack if translated to 'jmp'.
+    CCFuncCall* call = cc.call(func->getLabel(), FuncSignature2<int, int, int>(CallConv::kIdHost));
+    call->setArg(0, n);
+    call->setArg(1, acc);
+    call->setRet(0, acc);
+    call->addAttributes(CCFuncCall::kAttrTailCall);
+    cc.ret(acc);
+
+    cc.bind(L_Done);
+    cc.ret(acc);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func(10000, 1);
+    int expectRet = 1;
+
+    for (int i = 1; i <= 10000; i++)
+      expectRet += i & 7;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
+// ============================================================================
+// [X86Test_CallTailCall2]
+// ============================================================================
+
+class X86Test_CallTailCall2 : public X86Test {
+public:
+  X86Test_CallTailCall2() : X86Test("[Call] TailCall #2") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_CallTailCall2());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newInt32("b");
+    X86Gp r = cc.newInt32("r");
+    X86Gp pFn = cc.newIntPtr("pFn");
+
+    cc.setArg(0, a);
+    cc.setArg(1, b);
+
+    cc.add(a, a);
+    cc.mov(pFn, imm_ptr(calledFunc));
+
+    // Tail call through a register.
+    CCFuncCall* call = cc.call(pFn, FuncSignature2<int, int, int>(CallConv::kIdHost));
+    call->setArg(0, a);
+    call->setArg(1, b);
+    call->setRet(0, r);
+    call->addAttributes(CCFuncCall::kAttrTailCall);
+
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func(21, 5);
+    int expectRet = 37;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+
+  static int calledFunc(int a, int b) { return a - b; }
+};
+
+// ============================================================================
+// [X86Test_MiscConstPool]
+// ============================================================================
+
+class X86Test_MiscConstPool : public X86Test {
+public:
+  X86Test_MiscConstPool() : X86Test("[Misc] ConstPool #1") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscConstPool());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature0<int>(CallConv::kIdHost));
+
+    X86Gp v0 = cc.newInt32("v0");
+    X86Gp v1 = cc.newInt32("v1");
+
+    X86Mem c0 = cc.newInt32Const(kConstScopeLocal, 200);
+    X86Mem c1 = cc.newInt32Const(kConstScopeLocal, 33);
+
+    cc.mov(v0, c0);
+    cc.mov(v1, c1);
+    cc.add(v0, v1);
+
+    cc.ret(v0);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(void);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func();
+    int expectRet = 233;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscConstPool2]
+// ============================================================================
+
+class X86Test_MiscConstPool2 : public X86Test {
+public:
+  X86Test_MiscConstPool2() : X86Test("[Misc] ConstPool #2") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscConstPool2());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature1<void, int*>(CallConv::kIdHost));
+
+    X86Gp dst = cc.newIntPtr("dst");
+    cc.setArg(0, dst);
+
+    // The XMM constant is the second quarter of the ZMM constant, so it must
+    // not be added to the pool again.
+    X86Mem c0 = cc.newZmmConst(kConstScopeLocal, Data512::fromI32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    X86Mem c1 = cc.newXmmConst(kConstScopeLocal, Data128::fromI32(4, 5, 6, 7));
+    X86Xmm x = cc.newXmm("x");
+
+    if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX512_F)) {
+      X86Zmm z = cc.newZmm("z");
+
+      cc.vmovdqa32(z, c0);
+      cc.vpaddd(z, z, c0);
+      cc.vmovdqu32(x86::ptr(dst), z);
+    }
+    else {
+      for (uint32_t i = 0; i < 4; i++) {
+        X86Mem m = c0;
+        m.addOffset(i * 16);
+
+        cc.movdqa(x, m);
+        cc.paddd(x, m);
+        cc.movdqu(x86::ptr(dst, i * 16), x);
+      }
+    }
+
+    cc.movdqa(x, c1);
+    cc.movdqu(x86::ptr(dst, 64), x);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultBuf[20] = { 0 };
+    int expectBuf[20];
+
+    uint32_t i;
+    for (i = 0; i < 16; i++)
+      expectBuf[i] = static_cast<int>(i * 2);
+    for (i = 0; i < 4; i++)
+      expectBuf[16 + i] = static_cast<int>(i + 4);
+
+    func(resultBuf);
+
+    result.appendString("buf={");
+    expect.appendString("buf={");
+
+    for (i = 0; i < 20; i++) {
+      if (i != 0) {
+        result.appendString(", ");
+        expect.appendString(", ");
+      }
+      result.appendFormat("%d", resultBuf[i]);
+      expect.appendFormat("%d", expectBuf[i]);
+    }
+
+    result.appendString("}");
+    expect.appendString("}");
+
+    return ::memcmp(resultBuf, expectBuf, sizeof(resultBuf)) == 0;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscConstLoad]
+// ============================================================================
+
+class X86Test_MiscConstLoad : public X86Test {
+public:
+  enum { kBufSize = 68 };
+
+  X86Test_MiscConstLoad(bool avx)
+    : X86Test(avx ? "[Misc] ConstLoad (AVX)" : "[Misc] ConstLoad (SSE)"),
+      _avx(avx && CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX)),
+      _avx512(avx && CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX512_F)),
+      _bcstSize(0) {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscConstLoad(false));
+    mgr.add(new X86Test_MiscConstLoad(true));
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    CCFunc* func = cc.addFunc(FuncSignature1<void, int*>(CallConv::kIdHost));
+
+    if (_avx)
+      func->getFrameInfo().enableAvx();
+    if (_avx512)
+      func->getFrameInfo().enableAvx512();
+
+    X86Gp dst = cc.newIntPtr("dst");
+    cc.setArg(0, dst);
+
+    uint32_t i;
+    X86Xmm x[5];
+
+    for (i = 0; i < 5; i++)
+      x[i] = cc.newXmm("x%u", i);
+
+    cc.loadConst(x[0], kConstScopeLocal, Data128::fromU32(0));
+    cc.loadConst(x[1], kConstScopeLocal, Data128::fromI32(-1));
+    cc.loadConst(x[2], kConstScopeLocal, Data128::fromI32(7));
+    cc.loadConst(x[3], kConstScopeLocal, Data128::fromU64(ASMJIT_UINT64_C(0x0000000200000001)));
+    cc.loadConst(x[4], kConstScopeLocal, Data128::fromI32(1, 2, 3, 4));
+
+    for (i = 0; i < 5; i++)
+      cc.movdqu(x86::ptr(dst, i * 16), x[i]);
+
+    if (_avx) {
+      X86Ymm y0 = cc.newYmm("y0");
+      X86Ymm y1 = cc.newYmm("y1");
+
+      cc.loadConst(y0, kConstScopeLocal, Data256::fromU8(0x80));
+      cc.loadConst(y1, kConstScopeLocal, Data256::fromI32(-1));
+      cc.vmovdqu(x86::ptr(dst, 80), y0);
+      cc.vmovdqu(x86::ptr(dst, 112), y1);
+    }
+
+    Data512 three = Data512::fromU32(3);
+    _bcstSize = cc.newBroadcastConst(kConstScopeLocal, &three, 64).getSize();
+
+    if (_avx512) {
+      X86Zmm z0 = cc.newZmm("z0");
+      X86Zmm z1 = cc.newZmm("z1");
+
+      cc.loadConst(z0, kConstScopeLocal, Data512::fromI32(5));
+      cc.loadConst(z1, kConstScopeLocal, Data512::fromI32(-1));
+      cc._1tox().vpaddd(z0, z0, cc.newBroadcastConst(kConstScopeLocal, &three, 64));
+
+      cc.vmovdqu32(x86::ptr(dst, 144), z0);
+      cc.vmovdqu32(x86::ptr(dst, 208), z1);
+    }
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(int*);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultBuf[kBufSize];
+    int expectBuf[kBufSize];
+
+    uint32_t i;
+    for (i = 0; i < kBufSize; i++) {
+      resultBuf[i] = 0x11111111;
+      expectBuf[i] = 0x11111111;
+    }
+
+    static const int expectX[20] = { 0, 0, 0, 0, -1, -1, -1, -1, 7, 7, 7, 7, 1, 2, 1, 2, 1, 2, 3, 4 };
+    ::memcpy(expectBuf, expectX, sizeof(expectX));
+
+    if (_avx) {
+      for (i = 0; i < 8; i++) {
+        expectBuf[20 + i] = static_cast<int>(0x80808080U);
+        expectBuf[28 + i] = -1;
+      }
+    }
+
+    if (_avx512) {
+      for (i = 0; i < 16; i++) {
+        expectBuf[36 + i] = 8;
+        expectBuf[52 + i] = -1;
+      }
+    }
+
+    func(resultBuf);
+
+    result.appendFormat("bcstSize=%u buf={", _bcstSize);
+    expect.appendFormat("bcstSize=%u buf={", 4);
+
+    for (i = 0; i < kBufSize; i++) {
+      if (i != 0) {
+        result.appendString(", ");
+        expect.appendString(", ");
+      }
+      result.appendFormat("%d", resultBuf[i]);
+      expect.appendFormat("%d", expectBuf[i]);
+    }
+
+    result.appendString("}");
+    expect.appendString("}");
+
+    return _bcstSize == 4 && ::memcmp(resultBuf, expectBuf, sizeof(resultBuf)) == 0;
+  }
+
+  bool _avx;
+  bool _avx512;
+  uint32_t _bcstSize;
+};
+
+// ============================================================================
+// [X86Test_MiscSharedConst]
+// ============================================================================
+
+class X86Test_MiscSharedConst : public X86Test {
+public:
+  X86Test_MiscSharedConst() : X86Test("[Misc] SharedConst") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscSharedConst());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature0<void>(CallConv::kIdHost));
+    cc.endFunc();
+  }
+
+  // Compile a function that returns `[a] * 3 + [b]`, where `a` and `b` are
+  // constants shared by the runtime.
+  static Error compileFunc(JitRuntime& rt, void** func, const void* a, const void* b) {
+    CodeHolder code;
+    code.init(rt.getCodeInfo());
+
+    X86Compiler cc(&code);
+    cc.addFunc(FuncSignature0<int>(CallConv::kIdHost));
+
+    X86Gp x = cc.newInt32("x");
+    cc.imul(x, x86::ptr_rel((uint64_t)(uintptr_t)a, 4), 3);
+    cc.add(x, x86::ptr_rel((uint64_t)(uintptr_t)b, 4));
+    cc.ret(x);
+    cc.endFunc();
+
+    ASMJIT_PROPAGATE(cc.finalize());
+    return rt._add(func, &code);
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(void);
+
+    JitRuntime rt;
+    uint32_t c10 = 10;
+    uint32_t c20 = 20;
+    uint32_t c30 = 30;
+
+    const void* p0 = nullptr;
+    const void* p1 = nullptr;
+    const void* p2 = nullptr;
+    const void* p3 = nullptr;
+
+    void* f0 = nullptr;
+    void* f1 = nullptr;
+
+    rt.addConst(&p0, &c10, 4);
+    rt.addConst(&p1, &c20, 4);
+    rt.addConst(&p2, &c10, 4);
+
+    compileFunc(rt, &f0, p0, p1);
+    compileFunc(rt, &f1, p2, p0);
+
+    int r0 = f0 ? ptr_as_func<Func>(f0)() : -1;
+    int r1 = f1 ? ptr_as_func<Func>(f1)() : -1;
+
+    // Release `20`, its space has to be reused by `30`.
+    rt.releaseConst(p1, 4);
+    rt.addConst(&p3, &c30, 4);
+
+    result.setFormat("r0=%d r1=%d shared=%d reused=%d count=%u",
+      r0, r1, p0 == p2, p1 == p3, static_cast<unsigned int>(rt.getConstCount()));
+    expect.setFormat("r0=%d r1=%d shared=%d reused=%d count=%u",
+      50, 40, 1, 1, 2);
+
+    if (f0) rt.release(f0);
+    if (f1) rt.release(f1);
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscCheckpoint]
+// ============================================================================
+
+class X86Test_MiscCheckpoint : public X86Test {
+public:
+  X86Test_MiscCheckpoint() : X86Test("[Misc] Checkpoint") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscCheckpoint());
+  }
+
+  // Emit `a * 3 + b` (if `variant` is 0), or `a - b` (if `variant` is 1),
+  // with jumps to `exit`, which was created before the checkpoint.
+  static void emitVariant(X86Compiler& cc, const X86Gp& dst, const X86Gp& a, const X86Gp& b, const Label& exit, uint32_t variant) {
+    X86Gp t = cc.newInt32("t");
+    Label L_Skip = cc.newLabel();
+
+    cc.mov(dst, a);
+    cc.test(a, a);
+    cc.js(L_Skip);
+
+    if (variant == 0) {
+      cc.imul(t, a, 3);
+      cc.lea(dst, x86::ptr(t, b));
+    }
+    else {
+      cc.mov(t, b);
+      cc.sub(dst, t);
+      cc.movd(x86::xmm0, cc.newInt32Const(kConstScopeLocal, 0x12345678));
+    }
+
+    cc.bind(L_Skip);
+    cc.jmp(exit);
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newInt32("b");
+    X86Gp dst = cc.newInt32("dst");
+    Label L_Exit = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.setArg(1, b);
+    cc.xor_(dst, dst);
+
+    // Try both variants and keep the shorter one, `a * 3 + b` is kept.
+    X86Compiler::Checkpoint cp;
+    uint32_t bestVariant = 0;
+    uint32_t bestCount = 0xFFFFFFFFU;
+
+    for (uint32_t variant = 0; variant < 2; variant++) {
+      cc.checkpoint(cp);
+      CBNode* first = cc.getCursor();
+      emitVariant(cc, dst, a, b, L_Exit, variant);
+
+      uint32_t count = 0;
+      for (CBNode* node = first->getNext(); node; node = node->getNext())
+        count++;
+
+      if (count < bestCount) {
+        bestVariant = variant;
+        bestCount = count;
+      }
+      cc.rollback(cp);
+    }
+
+    // A nested checkpoint that is committed.
+    X86Compiler::Checkpoint outer;
+    cc.checkpoint(outer);
+    cc.checkpoint(cp);
+    emitVariant(cc, dst, a, b, L_Exit, bestVariant);
+    cc.commit(cp);
+    cc.commit(outer);
+
+    cc.bind(L_Exit);
+    cc.ret(dst);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int r0 = func(5, 2);
+    int r1 = func(-4, 2);
+
+    result.setFormat("ret={%d, %d}", r0, r1);
+    expect.setFormat("ret={%d, %d}", 17, -4);
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscMultiRet]
+// ============================================================================
+
+struct X86Test_MiscMultiRet : public X86Test {
+  X86Test_MiscMultiRet() : X86Test("[Misc] MultiRet") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscMultiRet());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature3<int, int, int, int>(CallConv::kIdHost));
+
+    X86Gp op = cc.newInt32("op");
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newInt32("b");
+
+    Label L_Zero = cc.newLabel();
+    Label L_Add = cc.newLabel();
+    Label L_Sub = cc.newLabel();
+    Label L_Mul = cc.newLabel();
+    Label L_Div = cc.newLabel();
+
+    cc.setArg(0, op);
+    cc.setArg(1, a);
+    cc.setArg(2, b);
+
+    cc.cmp(op, 0);
+    cc.jz(L_Add);
+
+    cc.cmp(op, 1);
+    cc.jz(L_Sub);
+
+    cc.cmp(op, 2);
+    cc.jz(L_Mul);
+
+    cc.cmp(op, 3);
+    cc.jz(L_Div);
+
+    cc.bind(L_Zero);
+    cc.xor_(a, a);
+    cc.ret(a);
+
+    cc.bind(L_Add);
+    cc.add(a, b);
+    cc.ret(a);
+
+    cc.bind(L_Sub);
+    cc.sub(a, b);
+    cc.ret(a);
+
+    cc.bind(L_Mul);
+    cc.imul(a, b);
+    cc.ret(a);
+
+    cc.bind(L_Div);
+    cc.cmp(b, 0);
+    cc.jz(L_Zero);
+
+    X86Gp zero = cc.newInt32("zero");
+    cc.xor_(zero, zero);
+    cc.idiv(zero, a, b);
+    cc.ret(a);
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int, int);
+
+    Func func = ptr_as_func<Func>(_func);
+
+    int a = 44;
+    int b = 3;
+
+    int r0 = func(0, a, b);
+    int r1 = func(1, a, b);
+    int r2 = func(2, a, b);
+    int r3 = func(3, a, b);
+    int e0 = a + b;
+    int e1 = a - b;
+    int e2 = a * b;
+    int e3 = a / b;
+
+    result.setFormat("ret={%d %d %d %d}", r0, r1, r2, r3);
+    expect.setFormat("ret={%d %d %d %d}", e0, e1, e2, e3);
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscMultiFunc]
+// ============================================================================
+
+class X86Test_MiscMultiFunc : public X86Test {
+public:
+  X86Test_MiscMultiFunc() : X86Test("[Misc] MultiFunc") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscMultiFunc());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    CCFunc* f1 = cc.newFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
+    CCFunc* f2 = cc.newFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
+
+    {
+      X86Gp a = cc.newInt32("a");
+      X86Gp b = cc.newInt32("b");
+
+      cc.addFunc(f1);
+      cc.setArg(0, a);
+      cc.setArg(1, b);
+
+      CCFuncCall* call = cc.call(f2->getLabel(), FuncSignature2<int, int, int>(CallConv::kIdHost));
+      call->setArg(0, a);
+      call->setArg(1, b);
+      call->setRet(0, a);
+
+      cc.ret(a);
+      cc.endFunc();
+    }
+
+    {
+      X86Gp a = cc.newInt32("a");
+      X86Gp b = cc.newInt32("b");
+
+      cc.addFunc(f2);
+      cc.setArg(0, a);
+      cc.setArg(1, b);
+
+      cc.add(a, b);
+      cc.ret(a);
+      cc.endFunc();
+    }
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int, int);
+
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func(56, 22);
+    int expectRet = 56 + 22;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscFastEval]
+// ============================================================================
+
+class X86Test_MiscFastEval : public X86Test {
+public:
+  X86Test_MiscFastEval() : X86Test("[Misc] FastEval (CConv)") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscFastEval());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    FuncSignature5<void, const void*, const void*, const void*, const void*, void*> funcSig(CallConv::kIdHostCDecl);
+    FuncSignature2<X86Xmm, X86Xmm, X86Xmm> fastSig(CallConv::kIdHostFastEval2);
+
+    CCFunc* func = cc.newFunc(funcSig);
+    CCFunc* fast = cc.newFunc(fastSig);
+
+    {
+      X86Gp aPtr = cc.newIntPtr("aPtr");
+      X86Gp bPtr = cc.newIntPtr("bPtr");
+      X86Gp cPtr = cc.newIntPtr("cPtr");
+      X86Gp dPtr = cc.newIntPtr("dPtr");
+      X86Gp pOut = cc.newIntPtr("pOut");
+
+      X86Xmm aXmm = cc.newXmm("aXmm");
+      X86Xmm bXmm = cc.newXmm("bXmm");
+      X86Xmm cXmm = cc.newXmm("cXmm");
+      X86Xmm dXmm = cc.newXmm("dXmm");
+
+      cc.addFunc(func);
+
+      cc.setArg(0, aPtr);
+      cc.setArg(1, bPtr);
+      cc.setArg(2, cPtr);
+      cc.setArg(3, dPtr);
+      cc.setArg(4, pOut);
+
+      cc.movups(aXmm, x86::ptr(aPtr));
+      cc.movups(bXmm, x86::ptr(bPtr));
+      cc.movups(cXmm, x86::ptr(cPtr));
+      cc.movups(dXmm, x86::ptr(dPtr));
+
+      X86Xmm xXmm = cc.newXmm("xXmm");
+      X86Xmm yXmm = cc.newXmm("yXmm");
+
+      CCFuncCall* call1 = cc.call(fast->getLabel(), fastSig);
+      call1->setArg(0, aXmm);
+      call1->setArg(1, bXmm);
+      call1->setRet(0, xXmm);
+
+      CCFuncCall* call2 = cc.call(fast->getLabel(), fastSig);
+      call2->setArg(0, cXmm);
+      call2->setArg(1, dXmm);
+      call2->setRet(0, yXmm);
+
+      cc.pmullw(xXmm, yXmm);
+      cc.movups(x86::ptr(pOut), xXmm);
+
+      cc.endFunc();
+    }
+
+    {
+      X86Xmm aXmm = cc.newXmm("aXmm");
+      X86Xmm bXmm = cc.newXmm("bXmm");
+
+      cc.addFunc(fast);
+      cc.setArg(0, aXmm);
+      cc.setArg(1, bXmm);
+      cc.paddw(aXmm, bXmm);
+      cc.ret(aXmm);
+      cc.endFunc();
+    }
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(const void*, const void*, const void*, const void*, void*);
+
+    Func func = ptr_as_func<Func>(_func);
+
+    int16_t a[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    int16_t b[8] = { 7, 6, 5, 4, 3, 2, 1, 0 };
+    int16_t c[8] = { 1, 3, 9, 7, 5, 4, 2, 1 };
+    int16_t d[8] = { 2, 0,-6,-4,-2,-1, 1, 2 };
+
+    int16_t o[8];
+    int oExp = 7 * 3;
+
+    func(a, b, c, d, o);
+
+    result.setFormat("ret={%02X %02X %02X %02X %02X %02X %02X %02X}", o[0], o[1], o[2], o[3], o[4], o[5], o[6], o[7]);
+    expect.setFormat("ret={%02X %02X %02X %02X %02X %02X %02X %02X}", oExp, oExp, oExp, oExp, oExp, oExp, oExp, oExp);
+
+    return result == expect;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscUnfollow]
+// ============================================================================
+
+// Global (I didn't find a better way to test this).
+static jmp_buf globalJmpBuf;
+
+class X86Test_MiscUnfollow : public X86Test {
+public:
+  X86Test_MiscUnfollow() : X86Test("[Misc] Unfollow") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscUnfollow());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    // NOTE: Fastcall calling convention is the most appropriate here, as all
+    // arguments will be passed by registers and there won't be any stack
+    // misalignment when we call the `handler()`. This was failing on OSX
+    // when targeting 32-bit.
+    cc.addFunc(FuncSignature2<void, int, void*>(CallConv::kIdHostFastCall));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newIntPtr("b");
+
+    Label tramp = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.setArg(1, b);
+
+    cc.cmp(a, 0);
+    cc.jz(tramp);
+
+    cc.ret(a);
+
+    cc.bind(tramp);
+    cc.unfollow().jmp(b);
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (ASMJIT_FASTCALL *Func)(int, void*);
+
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = 0;
+    int expectRet = 1;
+
+    if (!setjmp(globalJmpBuf))
+      resultRet = func(0, (void*)handler);
+    else
+      resultRet = 1;
+
+    result.setFormat("ret={%d}", resultRet);
+    expect.setFormat("ret={%d}", expectRet);
+
+    return resultRet == expectRet;
+  }
+
+  static void ASMJIT_FASTCALL handler() { longjmp(globalJmpBuf, 1); }
+};
+
+// ============================================================================
+// [X86Test_MiscPeephole]
+// ============================================================================
+
+class X86Test_MiscPeephole : public X86Test {
+public:
+  X86Test_MiscPeephole() : X86Test("[Misc] Peephole") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscPeephole());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.insertPass(0, cc.newPassT<X86PeepholePass>(X86PeepholePass::kPhaseVirtual));
+    cc.addPassT<X86PeepholePass>(X86PeepholePass::kPhasePhysical);
+
+    cc.addFunc(FuncSignature2<int, int*, int>(CallConv::kIdHost));
+
+    X86Gp p = cc.newIntPtr("p");
+    X86Gp c = cc.newIntPtr("c");
+    X86Gp a = cc.newInt32("a");
+    X86Gp b = cc.newInt32("b");
+    X86Gp x = cc.newInt32("x");
+    X86Gp y = cc.newInt32("y");
+
+    Label L1 = cc.newLabel();
+    Label L2 = cc.newLabel();
+
+    cc.setArg(0, p);
+    cc.setArg(1, a);
+
+    cc.mov(b, 0);
+    cc.add(b, a);
+
+    cc.add(a, 1);
+    cc.add(a, 2);
+    cc.sub(a, 1);
+    cc.add(b, a);
+
+    cc.mov(x, x86::dword_ptr(p));
+    cc.mov(y, x86::dword_ptr(p));
+
+    // Flags of `mov a, 0` are needed by `jz`, it can't become `xor a, a`.
+    cc.cmp(a, 5);
+    cc.mov(a, 0);
+    cc.jz(L1);
+    cc.add(b, 1000);
+
+    cc.bind(L1);
+    cc.mov(c, p);
+    cc.shl(c, 2);
+    cc.add(c, p);
+
+    cc.add(b, x);
+    cc.add(b, y);
+    cc.mov(x86::dword_ptr(p, 4), b);
+
+    cc.test(b, b);
+    cc.jz(L1);
+    cc.jmp(L2);
+
+    cc.bind(L2);
+    cc.add(b, a);
+    cc.ret(b);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int*, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int buffer[2] = { 7, 0 };
+    int resultRet = func(buffer, 3);
+    int expectRet = 3 + 5 + 7 + 7;
+
+    result.setFormat("ret=%d, buf[1]=%d", resultRet, buffer[1]);
+    expect.setFormat("ret=%d, buf[1]=%d", expectRet, expectRet);
+
+    return resultRet == expectRet && buffer[1] == expectRet;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscPeepholeZext]
+// ============================================================================
+
+class X86Test_MiscPeepholeZext : public X86Test {
+public:
+  X86Test_MiscPeepholeZext(uint32_t phase) : _phase(phase) {
+    _name.setFormat("[Misc] Peephole Zext (%s)",
+      phase == X86PeepholePass::kPhaseVirtual ? "Virtual" : "Physical");
+  }
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscPeepholeZext(X86PeepholePass::kPhaseVirtual));
+    mgr.add(new X86Test_MiscPeepholeZext(X86PeepholePass::kPhasePhysical));
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    if (_phase == X86PeepholePass::kPhaseVirtual)
+      cc.insertPass(0, cc.newPassT<X86PeepholePass>(X86PeepholePass::kPhaseVirtual));
+    else
+      cc.addPassT<X86PeepholePass>(X86PeepholePass::kPhasePhysical);
+
+    cc.addFunc(FuncSignature1<uintptr_t, uintptr_t>(CallConv::kIdHost));
+
+    X86Gp x = cc.newUIntPtr("x");
+    cc.setArg(0, x);
+
+    // The sum is zero, but writing the 32-bit register clears the upper half.
+    cc.add(x.r32(), 5);
+    cc.sub(x.r32(), 5);
+
+    cc.ret(x);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef uintptr_t (*Func)(uintptr_t);
+    Func func = ptr_as_func<Func>(_func);
+
+    uintptr_t arg = static_cast<uintptr_t>(ASMJIT_UINT64_C(0x1234567880000005));
+    uintptr_t resultRet = func(arg);
+    uintptr_t expectRet = arg & 0xFFFFFFFFU;
+
+    result.setFormat("ret=%llX", static_cast<unsigned long long>(resultRet));
+    expect.setFormat("ret=%llX", static_cast<unsigned long long>(expectRet));
+
+    return resultRet == expectRet;
+  }
+
+  uint32_t _phase;
+};
+
+// ============================================================================
+// [X86Test_MiscVexPromotion]
+// ============================================================================
+
+class X86Test_MiscVexPromotion : public X86Test {
+public:
+  X86Test_MiscVexPromotion() : X86Test("[Misc] VexPromotion") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscVexPromotion());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    // SSE instructions are only re-encoded if the CPU supports AVX.
+    if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX))
+      cc.addFuncAttributes(FuncFrameInfo::kX86AttrVexPromotion);
+
+    cc.addFunc(FuncSignature3<void, float*, const float*, const float*>(CallConv::kIdHost));
+
+    X86Gp dst = cc.newIntPtr("dst");
+    X86Gp src0 = cc.newIntPtr("src0");
+    X86Gp src1 = cc.newIntPtr("src1");
+
+    X86Xmm a = cc.newXmm("a");
+    X86Xmm b = cc.newXmm("b");
+    X86Xmm c = cc.newXmm("c");
+    X86Xmm d = cc.newXmm("d");
+
+    cc.setArg(0, dst);
+    cc.setArg(1, src0);
+    cc.setArg(2, src1);
+
+    cc.movups(a, x86::ptr(src0));
+    cc.movups(b, x86::ptr(src1));
+
+    // Copies followed by destructive instructions (c = a + b, d = a * c).
+    cc.movaps(c, a);
+    cc.addps(c, b);
+    cc.movaps(d, a);
+    cc.mulps(d, c);
+
+    cc.subps(d, a);
+    cc.shufps(d, d, x86::shufImm(0, 1, 2, 3));
+    cc.movups(x86::ptr(dst), d);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(float*, const float*, const float*);
+    Func func = ptr_as_func<Func>(_func);
+
+    float a[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    float b[4] = { 4.0f, 3.0f, 2.0f, 1.0f };
+    float resultRet[4] = { 0 };
+    float expectRet[4];
+
+    for (uint32_t i = 0; i < 4; i++)
+      expectRet[3 - i] = a[i] * (a[i] + b[i]) - a[i];
+    func(resultRet, a, b);
+
+    result.setFormat("ret={%g, %g, %g, %g}", resultRet[0], resultRet[1], resultRet[2], resultRet[3]);
+    expect.setFormat("ret={%g, %g, %g, %g}", expectRet[0], expectRet[1], expectRet[2], expectRet[3]);
+
+    return result.eq(expect);
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscVexPromotionWide]
+// ============================================================================
+
+class X86Test_MiscVexPromotionWide : public X86Test {
+public:
+  X86Test_MiscVexPromotionWide()
+    : X86Test("[Misc] VexPromotion (Wide)"),
+      _avx(CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX)) {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscVexPromotionWide());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFuncAttributes(FuncFrameInfo::kX86AttrVexPromotion);
+    cc.addFunc(FuncSignature2<void, float*, const float*>(CallConv::kIdHost));
+
+    X86Gp dst = cc.newIntPtr("dst");
+    X86Gp src = cc.newIntPtr("src");
+
+    cc.setArg(0, dst);
+    cc.setArg(1, src);
+
+    // YMM registers require AVX, the function does nothing without it.
+    if (_avx) {
+      X86Ymm y = cc.newYmm("y");
+      X86Xmm x = cc.newXmm("x");
+
+      cc.vmovups(y, x86::ptr(src));
+      cc.movups(x, x86::ptr(src, 32));
+
+      // Legacy SSE keeps bits 255:128 of `y`, VEX.128 would zero them.
+      cc.addps(X86Xmm(y.getId()), x);
+      cc.vmovups(x86::ptr(dst), y);
+    }
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef void (*Func)(float*, const float*);
+    Func func = ptr_as_func<Func>(_func);
+
+    float src[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 10, 20, 30, 40 };
+    float resultRet[8] = { 0 };
+    float expectRet[8] = { 0 };
+
+    if (_avx) {
+      for (uint32_t i = 0; i < 8; i++)
+        expectRet[i] = i < 4 ? src[i] + src[8 + i] : src[i];
+    }
+    func(resultRet, src);
+
+    for (uint32_t i = 0; i < 8; i++) {
+      result.appendFormat("%g ", resultRet[i]);
+      expect.appendFormat("%g ", expectRet[i]);
+    }
+
+    return result.eq(expect);
+  }
+
+  bool _avx;
+};
+
+// ============================================================================
+// [X86Test_MiscInline]
+// ============================================================================
+
+class X86Test_MiscInline : public X86Test {
+public:
+  X86Test_MiscInline() : X86Test("[Misc] Inline") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscInline());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.insertPass(0, cc.newPassT<X86InlinerPass>());
+
+    CCFunc* clamp = cc.newFunc(FuncSignature3<int, int, int, int>(CallConv::kIdHost));
+
+    // Sum of clamped values of an array, the calls of `clamp` are inlined.
+    {
+      cc.addFunc(FuncSignature2<int, int*, int>(CallConv::kIdHost));
+
+      X86Gp p = cc.newIntPtr("p");
+      X86Gp n = cc.newInt32("n");
+      X86Gp x = cc.newInt32("x");
+      X86Gp sum = cc.newInt32("sum");
+      X86Gp lo = cc.newInt32("lo");
+      Label L_Loop = cc.newLabel();
+
+      cc.setArg(0, p);
+      cc.setArg(1, n);
+      cc.xor_(sum, sum);
+      cc.mov(lo, -10);
+
+      cc.bind(L_Loop);
+      cc.mov(x, x86::dword_ptr(p));
+
+      CCFuncCall* call = cc.call(clamp->getLabel(), FuncSignature3<int, int, int, int>(CallConv::kIdHost));
+      call->setArg(0, x);
+      call->setArg(1, lo);
+      call->setArg(2, imm(10));
+      call->setRet(0, x);
+
+      cc.add(sum, x);
+      cc.add(p, 4);
+      cc.dec(n);
+      cc.jnz(L_Loop);
+
+      cc.ret(sum);
+      cc.endFunc();
+    }
+
+    // Clamp - 'x < lo ? lo : x > hi ? hi : x'.
+    {
+      cc.addFunc(clamp);
+
+      X86Gp x = cc.newInt32("x");
+      X86Gp lo = cc.newInt32("lo");
+      X86Gp hi = cc.newInt32("hi");
+      Label L_Lo = cc.newLabel();
+      Label L_Hi = cc.newLabel();
+
+      cc.setArg(0, x);
+      cc.setArg(1, lo);
+      cc.setArg(2, hi);
+
+      cc.cmp(x, lo);
+      cc.jl(L_Lo);
+      cc.cmp(x, hi);
+      cc.jg(L_Hi);
+      cc.ret(x);
+
+      cc.bind(L_Lo);
+      cc.ret(lo);
+
+      cc.bind(L_Hi);
+      cc.ret(hi);
+      cc.endFunc();
+    }
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int*, int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int a[8] = { 5, -20, 30, 0, -10, 10, 11, -11 };
+
+    int resultRet = func(a, 8);
+    int expectRet = 5 - 10 + 10 + 0 - 10 + 10 + 10 - 10;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscLicm]
+// ============================================================================
+
+class X86Test_MiscLicm : public X86Test {
+public:
+  X86Test_MiscLicm() : X86Test("[Misc] Licm") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscLicm());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.insertPass(0, cc.newPassT<X86LicmPass>());
+    cc.addFunc(FuncSignature3<int, int*, int, int>(CallConv::kIdHost));
+
+    X86Gp p = cc.newIntPtr("p");
+    X86Gp n = cc.newInt32("n");
+    X86Gp base = cc.newInt32("base");
+    X86Gp k = cc.newInt32("k");
+    X86Gp c = cc.newInt32("c");
+    X86Gp x = cc.newInt32("x");
+    X86Gp sum = cc.newInt32("sum");
+    Label L_Loop = cc.newLabel();
+
+    cc.setArg(0, p);
+    cc.setArg(1, n);
+    cc.setArg(2, base);
+    cc.xor_(sum, sum);
+
+    // Sum of 'a[i] + 3 + base * 2', 'k' and 'c' are moved in front of the loop.
+    cc.bind(L_Loop);
+    cc.mov(k, 3);
+    cc.lea(c, x86::ptr(base, base));
+    cc.mov(x, x86::dword_ptr(p));
+    cc.add(x, k);
+    cc.add(x, c);
+    cc.add(sum, x);
+    cc.add(p, 4);
+    cc.dec(n);
+    cc.jnz(L_Loop);
+
+    cc.ret(sum);
     cc.endFunc();
   }
 
   virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
-    typedef int (*Func)(void);
+    typedef int (*Func)(int*, int, int);
     Func func = ptr_as_func<Func>(_func);
 
-    int resultRet = func();
-    int expectRet = 233;
+    int a[8] = { 5, -20, 30, 0, -10, 10, 11, -11 };
+
+    int resultRet = func(a, 8, 7);
+    int expectRet = 0;
+
+    for (int i = 0; i < 8; i++)
+      expectRet += a[i] + 3 + 7 * 2;
 
     result.setFormat("ret=%d", resultRet);
     expect.setFormat("ret=%d", expectRet);
@@ -3179,318 +4874,315 @@ public:
 };
 
 // ============================================================================
-// [X86Test_MiscMultiRet]
+// [X86Test_MiscCse]
 // ============================================================================
 
-struct X86Test_MiscMultiRet : public X86Test {
-  X86Test_MiscMultiRet() : X86Test("[Misc] MultiRet") {}
+class X86Test_MiscCse : public X86Test {
+public:
+  X86Test_MiscCse() : X86Test("[Misc] Cse") {}
 
   static void add(X86TestManager& mgr) {
-    mgr.add(new X86Test_MiscMultiRet());
+    mgr.add(new X86Test_MiscCse());
   }
 
   virtual void compile(X86Compiler& cc) {
-    cc.addFunc(FuncSignature3<int, int, int, int>(CallConv::kIdHost));
-
-    X86Gp op = cc.newInt32("op");
-    X86Gp a = cc.newInt32("a");
-    X86Gp b = cc.newInt32("b");
-
-    Label L_Zero = cc.newLabel();
-    Label L_Add = cc.newLabel();
-    Label L_Sub = cc.newLabel();
-    Label L_Mul = cc.newLabel();
-    Label L_Div = cc.newLabel();
-
-    cc.setArg(0, op);
-    cc.setArg(1, a);
-    cc.setArg(2, b);
-
-    cc.cmp(op, 0);
-    cc.jz(L_Add);
-
-    cc.cmp(op, 1);
-    cc.jz(L_Sub);
-
-    cc.cmp(op, 2);
-    cc.jz(L_Mul);
-
-    cc.cmp(op, 3);
-    cc.jz(L_Div);
-
-    cc.bind(L_Zero);
-    cc.xor_(a, a);
-    cc.ret(a);
-
-    cc.bind(L_Add);
-    cc.add(a, b);
-    cc.ret(a);
-
-    cc.bind(L_Sub);
-    cc.sub(a, b);
-    cc.ret(a);
-
-    cc.bind(L_Mul);
-    cc.imul(a, b);
-    cc.ret(a);
-
-    cc.bind(L_Div);
-    cc.cmp(b, 0);
-    cc.jz(L_Zero);
+    cc.insertPass(0, cc.newPassT<X86CsePass>());
+    cc.addFunc(FuncSignature2<int, int*, intptr_t>(CallConv::kIdHost));
 
-    X86Gp zero = cc.newInt32("zero");
-    cc.xor_(zero, zero);
-    cc.idiv(zero, a, b);
-    cc.ret(a);
+    X86Gp p = cc.newIntPtr("p");
+    X86Gp i = cc.newIntPtr("i");
+    X86Gp t0 = cc.newIntPtr("t0");
+    X86Gp t1 = cc.newIntPtr("t1");
+    X86Gp x = cc.newInt32("x");
+    X86Gp y = cc.newInt32("y");
+    X86Xmm v = cc.newXmm("v");
+    X86Xmm v0 = cc.newXmm("v0");
+    X86Xmm v1 = cc.newXmm("v1");
 
+    cc.setArg(0, p);
+    cc.setArg(1, i);
+
+    // 'p[i & 7]' is loaded twice, the second load and its index are replaced
+    // by copies of the first ones.
+    cc.mov(t0, i);
+    cc.shl(t0, 2);
+    cc.and_(t0, 28);
+    cc.mov(x, x86::dword_ptr(p, t0));
+
+    cc.mov(t1, i);
+    cc.shl(t1, 2);
+    cc.and_(t1, 28);
+    cc.mov(y, x86::dword_ptr(p, t1));
+
+    // The same for a broadcast computed by SSE.
+    cc.movd(v, x);
+    cc.pshufd(v0, v, x86::shufImm(0, 0, 0, 0));
+    cc.pshufd(v1, v, x86::shufImm(0, 0, 0, 0));
+    cc.paddd(v0, v1);
+    cc.psrldq(v0, 4);
+
+    cc.movd(x, v0);
+    cc.add(x, y);
+
+    cc.ret(x);
     cc.endFunc();
   }
 
   virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
-    typedef int (*Func)(int, int, int);
-
+    typedef int (*Func)(int*, intptr_t);
     Func func = ptr_as_func<Func>(_func);
 
-    int a = 44;
-    int b = 3;
+    int a[8] = { 5, -20, 30, 0, -10, 10, 11, -11 };
 
-    int r0 = func(0, a, b);
-    int r1 = func(1, a, b);
-    int r2 = func(2, a, b);
-    int r3 = func(3, a, b);
-    int e0 = a + b;
-    int e1 = a - b;
-    int e2 = a * b;
-    int e3 = a / b;
+    int resultRet = func(a, 10);
+    int expectRet = a[2] * 2 + a[2];
 
-    result.setFormat("ret={%d %d %d %d}", r0, r1, r2, r3);
-    expect.setFormat("ret={%d %d %d %d}", e0, e1, e2, e3);
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
 
-    return result.eq(expect);
+    return resultRet == expectRet;
   }
 };
 
 // ============================================================================
-// [X86Test_MiscMultiFunc]
+// [X86Test_MiscCseMerge]
 // ============================================================================
 
-class X86Test_MiscMultiFunc : public X86Test {
+class X86Test_MiscCseMerge : public X86Test {
 public:
-  X86Test_MiscMultiFunc() : X86Test("[Misc] MultiFunc") {}
+  X86Test_MiscCseMerge() : X86Test("[Misc] CseMerge") {}
 
   static void add(X86TestManager& mgr) {
-    mgr.add(new X86Test_MiscMultiFunc());
+    mgr.add(new X86Test_MiscCseMerge());
   }
 
   virtual void compile(X86Compiler& cc) {
-    CCFunc* f1 = cc.newFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
-    CCFunc* f2 = cc.newFunc(FuncSignature2<int, int, int>(CallConv::kIdHost));
-
-    {
-      X86Gp a = cc.newInt32("a");
-      X86Gp b = cc.newInt32("b");
+    cc.insertPass(0, cc.newPassT<X86CsePass>());
+    cc.addFunc(FuncSignature2<void, float*, const float*>(CallConv::kIdHost));
 
-      cc.addFunc(f1);
-      cc.setArg(0, a);
-      cc.setArg(1, b);
-
-      CCFuncCall* call = cc.call(f2->getLabel(), FuncSignature2<int, int, int>(CallConv::kIdHost));
-      call->setArg(0, a);
-      call->setArg(1, b);
-      call->setRet(0, a);
+    X86Gp dst = cc.newIntPtr("dst");
+    X86Gp src = cc.newIntPtr("src");
+    X86Xmm a = cc.newXmm("a");
+    X86Xmm b = cc.newXmm("b");
+    X86Xmm x = cc.newXmm("x");
 
-      cc.ret(a);
-      cc.endFunc();
-    }
+    cc.setArg(0, dst);
+    cc.setArg(1, src);
 
-    {
-      X86Gp a = cc.newInt32("a");
-      X86Gp b = cc.newInt32("b");
+    cc.movups(a, x86::ptr(src));
+    cc.movups(b, x86::ptr(src, 16));
+    cc.movups(x, x86::ptr(src, 32));
 
-      cc.addFunc(f2);
-      cc.setArg(0, a);
-      cc.setArg(1, b);
+    // MOVSS keeps the upper elements of the destination, so the second one
+    // computes a different value than the first one.
+    cc.movss(a, x);
+    cc.movss(b, x);
 
-      cc.add(a, b);
-      cc.ret(a);
-      cc.endFunc();
-    }
+    cc.movups(x86::ptr(dst), a);
+    cc.movups(x86::ptr(dst, 16), b);
+    cc.endFunc();
   }
 
   virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
-    typedef int (*Func)(int, int);
-
+    typedef void (*Func)(float*, const float*);
     Func func = ptr_as_func<Func>(_func);
 
-    int resultRet = func(56, 22);
-    int expectRet = 56 + 22;
+    float src[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    float resultBuf[8] = { 0 };
+    float expectBuf[8] = { 8, 1, 2, 3, 8, 5, 6, 7 };
 
-    result.setFormat("ret=%d", resultRet);
-    expect.setFormat("ret=%d", expectRet);
+    func(resultBuf, src);
+
+    for (uint32_t i = 0; i < 8; i++) {
+      result.appendFormat(i ? " %g" : "%g", resultBuf[i]);
+      expect.appendFormat(i ? " %g" : "%g", expectBuf[i]);
+    }
 
     return result.eq(expect);
   }
 };
 
 // ============================================================================
-// [X86Test_MiscFastEval]
+// [X86Test_MiscProfile]
 // ============================================================================
 
-class X86Test_MiscFastEval : public X86Test {
+class X86Test_MiscProfile : public X86Test {
 public:
-  X86Test_MiscFastEval() : X86Test("[Misc] FastEval (CConv)") {}
+  X86Test_MiscProfile(uint32_t mode)
+    : X86Test(mode == X86ProfilePass::kModeInstrument ? "[Misc] ProfileInstrument" : "[Misc] ProfileLayout"),
+      _mode(mode) {
+    ::memset(_counters, 0, sizeof(_counters));
+
+    // Counters of the function, L_Null, L_Start, L_Loop, L_Pos, and L_Next as
+    // if the function was called 10 times with 3 negative elements in total.
+    if (mode == X86ProfilePass::kModeLayout) {
+      _counters[0] = 10;
+      _counters[2] = 0;
+      _counters[3] = 10;
+      _counters[4] = 80;
+      _counters[5] = 77;
+      _counters[6] = 80;
+    }
+  }
 
   static void add(X86TestManager& mgr) {
-    mgr.add(new X86Test_MiscFastEval());
+    mgr.add(new X86Test_MiscProfile(X86ProfilePass::kModeInstrument));
+    mgr.add(new X86Test_MiscProfile(X86ProfilePass::kModeLayout));
   }
 
   virtual void compile(X86Compiler& cc) {
-    FuncSignature5<void, const void*, const void*, const void*, const void*, void*> funcSig(CallConv::kIdHostCDecl);
-    FuncSignature2<X86Xmm, X86Xmm, X86Xmm> fastSig(CallConv::kIdHostFastEval2);
-
-    CCFunc* func = cc.newFunc(funcSig);
-    CCFunc* fast = cc.newFunc(fastSig);
-
-    {
-      X86Gp aPtr = cc.newIntPtr("aPtr");
-      X86Gp bPtr = cc.newIntPtr("bPtr");
-      X86Gp cPtr = cc.newIntPtr("cPtr");
-      X86Gp dPtr = cc.newIntPtr("dPtr");
-      X86Gp pOut = cc.newIntPtr("pOut");
-
-      X86Xmm aXmm = cc.newXmm("aXmm");
-      X86Xmm bXmm = cc.newXmm("bXmm");
-      X86Xmm cXmm = cc.newXmm("cXmm");
-      X86Xmm dXmm = cc.newXmm("dXmm");
+    cc.insertPass(0, cc.newPassT<X86ProfilePass>(_mode, _counters, 8));
+    cc.addFunc(FuncSignature2<int, const int*, int*>(CallConv::kIdHost));
 
-      cc.addFunc(func);
+    X86Gp src = cc.newIntPtr("src");
+    X86Gp neg = cc.newIntPtr("neg");
+    X86Gp i = cc.newInt32("i");
+    X86Gp x = cc.newInt32("x");
+    X86Gp sum = cc.newInt32("sum");
 
-      cc.setArg(0, aPtr);
-      cc.setArg(1, bPtr);
-      cc.setArg(2, cPtr);
-      cc.setArg(3, dPtr);
-      cc.setArg(4, pOut);
+    Label L_Null = cc.newLabel();
+    Label L_Start = cc.newLabel();
+    Label L_Loop = cc.newLabel();
+    Label L_Pos = cc.newLabel();
+    Label L_Next = cc.newLabel();
 
-      cc.movups(aXmm, x86::ptr(aPtr));
-      cc.movups(bXmm, x86::ptr(bPtr));
-      cc.movups(cXmm, x86::ptr(cPtr));
-      cc.movups(dXmm, x86::ptr(dPtr));
+    cc.setArg(0, src);
+    cc.setArg(1, neg);
+    cc.test(src, src);
+    cc.jz(L_Null);
+    cc.jmp(L_Start);
 
-      X86Xmm xXmm = cc.newXmm("xXmm");
-      X86Xmm yXmm = cc.newXmm("yXmm");
+    cc.bind(L_Null);
+    cc.mov(sum, -1);
+    cc.ret(sum);
 
-      CCFuncCall* call1 = cc.call(fast->getLabel(), fastSig);
-      call1->setArg(0, aXmm);
-      call1->setArg(1, bXmm);
-      call1->setRet(0, xXmm);
+    // Sum of 8 elements, negative elements are counted by '*neg'.
+    cc.bind(L_Start);
+    cc.xor_(sum, sum);
+    cc.mov(i, 8);
 
-      CCFuncCall* call2 = cc.call(fast->getLabel(), fastSig);
-      call2->setArg(0, cXmm);
-      call2->setArg(1, dXmm);
-      call2->setRet(0, yXmm);
+    cc.bind(L_Loop);
+    cc.mov(x, x86::dword_ptr(src));
+    cc.add(sum, x);
+    cc.test(x, x);
+    cc.jns(L_Pos);
+    cc.inc(x86::dword_ptr(neg));
+    cc.jmp(L_Next);
+
+    cc.bind(L_Pos);
+    cc.bind(L_Next);
+    cc.add(src, 4);
+    cc.dec(i);
+    cc.jnz(L_Loop);
+    cc.ret(sum);
 
-      cc.pmullw(xXmm, yXmm);
-      cc.movups(x86::ptr(pOut), xXmm);
+    cc.endFunc();
+  }
 
-      cc.endFunc();
-    }
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(const int*, int*);
+    Func func = ptr_as_func<Func>(_func);
 
-    {
-      X86Xmm aXmm = cc.newXmm("aXmm");
-      X86Xmm bXmm = cc.newXmm("bXmm");
+    int a[8] = { 5, -20, 30, 0, -10, 10, 11, -11 };
+    int neg = 0;
 
-      cc.addFunc(fast);
-      cc.setArg(0, aXmm);
-      cc.setArg(1, bXmm);
-      cc.paddw(aXmm, bXmm);
-      cc.ret(aXmm);
-      cc.endFunc();
-    }
-  }
+    int resultRet = func(a, &neg);
+    int resultNull = func(nullptr, &neg);
 
-  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
-    typedef void (*Func)(const void*, const void*, const void*, const void*, void*);
+    int expectRet = 5 - 20 + 30 + 0 - 10 + 10 + 11 - 11;
+    int expectNull = -1;
 
-    Func func = ptr_as_func<Func>(_func);
+    result.setFormat("ret=%d null=%d neg=%d", resultRet, resultNull, neg);
+    expect.setFormat("ret=%d null=%d neg=%d", expectRet, expectNull, 3);
 
-    int16_t a[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
-    int16_t b[8] = { 7, 6, 5, 4, 3, 2, 1, 0 };
-    int16_t c[8] = { 1, 3, 9, 7, 5, 4, 2, 1 };
-    int16_t d[8] = { 2, 0,-6,-4,-2,-1, 1, 2 };
+    if (_mode == X86ProfilePass::kModeInstrument) {
+      uint32_t i;
+      static const uint64_t expectCounters[8] = { 2, 0, 1, 1, 8, 5, 8, 0 };
 
-    int16_t o[8];
-    int oExp = 7 * 3;
+      result.appendString(" counters=");
+      expect.appendString(" counters=");
 
-    func(a, b, c, d, o);
+      for (i = 0; i < 8; i++) {
+        result.appendFormat("%u ", static_cast<unsigned int>(_counters[i]));
+        expect.appendFormat("%u ", static_cast<unsigned int>(expectCounters[i]));
+      }
 
-    result.setFormat("ret={%02X %02X %02X %02X %02X %02X %02X %02X}", o[0], o[1], o[2], o[3], o[4], o[5], o[6], o[7]);
-    expect.setFormat("ret={%02X %02X %02X %02X %02X %02X %02X %02X}", oExp, oExp, oExp, oExp, oExp, oExp, oExp, oExp);
+      for (i = 0; i < 8; i++)
+        if (_counters[i] != expectCounters[i])
+          return false;
+    }
 
-    return result == expect;
+    return resultRet == expectRet && resultNull == expectNull && neg == 3;
   }
+
+  uint32_t _mode;
+  uint64_t _counters[8];
 };
 
 // ============================================================================
-// [X86Test_MiscUnfollow]
+// [X86Test_MiscProfileRegion]
 // ============================================================================
 
-// Global (I didn't find a better way to test this).
-static jmp_buf globalJmpBuf;
-
-class X86Test_MiscUnfollow : public X86Test {
+class X86Test_MiscProfileRegion : public X86Test {
 public:
-  X86Test_MiscUnfollow() : X86Test("[Misc] Unfollow") {}
+  X86Test_MiscProfileRegion() : X86Test("[Misc] ProfileRegion"), _pass(nullptr) {
+    // Counters of the function and L_T, L_M and L_Done have none. The jump to
+    // L_T is mostly taken, but the code it skips doesn't end at L_T.
+    ::memset(_counters, 0, sizeof(_counters));
+    _counters[0] = 10;
+    _counters[2] = 9;
+  }
 
   static void add(X86TestManager& mgr) {
-    mgr.add(new X86Test_MiscUnfollow());
+    mgr.add(new X86Test_MiscProfileRegion());
   }
 
   virtual void compile(X86Compiler& cc) {
-    // NOTE: Fastcall calling convention is the most appropriate here, as all
-    // arguments will be passed by registers and there won't be any stack
-    // misalignment when we call the `handler()`. This was failing on OSX
-    // when targeting 32-bit.
-    cc.addFunc(FuncSignature2<void, int, void*>(CallConv::kIdHostFastCall));
-
-    X86Gp a = cc.newInt32("a");
-    X86Gp b = cc.newIntPtr("b");
+    _pass = cc.newPassT<X86ProfilePass>(X86ProfilePass::kModeLayout, _counters, 3);
+    cc.insertPass(0, _pass);
+    cc.addFunc(FuncSignature1<int, int>(CallConv::kIdHost));
 
-    Label tramp = cc.newLabel();
+    X86Gp x = cc.newInt32("x");
+    X86Gp r = cc.newInt32("r");
 
-    cc.setArg(0, a);
-    cc.setArg(1, b);
+    Label L_T = cc.newLabel();
+    Label L_M = cc.newLabel();
+    Label L_Done = cc.newLabel();
 
-    cc.cmp(a, 0);
-    cc.jz(tramp);
+    cc.setArg(0, x);
+    cc.test(x, x);
+    cc.jz(L_T);
+    cc.mov(r, 1);
+    cc.jmp(L_Done);
 
-    cc.ret(a);
+    cc.bind(L_M);
+    cc.mov(r, 2);
+    cc.jmp(L_Done);
 
-    cc.bind(tramp);
-    cc.unfollow().jmp(b);
+    cc.bind(L_T);
+    cc.mov(r, 3);
 
+    cc.bind(L_Done);
+    cc.ret(r);
     cc.endFunc();
   }
 
   virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
-    typedef int (ASMJIT_FASTCALL *Func)(int, void*);
-
+    typedef int (*Func)(int);
     Func func = ptr_as_func<Func>(_func);
 
-    int resultRet = 0;
-    int expectRet = 1;
-
-    if (!setjmp(globalJmpBuf))
-      resultRet = func(0, (void*)handler);
-    else
-      resultRet = 1;
+    int resultZero = func(0);
+    int resultOne = func(1);
+    uint32_t inverted = _pass->getInvertedCount();
 
-    result.setFormat("ret={%d}", resultRet);
-    expect.setFormat("ret={%d}", expectRet);
+    result.setFormat("f(0)=%d f(1)=%d inverted=%u", resultZero, resultOne, inverted);
+    expect.setFormat("f(0)=%d f(1)=%d inverted=%u", 3, 1, 0);
 
-    return resultRet == expectRet;
+    return resultZero == 3 && resultOne == 1 && inverted == 0;
   }
 
-  static void ASMJIT_FASTCALL handler() { longjmp(globalJmpBuf, 1); }
+  X86ProfilePass* _pass;
+  uint64_t _counters[3];
 };
 
 // ============================================================================
@@ -3610,6 +5302,8 @@ int main(int argc, char* argv[]) {
   ADD_TEST(X86Test_AllocUseMem);
   ADD_TEST(X86Test_AllocMany1);
   ADD_TEST(X86Test_AllocMany2);
+  ADD_TEST(X86Test_AllocMany3);
+  ADD_TEST(X86Test_AllocCopies);
   ADD_TEST(X86Test_AllocImul1);
   ADD_TEST(X86Test_AllocImul2);
   ADD_TEST(X86Test_AllocIdiv1);
@@ -3633,6 +5327,9 @@ int main(int argc, char* argv[]) {
   ADD_TEST(X86Test_AllocStack2);
   ADD_TEST(X86Test_AllocMemcpy);
   ADD_TEST(X86Test_AllocAlphaBlend);
+  ADD_TEST(X86Test_AllocKRegs);
+  ADD_TEST(X86Test_AllocKRegsMerge);
+  ADD_TEST(X86Test_AllocHighVecRegs);
 
   // Call.
   ADD_TEST(X86Test_CallBase);
@@ -3651,13 +5348,29 @@ int main(int argc, char* argv[]) {
   ADD_TEST(X86Test_CallMisc3);
   ADD_TEST(X86Test_CallMisc4);
   ADD_TEST(X86Test_CallMisc5);
+  ADD_TEST(X86Test_CallTailCall1);
+  ADD_TEST(X86Test_CallTailCall2);
 
   // Misc.
   ADD_TEST(X86Test_MiscConstPool);
+  ADD_TEST(X86Test_MiscConstPool2);
+  ADD_TEST(X86Test_MiscConstLoad);
+  ADD_TEST(X86Test_MiscSharedConst);
+  ADD_TEST(X86Test_MiscCheckpoint);
   ADD_TEST(X86Test_MiscMultiRet);
   ADD_TEST(X86Test_MiscMultiFunc);
   ADD_TEST(X86Test_MiscFastEval);
   ADD_TEST(X86Test_MiscUnfollow);
+  ADD_TEST(X86Test_MiscPeephole);
+  ADD_TEST(X86Test_MiscPeepholeZext);
+  ADD_TEST(X86Test_MiscVexPromotion);
+  ADD_TEST(X86Test_MiscVexPromotionWide);
+  ADD_TEST(X86Test_MiscInline);
+  ADD_TEST(X86Test_MiscLicm);
+  ADD_TEST(X86Test_MiscCse);
+  ADD_TEST(X86Test_MiscCseMerge);
+  ADD_TEST(X86Test_MiscProfile);
+  ADD_TEST(X86Test_MiscProfileRegion);
 
   // Bugs.
   ADD_TEST(X86Test_Bug100);